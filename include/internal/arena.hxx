@@ -0,0 +1,83 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// SPDX-FileCopyrightText: 2026 agent <agent@local>
+// SPDX-FileContributor: Written by agent <agent@local>
+
+#ifndef INTERNAL_ARENA_HXX
+#define INTERNAL_ARENA_HXX
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "rSON.hxx"
+
+// Hands out memory for the parts of a document by bumping a pointer through a few large blocks, which
+// are all freed together when the arena goes. Nothing allocated from it is freed on its own, and objects
+// made in it are never destroyed, so they must not own anything outside the arena. Anything from
+// elsewhere that the parts of a document come to own is instead kept by the arena, and destroyed with it.
+// Blocks double in size as the arena grows, and large blocks are backed by huge pages where the platform
+// supports it.
+struct rSON::internal::arena_t final
+{
+private:
+	struct block_t final
+	{
+		void *memory;
+		size_t length;
+		std::align_val_t alignment;
+	};
+
+	struct kept_t final
+	{
+		void *object;
+		delete_t destroy;
+	};
+
+	std::vector<block_t> blocks{};
+	// The block being allocated from - any after it are left over from before the arena was last reset
+	size_t current{0U};
+	char *next{nullptr};
+	char *end{nullptr};
+	size_t blockSize;
+	// Reading a string as a std::string from several threads at once can keep copies at the same time
+	std::mutex keptLock{};
+	std::vector<kept_t> kept{};
+
+	void *grow(size_t size, size_t alignment);
+	void destroyKept() noexcept;
+
+public:
+	arena_t(size_t sizeHint);
+	arena_t(const arena_t &) = delete;
+	arena_t(arena_t &&) = delete;
+	~arena_t() noexcept;
+	arena_t &operator =(const arena_t &) = delete;
+	arena_t &operator =(arena_t &&) = delete;
+
+	void *allocate(const size_t size, const size_t alignment)
+	{
+		void *result{next};
+		size_t space{size_t(end - next)};
+		if (!std::align(alignment, size, result, space))
+			return grow(size, alignment);
+		next = static_cast<char *>(result) + size;
+		return result;
+	}
+
+	// Forgets everything allocated from the arena and destroys everything it kept, keeping its blocks to
+	// allocate from again. Nothing made in the arena may still be in use.
+	void reset() noexcept;
+	// Copies value into the arena, returning a view of the NUL terminated copy
+	std::string_view copy(std::string_view value);
+	bool owns(const void *memory) const noexcept;
+	// Keeps object until the arena goes, then destroys it with destroy
+	void keep(void *object, delete_t destroy);
+
+	template<typename T, typename... Args> T *make(Args &&...args)
+		{ return ::new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...); }
+};
+
+#endif /*INTERNAL_ARENA_HXX*/
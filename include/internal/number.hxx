@@ -0,0 +1,106 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// SPDX-FileCopyrightText: 2026 agent <agent@local>
+// SPDX-FileContributor: Written by agent <agent@local>
+
+#ifndef INTERNAL_NUMBER_HXX
+#define INTERNAL_NUMBER_HXX
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+// SWAR (SIMD within a register) helpers for handling 8 ASCII digits at a time, in input order
+inline uint64_t loadEightChars(const char *const chars) noexcept
+{
+	uint64_t value{};
+	memcpy(&value, chars, sizeof(value));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	value = __builtin_bswap64(value);
+#endif
+	return value;
+}
+
+// Checks that every byte is in the range '0'-'9' - adding 6 carries any byte above '9' out of the 0x3X range
+inline bool isEightDigits(const uint64_t chars) noexcept
+{
+	return ((chars & 0xF0F0F0F0F0F0F0F0U) |
+		(((chars + 0x0606060606060606U) & 0xF0F0F0F0F0F0F0F0U) >> 4U)) == 0x3333333333333333U;
+}
+
+// Converts 8 digits to their value by combining pairs, then pairs of pairs, then the two halves
+inline uint32_t parseEightDigits(uint64_t chars) noexcept
+{
+	constexpr uint64_t mask{0x000000FF000000FFU};
+	constexpr uint64_t multiplier1{0x000F424000000064U}; // 100 + (1000000 << 32)
+	constexpr uint64_t multiplier2{0x0000271000000001U}; // 1 + (10000 << 32)
+	chars -= 0x3030303030303030U;
+	chars = (chars * 10U) + (chars >> 8U);
+	return uint32_t((((chars & mask) * multiplier1) + (((chars >> 16U) & mask) * multiplier2)) >> 32U);
+}
+
+// A decimal number as read from the input, worth mantissa * 10^exponent. The mantissa holds up to
+// the first 19 significant digits - if there were more than that, truncated is set and digits holds
+// all of them so the value can still be converted exactly.
+struct decimal_t final
+{
+	constexpr static uint32_t maxDigits{19U};
+
+	uint64_t mantissa{0U};
+	int64_t exponent{0};
+	uint32_t significantDigits{0U};
+	bool negative{false};
+	bool truncated{false};
+	std::string digits{};
+
+	// Adds the next digit from the integer (fraction == false) or fractional part of the number
+	void append(const char digit, const bool fraction)
+	{
+		if (!significantDigits && digit == '0')
+		{
+			if (fraction)
+				--exponent;
+		}
+		else if (significantDigits < maxDigits)
+		{
+			mantissa = (mantissa * 10U) + uint8_t(digit - '0');
+			++significantDigits;
+			if (fraction)
+				--exponent;
+		}
+		else
+			appendTruncated(digit, fraction);
+	}
+
+	// Adds the next 8 digits (as loaded by loadEightChars()), returning false if they must be added one by one
+	bool append(const char *const chars, const uint64_t value, const bool fraction)
+	{
+		if (truncated)
+		{
+			digits.append(chars, 8U);
+			if (!fraction)
+				exponent += 8;
+		}
+		// Leading zeros don't count towards the significant digits, so those have to go one at a time
+		else if ((significantDigits || chars[0] != '0') && significantDigits + 8U <= maxDigits)
+		{
+			mantissa = (mantissa * 100000000U) + parseEightDigits(value);
+			significantDigits += 8U;
+			if (fraction)
+				exponent -= 8;
+		}
+		else
+			return false;
+		return true;
+	}
+
+	void appendTruncated(char digit, bool fraction);
+	// Gets the magnitude of the number, returning false if it isn't a whole number that fits in 64 bits
+	bool toMagnitude(uint64_t &result) const noexcept;
+	// Gets the number as an integer, returning false if it can't be represented exactly as one
+	bool toInteger(int64_t &result) const noexcept;
+	// Converts the number to the nearest double, rounding ties to even
+	double toDouble() const;
+};
+
+#endif /*INTERNAL_NUMBER_HXX*/
@@ -5,40 +5,354 @@
 #ifndef INTERNAL_PARSER_HXX
 #define INTERNAL_PARSER_HXX
 
+#include <array>
+#include <map>
 #include <memory>
-#include <queue>
+#include <optional>
+#include <set>
+#include <string>
+#include <string_view>
 #include <system_error>
+#include <vector>
 #include "rSON.hxx"
+#include "structural.hxx"
+#include "number.hxx"
+#include "arena.hxx"
+
+enum class literal_t : uint8_t
+{
+	trueValue,
+	falseValue,
+	nullValue
+};
+
+// A node in the tree of paths selected by a projection_t. A path that ends at a node selects the whole
+// of the value there, otherwise only the members of the value that have nodes of their own are wanted.
+struct rSON::internal::path_t final
+{
+	std::map<std::string, std::unique_ptr<path_t>, std::less<>> children{};
+	// The node for the "*" component, which matches every key and index
+	std::unique_ptr<path_t> wildcard{};
+	bool selected{false};
+
+	const path_t *find(std::string_view key) const noexcept;
+	const path_t *find(size_t index) const noexcept;
+};
+
+// A number as read from the input - integral numbers that can be represented exactly as one are kept as an integer.
+// Those too large for that are kept as a double, and in wideInteger too if they fit in a uint64_t. Hexadecimal,
+// octal and binary literals with their top bit set keep their bit pattern in both integer and wideInteger.
+struct number_t final
+{
+	bool integral;
+	int64_t integer;
+	double value;
+	std::optional<uint64_t> wideInteger{};
+};
+
+// A line and column in the input, both counting from 1, with columns counted in bytes
+struct textPosition_t final
+{
+	size_t line;
+	size_t column;
+};
+
+// How a parser reports a problem with its input - by throwing a JSONParserError, or by keeping the first
+// problem as its status and cutting the input off there so that parsing winds down without unwinding
+enum class errorMode_t : uint8_t
+{
+	throwErrors,
+	keepStatus
+};
 
 typedef struct JSONParser
 {
 private:
-	stream_t &json;
-	char next;
-	bool lastWasComma;
+	// Size of the block of input pulled from the stream in one go
+	constexpr static size_t bufferLength{32768U};
+	// Size from which an in-memory document is worth indexing before parsing it
+	constexpr static size_t indexThreshold{256U};
+	// Exponents beyond this make every number zero or infinite, so they're clamped here
+	constexpr static int64_t maxExponent{100000000000000000};
+
+	// When parsing directly from memory there is no stream and the window is the whole input
+	stream_t *const json;
+	// How much is asked of the stream at once - see readLength()
+	const size_t blockLength;
+	std::unique_ptr<char []> buffer;
+	// The input window - pos is the current character, and pos == end means we're at EOF
+	const char *pos;
+	const char *end;
+	// When parsing from a stream, how far into the input the window starts, how many lines came before
+	// it and where the line it starts part way into began
+	size_t windowOffset;
+	size_t windowLines;
+	size_t windowLineStart;
+	// When parsing directly from memory, the start of the input and its structural index
+	const char *const base;
+	structuralIndex_t structurals;
+	parseLimits_t parseLimits;
+	// In-situ parsing state - whether to borrow strings from the input, and what keeps it alive
+	bool inSitu;
+	std::shared_ptr<const std::string> owner;
+	// Where repeated strings are interned, if anywhere
+	rSON::internal::pool_t *pool;
+	// What the document's nodes are allocated from, if not the heap
+	std::shared_ptr<rSON::internal::arena_t> nodeArena;
+	errorMode_t errorMode;
+	std::optional<JSONParserErrorType> failure;
 
-	void validateUnicodeSequence(std::queue<char> &result);
+	static size_t readLength(const stream_t &stream) noexcept;
+	bool fillBuffer();
 
 public:
-	JSONParser(stream_t &toParse);
-	void nextChar();
+	JSONParser(stream_t &toParse, errorMode_t mode = errorMode_t::throwErrors);
+	JSONParser(stream_t &toParse, std::unique_ptr<char []> &&window, errorMode_t mode = errorMode_t::throwErrors);
+	JSONParser(std::string_view toParse);
+	JSONParser(std::string_view toParse, structuralIndex_t &&index);
+	JSONParser(std::string_view toParse, std::shared_ptr<const std::string> toParseOwner);
+	JSONParser(std::string_view toParse, size_t offset, const structuralIndex_t &index,
+		std::shared_ptr<const std::string> toParseOwner);
+
+	void nextChar()
+	{
+		if (pos == end)
+			return fail(JSON_PARSER_EOF);
+		if (++pos == end)
+			fillBuffer();
+	}
+
+	// Once the input has run out (or been cut off by a failure), this is always '\0', which nothing matches
+	char currentChar()
+	{
+		if (pos == end)
+		{
+			fail(JSON_PARSER_EOF);
+			return '\0';
+		}
+		return *pos;
+	}
+
+	// Reports a problem with the input at the current character, as the error mode calls for
+	void fail(JSONParserErrorType error);
+	bool failed() const noexcept { return failure.has_value(); }
+	std::optional<JSONParserErrorType> error() const noexcept { return failure; }
+	void reportErrors(const errorMode_t mode) noexcept { errorMode = mode; }
+
 	void skipWhite();
+	std::string_view line(std::string &storage);
 	void match(const char x, const bool skip);
-	bool lastTokenComma() const noexcept;
-	void lastNoComma() noexcept;
-	char currentChar();
-	char *literal();
+	const parseLimits_t &limits() const noexcept { return parseLimits; }
+	// Sets the limits to enforce, failing straight away if in-memory input is already too large
+	void limits(const parseLimits_t &newLimits);
+	// The position of the current character in the input
+	size_t offset() const noexcept
+		{ return json ? windowOffset + size_t(pos - buffer.get()) : size_t(pos - base); }
+	// The line and column of the current character, which is slow enough to leave to reporting errors
+	textPosition_t position() const noexcept;
+	const structuralIndex_t &index() const noexcept { return structurals; }
+	// Hands back the input window so it can be used again for other input, after which this parser is done with
+	std::unique_ptr<char []> takeBuffer() noexcept { return std::move(buffer); }
+	// Whether all the input has been consumed
+	bool atEnd() const noexcept { return pos == end; }
+	bool borrowStrings() const noexcept { return inSitu; }
+	void borrowStrings(const bool borrow) noexcept { inSitu = borrow; }
+	const std::shared_ptr<const std::string> &stringOwner() const noexcept { return owner; }
+	rSON::internal::pool_t *stringPool() const noexcept { return pool; }
+	void stringPool(rSON::internal::pool_t *const strings) noexcept { pool = strings; }
+	const std::shared_ptr<rSON::internal::arena_t> &arena() const noexcept { return nodeArena; }
+	void arena(std::shared_ptr<rSON::internal::arena_t> nodes) noexcept { nodeArena = std::move(nodes); }
+	literal_t literal();
+	std::string_view string(std::string &storage, const bool decode);
 	std::string string();
-	size_t number(const bool zeroSpecial, size_t *const decDigits = nullptr);
+	void skipString();
+	// Checks that the string that started at offset start is not too long so far
+	void checkString(const size_t start)
+	{
+		if (offset() - start > parseLimits.maxStringLength)
+			fail(JSON_PARSER_TOO_LARGE);
+	}
+	void skipContainer();
+	void skipValue();
+	void skipNumber();
+	number_t number();
+	void digits(decimal_t &value, const bool fraction);
+	bool prefixedNumber(uint64_t &integer, double &value);
+	int64_t exponent();
 } JSONParser;
 
-std::unique_ptr<JSONAtom> expression(JSONParser &parser, const bool matchComma = true);
+// The state of a documentStream_t between documents - the parser over the input (if it's not empty),
+// somewhere to gather lines read from a stream, and for concatenated documents, the error that stopped
+// the stream
+struct rSON::internal::documents_t final
+{
+	std::optional<JSONParser> parser{};
+	documentFormat_t format{documentFormat_t::lines};
+	std::string line{};
+	std::optional<JSONParserErrorType> error{};
+};
+
+// The state of an arrayStream_t between elements - the parser over the input (if it's not empty),
+// whether the array has been opened or closed yet, how many elements have been read, and any error
+// that has stopped the stream
+struct rSON::internal::elements_t final
+{
+	std::optional<JSONParser> parser{};
+	parseLimits_t limits{};
+	bool started{false};
+	bool finished{false};
+	size_t count{0U};
+	std::optional<JSONParserErrorType> error{};
+};
+
+// The state of a pushParser_t between chunks of input. The grammar is followed a byte at a time, so all of
+// what it expects next, the objects and arrays still open and any string, number or literal part way
+// through being read are kept here until the next chunk arrives. Values are added to the tree as they end.
+struct rSON::internal::push_t final
+{
+	// What the next character of the input may be
+	enum class expect_t : uint8_t
+	{
+		document,
+		value,
+		valueOrEnd,
+		key,
+		keyOrEnd,
+		colon,
+		next,
+		string,
+		number,
+		literal,
+		done
+	};
+
+	// An object or array still being filled in, the key it will be added to its parent under, and how
+	// many members it has had so far
+	struct container_t final
+	{
+		std::unique_ptr<JSONAtom> atom;
+		object_t *object;
+		std::string key;
+		size_t members;
+	};
+
+	parseLimits_t limits{};
+	expect_t expect{expect_t::document};
+	pushStatus_t status{pushStatus_t::needMore};
+	JSONParserErrorType error{JSON_PARSER_BAD_JSON};
+	// How far into the input the parser has got (or where it failed), where the document started,
+	// and how much of the last chunk was used
+	size_t offset{0U};
+	size_t start{0U};
+	size_t used{0U};
+	size_t nodes{0U};
+	std::vector<container_t> stack{};
+	// The string (as written, escapes and all) or number read so far, and for strings, whether it's
+	// a key, whether a backslash was just read and how many hex digits of a unicode escape are to come
+	std::string token{};
+	bool isKey{false};
+	bool escaped{false};
+	uint8_t hexDigits{0U};
+	// For literals, what they are and the rest of the word still to be matched
+	literal_t literal{literal_t::nullValue};
+	std::string_view word{};
+	// The key of the member being read
+	std::string key{};
+	std::unique_ptr<JSONAtom> result{};
+};
+
+// The state of a jsonReader_t - the parser over the document, somewhere to decode strings into, how
+// many members each open object or array has had so far, and how many values have been read in all.
+// When duplicate keys are to be rejected, the keys of the members skipped in each open object are kept too.
+struct rSON::internal::reader_t final
+{
+	JSONParser &parser;
+	std::string storage{};
+	std::vector<size_t> members{};
+	size_t nodes{0U};
+	std::vector<std::set<std::string, std::less<>>> skippedKeys{};
+};
+
+// An object or array still open while parsing - which of the two it is ('{' or '['), and how many
+// members it has had so far
+struct openContainer_t final
+{
+	char kind;
+	size_t members;
+};
+
+// A stack that keeps its first inlineDepth entries in itself, only going to the heap when nested deeper
+template<typename T, size_t inlineDepth> struct inlineStack_t final
+{
+private:
+	std::array<T, inlineDepth> entries{};
+	std::vector<T> spilled{};
+	size_t depth{0U};
+
+public:
+	bool empty() const noexcept { return !depth; }
+	size_t size() const noexcept { return depth; }
+	T &back() noexcept { return depth > inlineDepth ? spilled.back() : entries[depth - 1U]; }
+	void clear() noexcept
+	{
+		spilled.clear();
+		depth = 0U;
+	}
+
+	void push(const T &entry)
+	{
+		if (depth < inlineDepth)
+			entries[depth] = entry;
+		else
+			spilled.push_back(entry);
+		++depth;
+	}
+
+	void pop() noexcept
+	{
+		if (depth-- > inlineDepth)
+			spilled.pop_back();
+	}
+};
+
+// Working space for parsing a document - the containers still open and somewhere to read strings into.
+// Documents nested no deeper than the stack holds inline need nothing from the heap to keep track of
+// that, and keeping this between documents means anything that does spill only has to grow once.
+struct scratch_t final
+{
+	inlineStack_t<openContainer_t, 64U> nesting{};
+	std::string storage{};
+};
+
+// What a parseContext_t keeps between documents - the input window for streams, the structural index
+// for in-memory input, the working space for parsing and the arena the last document was parsed into.
+// Every node below a document's root is made in the arena, so resetting it for the next document is
+// what recycles them. The root itself is freed by whoever holds the document, so it is not recycled.
+struct rSON::internal::context_t final
+{
+	std::unique_ptr<char []> buffer{};
+	structuralIndex_t index{};
+	scratch_t scratch{};
+	std::shared_ptr<rSON::internal::arena_t> arena{};
+};
+
+std::unique_ptr<JSONAtom> document(JSONParser &parser);
+std::unique_ptr<JSONAtom> document(JSONParser &parser, scratch_t &scratch);
+void addMember(JSONParser &parser, rSON::internal::object_t &object, std::string &&key, std::unique_ptr<JSONAtom> &&value,
+	duplicateKeys_t duplicateKeys);
+std::unique_ptr<JSONAtom> value(JSONParser &parser);
+size_t validateValue(JSONParser &parser);
+std::unique_ptr<JSONAtom> lineDocument(std::string_view line, const parseLimits_t &limits);
 inline size_t length(const char *const str) noexcept { return strlen(str) + 1; }
 
 size_t power10(size_t power);
 std::unique_ptr<JSONAtom> object(JSONParser &parser);
 std::unique_ptr<JSONAtom> array(JSONParser &parser);
+std::unique_ptr<JSONAtom> string(JSONParser &parser);
+std::unique_ptr<JSONAtom> string(JSONParser &parser, std::string_view value, std::string &storage);
 std::unique_ptr<JSONAtom> number(JSONParser &parser);
+std::unique_ptr<JSONAtom> number(const number_t &value);
 std::unique_ptr<JSONAtom> literal(JSONParser &parser);
+std::unique_ptr<JSONAtom> literal(literal_t value);
 
 #endif /*INTERNAL_PARSER_HXX*/
@@ -0,0 +1,42 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// SPDX-FileCopyrightText: 2026 agent <agent@local>
+// SPDX-FileContributor: Written by agent <agent@local>
+
+#ifndef INTERNAL_STRUCTURAL_HXX
+#define INTERNAL_STRUCTURAL_HXX
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+
+// A bitmap over an in-memory document marking every structural character ({, }, [, ], :, ,),
+// both quotes of every string and the first character of every number and literal.
+// Nothing inside a string is marked, so the next marked position after any whitespace run
+// outside a string is the next token, and the next marked position after an opening quote is
+// the string's closing quote. Copies share the same bitmap, so the index of a document can be handed
+// on cheaply to anything that goes on to parse part of it.
+struct structuralIndex_t final
+{
+private:
+	std::shared_ptr<uint64_t []> bitmap{};
+	// How many blocks the bitmap has room for, which can be more than are in use when it is reused
+	size_t capacity{0U};
+	size_t blocks{0U};
+	size_t length{0U};
+
+public:
+	structuralIndex_t() noexcept = default;
+	structuralIndex_t(std::string_view json);
+	// Indexes json, reusing the bitmap of reuse if nothing else shares it and it's big enough
+	structuralIndex_t(std::string_view json, structuralIndex_t &&reuse);
+
+	bool valid() const noexcept { return bool(bitmap); }
+	// Returns the first marked position at or after offset, or the document length if there is none
+	size_t next(size_t offset) const noexcept;
+};
+
+// Finds the first quote, backslash or control character in [begin, end), or end if there is none
+const char *findStringSpecial(const char *begin, const char *end) noexcept;
+
+#endif /*INTERNAL_STRUCTURAL_HXX*/
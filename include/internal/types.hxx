@@ -7,42 +7,100 @@
 #ifndef INTERNAL_TYPES_HXX
 #define INTERNAL_TYPES_HXX
 
+#include <atomic>
 #include <string>
 #include <string_view>
 #include <functional>
 #include <map>
+#include <unordered_map>
+#include <variant>
 #include "rSON.hxx"
 
 namespace rSON
 {
 	namespace internal
 	{
+		// Tag type to select construction of a string_t that references, rather than copies, its value
+		struct borrow_t final { };
+		constexpr borrow_t borrow{};
+		// Tag type to select construction of a string_t from a value that has already been unescaped
+		struct unescaped_t final { };
+		constexpr unescaped_t unescaped{};
+
+		// Decodes JSON string escapes to UTF-8 one at a time, pairing up UTF-16 surrogates
+		// that have been escaped separately. A high surrogate that turns out not to have a
+		// low surrogate after it is encoded on its own.
+		struct escapeDecoder_t final
+		{
+		private:
+			uint16_t highSurrogate{0U};
+
+		public:
+			// Enough space for a held back high surrogate followed by any other escape
+			constexpr static size_t maxLength{6U};
+
+			// Decodes the escape whose letter is escape (and, for a unicode escape, whose digits are in hex)
+			// into result, returning the number of bytes written
+			size_t decode(char escape, const char *hex, char *result);
+			// Writes out any high surrogate being held back, returning the number of bytes written
+			size_t flush(char *result) noexcept;
+		};
+
 		struct string_t final
 		{
 		private:
-			std::string string{};
+			// A string referencing the buffer it was parsed from, which owner (if set) keeps alive.
+			// terminated is set when the byte after the string is a NUL, so it can be handed out as a C string.
+			// arena is set for strings made in the arena they were copied into, which are never destroyed.
+			struct borrowed_t final
+			{
+				std::string_view value;
+				std::shared_ptr<const std::string> owner;
+				bool terminated;
+				arena_t *arena{nullptr};
+			};
+
+			std::variant<std::string, borrowed_t> storage{};
+			// The copy of a borrowed string made the first time it's asked for as a std::string. This is
+			// only ever set once, so reading the same string from several threads at once is safe.
+			mutable std::atomic<const std::string *> copy{nullptr};
+
+			const std::string &borrowedValue(const borrowed_t &string) const;
 
 		public:
 			string_t(std::string &&str);
 			string_t(const std::string_view &str);
+			string_t(borrow_t, const std::string_view &str, std::shared_ptr<const std::string> owner = {},
+				bool terminated = false, arena_t *arena = nullptr) noexcept;
+			string_t(unescaped_t, std::string &&str) noexcept;
+			string_t(const string_t &) = delete;
+			string_t(string_t &&) = delete;
+			~string_t() noexcept;
+			string_t &operator =(const string_t &) = delete;
 			string_t &operator =(string_t &&str) noexcept;
-			const std::string &value() const noexcept { return string; }
-			const char *data() const noexcept { return string.data(); }
-			size_t size() const noexcept { return string.size(); }
-			size_t length() const noexcept { return string.length(); }
-			bool operator ==(const string_t &str) const noexcept { return str.value() == string; }
-			bool operator <(const string_t &str) const noexcept { return str.value() < string; }
+			void assign(string_t &&str);
+			const std::string &value() const;
+			const char *c_str() const;
+			std::string_view view() const noexcept;
+			const char *data() const noexcept { return view().data(); }
+			size_t size() const noexcept { return view().size(); }
+			size_t length() const noexcept { return view().length(); }
+			bool borrowed() const noexcept { return std::holds_alternative<borrowed_t>(storage); }
+			// Strings that share storage, such as interned ones, are equal without comparing their contents
+			bool operator ==(const string_t &str) const noexcept
+				{ return (str.data() == data() && str.size() == size()) || str.view() == view(); }
+			bool operator <(const string_t &str) const noexcept { return str.view() < view(); }
 		};
 
 		inline bool operator ==(const string_t &a, const std::string_view &b) noexcept
-			{ return a.value() == b; }
+			{ return a.view() == b; }
 		inline bool operator ==(const std::string_view &a, const string_t &b) noexcept
-			{ return a == b.value(); }
+			{ return a == b.view(); }
 
 		inline bool operator <(const string_t &a, const std::string_view &b) noexcept
-			{ return a.value() < b; }
+			{ return a.view() < b; }
 		inline bool operator <(const std::string_view &a, const string_t &b) noexcept
-			{ return a < b.value(); }
+			{ return a < b.view(); }
 
 		inline bool operator ==(const string_t &a, const char *const b) noexcept
 			{ return a == std::string_view{b, strlen(b)}; }
@@ -54,58 +112,139 @@ namespace rSON
 		inline bool operator <(const char *const a, const string_t &b) noexcept
 			{ return std::string_view{a, strlen(a)} < b; }
 
+		// The strings interned by a stringPool_t, each keyed by a view of its own contents
+		struct pool_t final
+		{
+		private:
+			std::unordered_map<std::string_view, std::shared_ptr<const std::string>> strings{};
+			// Strings any shorter than this fit inside a std::string without an allocation of their own
+			size_t minLength;
+			size_t maxLength;
+
+		public:
+			pool_t(size_t longest);
+			bool interns(const size_t length) const noexcept { return length >= minLength && length <= maxLength; }
+			// Returns the pool's copy of value, adding one if there isn't one yet
+			const std::shared_ptr<const std::string> &intern(std::string_view value);
+			size_t size() const noexcept { return strings.size(); }
+			void clear() noexcept { strings.clear(); }
+		};
+
+		// The members of a container in a lazily parsed document, which are only parsed the first time
+		// the container is looked into
+		struct lazyMembers_t
+		{
+			lazyMembers_t() noexcept = default;
+			lazyMembers_t(const lazyMembers_t &) = delete;
+			lazyMembers_t(lazyMembers_t &&) = delete;
+			virtual ~lazyMembers_t() noexcept = default;
+			lazyMembers_t &operator =(const lazyMembers_t &) = delete;
+			lazyMembers_t &operator =(lazyMembers_t &&) = delete;
+
+			virtual void load(object_t &object) const = 0;
+			virtual void load(array_t &array) const = 0;
+		};
+
 		struct object_t final
 		{
 		private:
-			using holder_t = std::map<std::string, std::unique_ptr<JSONAtom>, std::less<>>;
+			using holder_t = objectMap_t;
 			using list_t = std::vector<const char *>;
-			holder_t children{};
-			list_t mapKeys{};
+			using order_t = std::vector<const char *, allocator_t<const char *>>;
+			// For the root of a document parsed into an arena, what keeps the arena alive
+			std::shared_ptr<const void> storage{};
+			// Loading the members of a lazily parsed object changes nothing observable about it, so
+			// the members may be loaded on first use even through a const object
+			mutable holder_t children{};
+			mutable list_t mapKeys{};
+			// Objects made in an arena track the order of their keys in it, and only copy that out into
+			// mapKeys when asked for it - from then on, the two are kept the same
+			mutable order_t order{};
+			mutable std::unique_ptr<lazyMembers_t> pending{};
+			// Set once an object made in an arena has asked the arena to tear it down
+			mutable bool tornDown{false};
+
+			void loadPending() const;
+			void load() const
+			{
+				if (pending)
+					loadPending();
+			}
+			void adopt(const std::unique_ptr<JSONAtom> &value);
+			void tearDownWithArena() const;
+			static void tearDown(void *object) noexcept;
 
 		public:
 			using iter_t = holder_t::iterator;
 			using constIter_t = holder_t::const_iterator;
 
 			object_t() = default;
+			// Objects made in an arena keep their members in it too, and never delete them
+			object_t(arena_t *const arena) noexcept : children{holder_t::allocator_type{arena}},
+				order{order_t::allocator_type{arena}} { }
+			object_t(std::unique_ptr<lazyMembers_t> &&members) noexcept : pending{std::move(members)} { }
 			void clone(const object_t &object);
+			void keep(std::shared_ptr<const void> memory) noexcept { storage = std::move(memory); }
+			// Lets go of what keeps the arena alive, which for the root of a document frees the whole document
+			void release() noexcept { const auto memory{std::move(storage)}; }
+			arena_t *arena() const noexcept { return children.get_allocator().arena; }
 			JSONAtom *add(std::string &&key, std::unique_ptr<JSONAtom> &&value);
+			JSONAtom *assign(std::string &&key, std::unique_ptr<JSONAtom> &&value);
 			void del(const std::string_view &key);
 			JSONAtom &operator [](const std::string_view &key) const;
-			const list_t &keys() const noexcept { return mapKeys; }
-			bool exists(const std::string_view &key) const noexcept;
-			size_t size() const noexcept { return children.size(); }
-			size_t count() const noexcept { return children.size(); }
-
-			iter_t begin() noexcept { return children.begin(); }
-			constIter_t begin() const noexcept { return children.begin(); }
-			iter_t end() noexcept { return children.end(); }
-			constIter_t end() const noexcept { return children.end(); }
+			const list_t &keys() const;
+			bool exists(const std::string_view &key) const;
+			size_t size() const { load(); return children.size(); }
+			size_t count() const { return size(); }
+
+			iter_t begin() { load(); return children.begin(); }
+			constIter_t begin() const { load(); return children.begin(); }
+			iter_t end() { load(); return children.end(); }
+			constIter_t end() const { load(); return children.end(); }
 		};
 
 		struct array_t final
 		{
 		private:
-			using holder_t = std::vector<std::unique_ptr<JSONAtom>>;
-			holder_t children{};
+			using holder_t = atomList_t;
+			// As for object_t, what keeps the arena of a document parsed into one alive
+			std::shared_ptr<const void> storage{};
+			// As for object_t, the members of a lazily parsed array are loaded on first use
+			mutable holder_t children{};
+			mutable std::unique_ptr<lazyMembers_t> pending{};
+
+			void loadPending() const;
+			void load() const
+			{
+				if (pending)
+					loadPending();
+			}
+			void adopt(const std::unique_ptr<JSONAtom> &value);
 
 		public:
 			using iter_t = holder_t::iterator;
 			using constIter_t = holder_t::const_iterator;
 
 			array_t() = default;
+			// As for object_t, arrays made in an arena keep their members in it too
+			array_t(arena_t *const arena) noexcept : children{holder_t::allocator_type{arena}} { }
+			array_t(std::unique_ptr<lazyMembers_t> &&members) noexcept : pending{std::move(members)} { }
 			void clone(const array_t &array);
+			void keep(std::shared_ptr<const void> memory) noexcept { storage = std::move(memory); }
+			void release() noexcept { const auto memory{std::move(storage)}; }
+			arena_t *arena() const noexcept { return children.get_allocator().arena; }
 			JSONAtom &add(std::unique_ptr<JSONAtom> &&value);
 			void del(const size_t key);
 			void del(const JSONAtom &value);
 			JSONAtom &operator [](const size_t key) const;
-			size_t size() const noexcept { return children.size(); }
-			size_t count() const noexcept { return children.size(); }
-			const JSONAtom *last() const noexcept;
-
-			iter_t begin() noexcept { return children.begin(); }
-			constIter_t begin() const noexcept { return children.begin(); }
-			iter_t end() noexcept { return children.end(); }
-			constIter_t end() const noexcept { return children.end(); }
+			size_t size() const { load(); return children.size(); }
+			size_t count() const { return size(); }
+			const JSONAtom *last() const;
+
+			iter_t begin() { load(); return children.begin(); }
+			constIter_t begin() const { load(); return children.begin(); }
+			iter_t end() { load(); return children.end(); }
+			constIter_t end() const { load(); return children.end(); }
 		};
 
 		template<typename T> inline static void del(void *const object)
@@ -15,14 +15,20 @@
 #include <cstdint>
 #include <cstring>
 #include <memory>
+#include <new>
 #include <vector>
 #include <map>
 #include <exception>
+#include <functional>
+#include <limits>
 #include <stdexcept>
 #include <string>
 #if __cplusplus >= 201703L
+#include <bitset>
 #include <filesystem>
+#include <optional>
 #include <string_view>
+#include <tuple>
 #endif
 #include <type_traits>
 #include <utility>
@@ -119,6 +125,7 @@ namespace rSON
 		off_t seek(const off_t offset, const int whence) noexcept;
 		size_t size() const noexcept { return length; }
 		bool valid() const noexcept { return fd != -1; }
+		int descriptor() const noexcept { return fd; }
 	};
 
 	struct rSON_CLS_API memoryStream_t final : public stream_t
@@ -152,7 +159,10 @@ namespace rSON
 	{
 		JSON_PARSER_EOF,
 		JSON_PARSER_BAD_JSON,
-		JSON_PARSER_BAD_FILE
+		JSON_PARSER_BAD_FILE,
+		JSON_PARSER_TOO_DEEP,
+		JSON_PARSER_TOO_LARGE,
+		JSON_PARSER_DUPLICATE_KEY
 	} JSONParserErrorType;
 
 	typedef enum JSONObjectErrorType
@@ -224,6 +234,15 @@ namespace rSON
 		struct string_t;
 		struct object_t;
 		struct array_t;
+		struct path_t;
+		struct documents_t;
+		struct reader_t;
+		struct pool_t;
+		struct context_t;
+		struct elements_t;
+		struct readAhead_t;
+		struct push_t;
+		struct arena_t;
 
 		template<typename> struct isBoolean_ : std::false_type { };
 		template<> struct isBoolean_<bool> : std::true_type { };
@@ -262,6 +281,30 @@ namespace rSON
 		OpaquePtr &operator =(const OpaquePtr &) = delete;
 	};
 
+	// Reads another stream ahead of whatever is reading from this one, on a background thread, into a ring
+	// of blocks of blockSize bytes each - so the parser has the next block of input ready rather
+	// than waiting on the disk or network each time it runs out. The source must not be touched by
+	// anything else for as long as this stream exists. Errors thrown reading the source are thrown from
+	// read() once everything read before them has been consumed. When the source is a file, the OS is
+	// also told it will be read sequentially so it can read further ahead itself.
+	struct rSON_CLS_API readAheadStream_t final : public stream_t
+	{
+	private:
+		OpaquePtr<internal::readAhead_t> state;
+
+	public:
+		readAheadStream_t(stream_t &source, size_t blockSize = 1U << 20U, size_t blocks = 3U);
+		readAheadStream_t(fileStream_t &source, size_t blockSize = 1U << 20U, size_t blocks = 3U);
+		readAheadStream_t(const readAheadStream_t &) = delete;
+		readAheadStream_t(readAheadStream_t &&) = delete;
+		~readAheadStream_t() noexcept final;
+		readAheadStream_t &operator =(const readAheadStream_t &) = delete;
+		readAheadStream_t &operator =(readAheadStream_t &&) = delete;
+
+		bool read(void *const value, const size_t valueLen, size_t &actualLen) final;
+		bool atEOF() const final;
+	};
+
 	// Hierachy types
 	class JSONString;
 	class JSONObject;
@@ -505,6 +548,8 @@ namespace rSON
 #if __cplusplus >= 201703L
 		JSONString(const std::string_view &value);
 #endif
+		// Adopts an already constructed string implementation, this is used by the parser
+		JSONString(OpaquePtr<internal::string_t> &&value) noexcept;
 		JSONString(const JSONString &value) : JSONString{value.get()} { }
 		~JSONString() override = default;
 		operator const char *() const;
@@ -517,6 +562,10 @@ namespace rSON
 		void set(const std::string_view &value);
 #endif
 		const std::string &get() const noexcept { return *this; }
+#if __cplusplus >= 201703L
+		// Unlike get(), this never copies a string parsed in-situ out of its buffer
+		std::string_view view() const noexcept;
+#endif
 		size_t len() const noexcept;
 		size_t size() const noexcept { return len(); }
 		size_t length() const final;
@@ -545,13 +594,55 @@ namespace rSON
 		void store(stream_t &stream) const final;
 	};
 
+	namespace internal
+	{
+		rSON_API void *allocate(arena_t &arena, size_t size, size_t alignment);
+
+		// Allocates the structures holding the members of objects and arrays, from the arena the document
+		// was parsed into or from the heap if it wasn't parsed into one. Memory from an arena is only given
+		// back when the whole arena is.
+		template<typename T> struct allocator_t
+		{
+			using value_type = T;
+			using propagate_on_container_move_assignment = std::true_type;
+			using propagate_on_container_swap = std::true_type;
+
+			arena_t *arena{nullptr};
+
+			constexpr allocator_t() noexcept = default;
+			constexpr allocator_t(arena_t *const memory) noexcept : arena{memory} { }
+			template<typename U> constexpr allocator_t(const allocator_t<U> &other) noexcept : arena{other.arena} { }
+
+			T *allocate(const size_t count)
+			{
+				if (arena)
+					return static_cast<T *>(internal::allocate(*arena, sizeof(T) * count, alignof(T)));
+				return static_cast<T *>(::operator new(sizeof(T) * count));
+			}
+
+			void deallocate(T *const memory, const size_t) noexcept
+			{
+				if (!arena)
+					::operator delete(memory);
+			}
+		};
+
+		template<typename T, typename U> constexpr bool operator ==(const allocator_t<T> &a,
+			const allocator_t<U> &b) noexcept { return a.arena == b.arena; }
+		template<typename T, typename U> constexpr bool operator !=(const allocator_t<T> &a,
+			const allocator_t<U> &b) noexcept { return a.arena != b.arena; }
+
+		using objectMap_t = std::map<std::string, std::unique_ptr<JSONAtom>, std::less<>,
+			allocator_t<std::pair<const std::string, std::unique_ptr<JSONAtom>>>>;
+		using atomList_t = std::vector<std::unique_ptr<JSONAtom>, allocator_t<std::unique_ptr<JSONAtom>>>;
+	}
+
 	// Iterator type for the contents of a JSONObject, with nice semantics for accessing the objects within
 	class rSON_DEFAULT_VISIBILITY JSONObjectIterator final
 	{
 	private:
-		using objectMap_t = std::map<std::string, std::unique_ptr<JSONAtom>, std::less<>>;
-		using iterator_t = objectMap_t::iterator;
-		using constIterator_t = objectMap_t::const_iterator;
+		using iterator_t = internal::objectMap_t::iterator;
+		using constIterator_t = internal::objectMap_t::const_iterator;
 		constIterator_t item_;
 
 	public:
@@ -587,6 +678,8 @@ namespace rSON
 
 		JSONObject();
 		JSONObject(JSONObject &object);
+		// Adopts an already constructed object implementation, this is used by the parser
+		JSONObject(OpaquePtr<internal::object_t> &&value) noexcept;
 		~JSONObject() override = default;
 
 		bool add(const char *const key, std::unique_ptr<JSONAtom> &&value);
@@ -671,10 +764,10 @@ namespace rSON
 #endif
 		size_t size() const;
 		size_t count() const { return size(); }
-		iterator begin() noexcept;
-		iterator begin() const noexcept;
-		iterator end() noexcept;
-		iterator end() const noexcept;
+		iterator begin();
+		iterator begin() const;
+		iterator end();
+		iterator end() const;
 		size_t length() const final;
 		void store(stream_t &stream) const final;
 	};
@@ -723,6 +816,8 @@ namespace rSON
 
 		JSONArray();
 		JSONArray(JSONArray &array);
+		// Adopts an already constructed array implementation, this is used by the parser
+		JSONArray(OpaquePtr<internal::array_t> &&value) noexcept;
 		~JSONArray() override = default;
 
 		void add(std::unique_ptr<JSONAtom> &&value);
@@ -754,19 +849,601 @@ namespace rSON
 		JSONAtom &operator [](const size_t key) const;
 		size_t size() const;
 		size_t count() const { return size(); }
-		iterator begin() noexcept;
-		iterator begin() const noexcept;
-		iterator end() noexcept;
-		iterator end() const noexcept;
+		iterator begin();
+		iterator begin() const;
+		iterator end();
+		iterator end() const;
 		size_t length() const final;
 		void store(stream_t &stream) const final;
 	};
 
+	// What to do when an object being parsed has more than one member with the same key
+	enum class duplicateKeys_t : uint8_t
+	{
+		// Keep the value of the first member and ignore the rest
+		keepFirst,
+		// Keep the value of the last member, in the place of the first
+		keepLast,
+		// Fail with JSON_PARSER_DUPLICATE_KEY
+		reject
+	};
+
+	// Limits the parser enforces so that hostile or runaway input fails cleanly rather than exhausting resources.
+	// Parsing stops with JSON_PARSER_TOO_LARGE as soon as any of the size limits is exceeded.
+	struct parseLimits_t final
+	{
+		// How deeply objects and arrays may be nested in each other
+		size_t maxDepth{1024U};
+		// How many bytes of input may be read in all
+		size_t maxBytes{SIZE_MAX};
+		// How long any one string or key may be, in bytes as written in the input
+		size_t maxStringLength{SIZE_MAX};
+		// How many members any one object or array may have
+		size_t maxMembers{SIZE_MAX};
+		// How many values, counting objects and arrays themselves, a document may contain
+		size_t maxNodes{SIZE_MAX};
+		duplicateKeys_t duplicateKeys{duplicateKeys_t::keepFirst};
+	};
+
 	rSON_API std::unique_ptr<JSONAtom> parseJSON(stream_t &json);
+	rSON_API std::unique_ptr<JSONAtom> parseJSON(stream_t &json, const parseLimits_t &limits);
 	rSON_API std::unique_ptr<JSONAtom> parseJSON(const char *json);
+	rSON_API std::unique_ptr<JSONAtom> parseJSON(const char *json, const parseLimits_t &limits);
 	rSON_API std::unique_ptr<JSONAtom> parseJSON(const std::string &json);
+	rSON_API std::unique_ptr<JSONAtom> parseJSON(const std::string &json, const parseLimits_t &limits);
 #if __cplusplus >= 201703L
 	rSON_API std::unique_ptr<JSONAtom> parseJSON(std::string_view json);
+	rSON_API std::unique_ptr<JSONAtom> parseJSON(std::string_view json, const parseLimits_t &limits);
+	// In-situ parsing - strings that need no unescaping reference the JSON buffer rather than copying it.
+	// The view and lvalue forms require json to outlive the resulting tree, the rvalue form takes ownership
+	// of the buffer and keeps it alive for as long as any string in the tree refers to it. JSONString::view()
+	// never copies such a string, but as the buffer holds no std::strings or NULs to refer to, asking for one
+	// as a std::string or C string copies it out the first time. That copy is made once and shared, so a
+	// const tree can still be read from multiple threads at once.
+	rSON_API std::unique_ptr<JSONAtom> parseJSONInSitu(std::string_view json);
+	rSON_API std::unique_ptr<JSONAtom> parseJSONInSitu(const std::string &json);
+	rSON_API std::unique_ptr<JSONAtom> parseJSONInSitu(std::string &&json);
+	// Interns repeated strings - values no longer than maxLength that come up more than once while parsing
+	// with the same pool share one immutable copy, as is common for enum-like values in arrays of records.
+	// Strings short enough to be held inside a std::string without allocating are left as they are, as
+	// sharing them would save nothing. A pool can be kept for one document or shared between many, and
+	// the strings interned in it stay valid after the pool is destroyed. A pool must only be used by one
+	// parse at a time, though the documents parsed with it may be read from as many threads as need be.
+	// Object keys are not interned, as JSONObject hands them out as std::strings of their own.
+	struct rSON_CLS_API stringPool_t final
+	{
+	private:
+		OpaquePtr<internal::pool_t> strings;
+
+	public:
+		stringPool_t();
+		stringPool_t(size_t maxLength);
+
+		// How many distinct strings the pool holds
+		size_t size() const noexcept;
+		// Forgets every string in the pool, leaving those already in documents intact
+		void clear() noexcept;
+		internal::pool_t &pool() const noexcept { return strings; }
+	};
+
+	rSON_API std::unique_ptr<JSONAtom> parseJSON(stream_t &json, stringPool_t &strings);
+	rSON_API std::unique_ptr<JSONAtom> parseJSON(stream_t &json, const parseLimits_t &limits, stringPool_t &strings);
+	rSON_API std::unique_ptr<JSONAtom> parseJSON(std::string_view json, stringPool_t &strings);
+	rSON_API std::unique_ptr<JSONAtom> parseJSON(std::string_view json, const parseLimits_t &limits,
+		stringPool_t &strings);
+	// Arena parsing - every part of the document below its root node, including the keys of objects and
+	// the contents of strings, is carved out of a few large blocks that are freed all at once along with the
+	// document rather than each being allocated and freed on its own, so destroying the document takes no
+	// longer for a big one than a small one. Large blocks are backed by huge pages where the platform
+	// supports it. Keys too long to be held inside a std::string still have an allocation of their own, as
+	// do the lists JSONObject::keys() hands out, and objects with either are torn down when the document
+	// goes. Members deleted from or replaced in the document, and the values of its strings read as
+	// std::strings, are kept until the document goes too.
+	rSON_API std::unique_ptr<JSONAtom> parseJSONArena(stream_t &json);
+	rSON_API std::unique_ptr<JSONAtom> parseJSONArena(stream_t &json, const parseLimits_t &limits);
+	rSON_API std::unique_ptr<JSONAtom> parseJSONArena(std::string_view json);
+	rSON_API std::unique_ptr<JSONAtom> parseJSONArena(std::string_view json, const parseLimits_t &limits);
+
+	// Keeps what parsing allocates between documents, for parsing many similar documents one after another.
+	// Documents are parsed into an arena as for parseJSONArena(), and once a document has been destroyed,
+	// the next one parsed is put in the same memory. The input window for streams, the structural index
+	// for in-memory documents and the parser's working space are likewise kept for the next document, so
+	// once a context has parsed a document as big as the next, parsing that makes only one allocation - for
+	// the root node handed back, which is freed like any other - plus any for object keys too long to be
+	// held inside a std::string.
+	// A context, and the documents parsed with it, must only be used from one thread at a time.
+	struct rSON_CLS_API parseContext_t final
+	{
+	private:
+		OpaquePtr<internal::context_t> context;
+
+	public:
+		parseContext_t();
+
+		std::unique_ptr<JSONAtom> parse(stream_t &json);
+		std::unique_ptr<JSONAtom> parse(stream_t &json, const parseLimits_t &limits);
+		std::unique_ptr<JSONAtom> parse(std::string_view json);
+		std::unique_ptr<JSONAtom> parse(std::string_view json, const parseLimits_t &limits);
+	};
+	// Lazy parsing - only the outermost object or array is checked to be complete up front, and each
+	// object and array is parsed the first time it is looked into, so parts of the document that are
+	// never used are only ever skipped over. Errors in those parts are thrown from the first use of
+	// the object or array containing them. Strings are borrowed as for in-situ parsing, so the view
+	// and lvalue forms require json to outlive the resulting tree. As first use alters the tree, a lazily
+	// parsed document must not be used from multiple threads at once, even through const references.
+	rSON_API std::unique_ptr<JSONAtom> parseJSONLazy(std::string_view json);
+	rSON_API std::unique_ptr<JSONAtom> parseJSONLazy(std::string_view json, const parseLimits_t &limits);
+	rSON_API std::unique_ptr<JSONAtom> parseJSONLazy(const std::string &json);
+	rSON_API std::unique_ptr<JSONAtom> parseJSONLazy(std::string &&json);
+	rSON_API std::unique_ptr<JSONAtom> parseJSONLazy(std::string &&json, const parseLimits_t &limits);
+
+	// Receives the parts of a document, in order, as they are read - no tree of JSONAtoms is built.
+	// The string_views passed in are only valid for the duration of the call. Keys and strings are
+	// passed already unescaped. Override only the events of interest, the rest are ignored.
+	struct rSON_CLS_API parseHandler_t
+	{
+	public:
+		parseHandler_t() noexcept = default;
+		parseHandler_t(const parseHandler_t &) = default;
+		parseHandler_t(parseHandler_t &&) = default;
+		virtual ~parseHandler_t() noexcept = default;
+		parseHandler_t &operator =(const parseHandler_t &) = default;
+		parseHandler_t &operator =(parseHandler_t &&) = default;
+
+		virtual void startObject() { }
+		virtual void key(std::string_view) { }
+		virtual void endObject() { }
+		virtual void startArray() { }
+		virtual void endArray() { }
+		virtual void string(std::string_view) { }
+		virtual void integer(int64_t) { }
+		virtual void floatingPoint(double) { }
+		virtual void boolean(bool) { }
+		virtual void null() { }
+	};
+
+	// A set of paths into a document, for parsing only the parts of it that are wanted. Paths are JSON Pointers
+	// (RFC 6901) - "" selects the whole document, "/user/id" the member "id" of the member "user" of the
+	// outermost object, and "/" and "/a/" the members named "" of the outermost object and of "a". Array
+	// elements are selected by index. Keys are matched against how they're written in the document, after
+	// undoing the ~0 and ~1 escapes of "~" and "/". As an extension, a component that is exactly "*" matches
+	// any key or index - "~2" escapes a "*" that is meant literally - and the leading "/" may be left off.
+	struct rSON_CLS_API projection_t final
+	{
+	private:
+		OpaquePtr<internal::path_t> root;
+
+	public:
+		projection_t(const std::vector<std::string_view> &paths);
+		projection_t(std::initializer_list<std::string_view> paths) :
+			projection_t{std::vector<std::string_view>{paths}} { }
+
+		const internal::path_t &paths() const noexcept { return root; }
+	};
+
+	// Projection parsing - only the values the projection selects, and the objects and arrays leading to them,
+	// are built. The rest of the document is skipped over, only checking that brackets match and strings are
+	// terminated. Objects and arrays leading to values that turn out not to exist are left out.
+	rSON_API std::unique_ptr<JSONAtom> parseJSON(stream_t &json, const projection_t &projection);
+	rSON_API std::unique_ptr<JSONAtom> parseJSON(stream_t &json, const projection_t &projection,
+		const parseLimits_t &limits);
+	rSON_API std::unique_ptr<JSONAtom> parseJSON(std::string_view json, const projection_t &projection);
+	rSON_API std::unique_ptr<JSONAtom> parseJSON(std::string_view json, const projection_t &projection,
+		const parseLimits_t &limits);
+
+	// The outcome of validating a document - if it's not valid, why not and the offset of the byte the
+	// problem was found at, otherwise the offset just past the end of the document
+	struct validation_t final
+	{
+		bool valid;
+		JSONParserErrorType error;
+		size_t offset;
+
+		explicit operator bool() const noexcept { return valid; }
+	};
+
+	// Checks a document against the same grammar as parseJSON() without building anything from it. Unlike
+	// parseJSON(), this does not throw on malformed documents - the problem is reported in the result.
+	// Checking a document allocates nothing, unless it's nested more than 64 deep or duplicate keys are
+	// to be rejected - beyond the input window each thread allocates for the first stream it checks.
+	rSON_API validation_t validateJSON(stream_t &json);
+	rSON_API validation_t validateJSON(stream_t &json, const parseLimits_t &limits);
+	rSON_API validation_t validateJSON(std::string_view json);
+	rSON_API validation_t validateJSON(std::string_view json, const parseLimits_t &limits);
+
+	// The outcome of parsing a document without throwing - either the document, or why it's not valid
+	// and where the problem was found, as a byte offset and as a line and column (both counting from 1)
+	struct parseResult_t final
+	{
+		std::unique_ptr<JSONAtom> document{};
+		JSONParserErrorType error{JSON_PARSER_BAD_JSON};
+		size_t offset{0U};
+		size_t line{0U};
+		size_t column{0U};
+
+		explicit operator bool() const noexcept { return bool(document); }
+	};
+
+	// Parses a document as parseJSON() does, but reports malformed documents and failures to read the
+	// stream in the result rather than throwing. Problems with the document are kept by the parser as it
+	// goes rather than thrown, so rejecting a document costs no more than reading up to the problem.
+	// Running out of memory is reported as JSON_PARSER_TOO_LARGE.
+	rSON_API parseResult_t tryParseJSON(stream_t &json) noexcept;
+	rSON_API parseResult_t tryParseJSON(stream_t &json, const parseLimits_t &limits) noexcept;
+	rSON_API parseResult_t tryParseJSON(std::string_view json) noexcept;
+	rSON_API parseResult_t tryParseJSON(std::string_view json, const parseLimits_t &limits) noexcept;
+
+	// Event-driven parsing - if the document turns out to be malformed, the handler will already have
+	// seen the events for everything before the error by the time the JSONParserError is thrown.
+	rSON_API void parseJSON(stream_t &json, parseHandler_t &handler);
+	rSON_API void parseJSON(stream_t &json, parseHandler_t &handler, const parseLimits_t &limits);
+	rSON_API void parseJSON(std::string_view json, parseHandler_t &handler);
+	rSON_API void parseJSON(std::string_view json, parseHandler_t &handler, const parseLimits_t &limits);
+
+	enum class documentFormat_t : uint8_t
+	{
+		// JSON Lines - each document is on a line of its own
+		lines,
+		// Documents simply follow one another, with or without whitespace between them
+		concatenated
+	};
+
+	// Reads one document after another from the same input, such as a log of newline-delimited JSON.
+	// The input is read through once, with anything read past the end of one document carried over
+	// to the next. For JSON Lines, each document must start and end on the same line. A malformed line is
+	// reported by throwing JSONParserError as normal, and the next call carries on from the line after it.
+	struct rSON_CLS_API documentStream_t final
+	{
+	private:
+		OpaquePtr<internal::documents_t> documents;
+
+	public:
+		documentStream_t(stream_t &json, documentFormat_t format = documentFormat_t::lines,
+			const parseLimits_t &limits = {});
+		documentStream_t(std::string_view json, documentFormat_t format = documentFormat_t::lines,
+			const parseLimits_t &limits = {});
+
+		// Parses the next document, returning nullptr once the input is exhausted
+		std::unique_ptr<JSONAtom> next();
+		// How far into the input the next document will be read from
+		size_t offset() const noexcept;
+	};
+
+	// Reads the elements of a document that is one big array, one at a time, so that only the element
+	// being parsed need be held in memory rather than the whole array - such as for a file of records
+	// larger than memory, read through a fileStream_t. Each element is handed back as a standalone
+	// JSONAtom. The limits apply to each element on its own, except for maxBytes, which covers all of the
+	// input, and maxMembers, which caps how many elements the array may have. Once an error has been
+	// thrown, every later call throws it again.
+	struct rSON_CLS_API arrayStream_t final
+	{
+	private:
+		OpaquePtr<internal::elements_t> elements;
+
+	public:
+		arrayStream_t(stream_t &json, const parseLimits_t &limits = {});
+		arrayStream_t(std::string_view json, const parseLimits_t &limits = {});
+
+		// Parses the next element, returning nullptr once the end of the array is reached
+		std::unique_ptr<JSONAtom> next();
+		// How many elements have been read so far
+		size_t count() const noexcept;
+		// How far into the input the next element will be read from
+		size_t offset() const noexcept;
+	};
+
+	// How to go about parsing JSON Lines in parallel. The input is split at newlines into chunks of roughly
+	// chunkSize bytes, which are handed out to threads workers (or one per core if threads is 0). The limits
+	// apply to each line on its own.
+	struct parallelOptions_t final
+	{
+		size_t threads{0U};
+		size_t chunkSize{1U << 20U};
+		parseLimits_t limits{};
+	};
+
+	// Receives each document parsed by the callback forms of parseJSONLines(), along with the offset
+	// into the input its line starts at. Calls come from the worker threads, in no particular order
+	// and possibly several at once, so the handler must be safe to call concurrently.
+	using recordHandler_t = std::function<void (size_t offset, std::unique_ptr<JSONAtom> document)>;
+
+	// Parses JSON Lines across multiple threads. Blank lines are skipped. If any line is malformed, or the
+	// handler throws, the workers stop taking on new chunks and the error for the earliest such line in the
+	// input is thrown once they're done. The vector forms return the documents in input order.
+	rSON_API std::vector<std::unique_ptr<JSONAtom>> parseJSONLines(std::string_view json);
+	rSON_API std::vector<std::unique_ptr<JSONAtom>> parseJSONLines(std::string_view json,
+		const parallelOptions_t &options);
+	rSON_API void parseJSONLines(std::string_view json, const recordHandler_t &handler);
+	rSON_API void parseJSONLines(std::string_view json, const recordHandler_t &handler,
+		const parallelOptions_t &options);
+	// As above, but the input is read a chunk at a time on the calling thread while the workers parse
+	rSON_API void parseJSONLines(stream_t &json, const recordHandler_t &handler);
+	rSON_API void parseJSONLines(stream_t &json, const recordHandler_t &handler, const parallelOptions_t &options);
+
+	// Parses a single large document across multiple threads. A quick pass over the outermost object or array
+	// finds where each of its members starts, then runs of members adding up to roughly chunkSize bytes are
+	// parsed concurrently and put back together in their original order. The limits apply to the whole
+	// document. Documents no bigger than a chunk, or parsed with a limit on the number of values they
+	// may contain, are simply parsed as normal.
+	rSON_API std::unique_ptr<JSONAtom> parseJSON(std::string_view json, const parallelOptions_t &options);
+
+	enum class pushStatus_t : uint8_t
+	{
+		needMore,
+		complete,
+		error
+	};
+
+	// Push-style parser for input that arrives a piece at a time, such as from a non-blocking socket.
+	// The document is parsed as each chunk is fed in, with where the parser got to kept between chunks,
+	// so no call ever blocks waiting for input and malformed input is rejected at the byte it goes wrong.
+	// Only the tree built so far and whatever string or number is part way through are held on to.
+	struct rSON_CLS_API pushParser_t final
+	{
+	private:
+		OpaquePtr<internal::push_t> push;
+
+	public:
+		pushParser_t();
+		pushParser_t(const parseLimits_t &limits);
+
+		// Feeds in the next chunk of input. Anything after the end of the document is left unused,
+		// see consumed(), so it can be fed to the parser again after reset() for the next document.
+		pushStatus_t feed(std::string_view chunk);
+		// Indicates that no more input will arrive, failing if the document is incomplete
+		pushStatus_t finish() noexcept;
+		void reset() noexcept;
+
+		pushStatus_t status() const noexcept;
+		// How many bytes of the last chunk fed in were used
+		size_t consumed() const noexcept;
+		// How far into the input fed in since the last reset() the parser has got, or where the problem
+		// with it was found
+		size_t offset() const noexcept;
+		JSONParserErrorType error() const noexcept;
+		// Hands over the completed document
+		std::unique_ptr<JSONAtom> document() noexcept;
+	};
+
+	// Reads a document a value at a time for the typed binding below. Each value must be read in full,
+	// or skipped, before moving onto the next. Reading a value as the wrong type throws JSONTypeError.
+	class rSON_CLS_API jsonReader_t final
+	{
+	private:
+		internal::reader_t &reader;
+
+	public:
+		jsonReader_t(internal::reader_t &state) noexcept : reader{state} { }
+
+		// The type of the next value - numbers are always reported as JSON_TYPE_INT
+		JSONAtomType type() const;
+		// Reads a null if that's what the next value is, returning whether it was
+		bool null();
+		bool boolean();
+		int64_t integer();
+		// Reads an integer that may be anywhere up to UINT64_MAX, but can't be negative
+		uint64_t unsignedInteger();
+		// Reads a number, integral or not
+		double floatingPoint();
+		std::string string();
+		void beginObject();
+		// Moves onto the next member of the object, returning false once there are no more. The key
+		// is only valid until the member's value is read.
+		bool nextMember(std::string_view &key);
+		void beginArray();
+		// Moves onto the next element of the array, returning false once there are no more
+		bool nextElement();
+		// Skips the next value without decoding it, though it is still checked as thoroughly as parseJSON() would
+		void skip();
+		// Skips the value of a member whose key matches none of the fields. Such keys still count as
+		// duplicates when given more than once in the same object.
+		void skip(std::string_view key);
+		// Deals with a member whose key has already been seen in this object as the limits say duplicate
+		// keys should be, returning whether its value should replace the earlier one rather than be skipped
+		bool replaceDuplicate() const;
+	};
+
+	namespace internal
+	{
+		// FNV-1a, used to match keys against the fields of bound structs
+		constexpr uint64_t hashKey(const std::string_view key) noexcept
+		{
+			uint64_t hash{0xcbf29ce484222325U};
+			for (const auto chr : key)
+			{
+				hash ^= uint8_t(chr);
+				hash *= 0x00000100000001b3U;
+			}
+			return hash;
+		}
+
+		// Reads an integer from the document and narrows it to T, failing if it doesn't fit
+		template<typename T> T readInteger(jsonReader_t &reader)
+		{
+			using limits = std::numeric_limits<T>;
+			if constexpr (std::is_signed<T>::value)
+			{
+				const auto value{reader.integer()};
+				if (value < int64_t{limits::min()} || value > int64_t{limits::max()})
+					throw JSONParserError(JSON_PARSER_TOO_LARGE);
+				return T(value);
+			}
+			else
+			{
+				const auto value{reader.unsignedInteger()};
+				if (value > uint64_t{limits::max()})
+					throw JSONParserError(JSON_PARSER_TOO_LARGE);
+				return T(value);
+			}
+		}
+
+		template<typename> struct isOptional : std::false_type { };
+		template<typename T> struct isOptional<std::optional<T>> : std::true_type { };
+		template<typename> struct isVector : std::false_type { };
+		template<typename T, typename A> struct isVector<std::vector<T, A>> : std::true_type { };
+
+		// What a document is being decoded into, so the parsing itself can live in the library
+		struct rSON_CLS_API bindTarget_t
+		{
+		public:
+			bindTarget_t() noexcept = default;
+			bindTarget_t(const bindTarget_t &) = delete;
+			bindTarget_t(bindTarget_t &&) = delete;
+			virtual ~bindTarget_t() noexcept = default;
+			bindTarget_t &operator =(const bindTarget_t &) = delete;
+			bindTarget_t &operator =(bindTarget_t &&) = delete;
+
+			virtual void read(jsonReader_t &reader) = 0;
+		};
+
+		rSON_API void bindJSON(std::string_view json, bindTarget_t &target, const parseLimits_t &limits);
+		rSON_API void bindJSON(stream_t &json, bindTarget_t &target, const parseLimits_t &limits);
+	}
+
+	// Typed binding - decodes a document straight into C++ types without building a tree of JSONAtoms.
+	// bool, integers, floating point, enums, std::string, std::optional and std::vector are understood,
+	// as are structs that specialise jsonFields_t to list their fields, such as
+	//   template<> struct rSON::jsonFields_t<point_t>
+	//     { constexpr static auto fields{std::make_tuple(rSON_FIELD(point_t, x), rSON_FIELD(point_t, y))}; };
+	// Members whose keys match none of the fields are skipped over without being decoded, though they must
+	// still be valid JSON, and fields missing from the document are left as they were. A field given more
+	// than once in an object is dealt with as the limits say duplicate keys should be, and all of the limits
+	// apply as they do for parseJSON() - including rejecting any other key given more than once, whether
+	// in a bound object or inside a member that is skipped. A number that doesn't fit the integer or enum it's bound to fails
+	// with JSON_PARSER_TOO_LARGE.
+	template<typename T> struct jsonFields_t;
+
+	template<typename T, typename M> struct jsonField_t final
+	{
+		std::string_view name;
+		M T::*member;
+		uint64_t hash;
+	};
+
+	template<typename T, typename M> constexpr jsonField_t<T, M> jsonField(const std::string_view name,
+		M T::*const member) noexcept { return {name, member, internal::hashKey(name)}; }
+
+#define rSON_FIELD(type, field) rSON::jsonField(#field, &type::field)
+
+	template<typename T> void readJSON(jsonReader_t &reader, T &value);
+
+	namespace internal
+	{
+		template<typename T, typename M, size_t N> bool readField(jsonReader_t &reader, T &value,
+			const jsonField_t<T, M> &field, const std::string_view key, const uint64_t hash, std::bitset<N> &seen,
+			const size_t index)
+		{
+			if (field.hash != hash || field.name != key)
+				return false;
+			if (seen[index])
+			{
+				if (!reader.replaceDuplicate())
+				{
+					reader.skip();
+					return true;
+				}
+				// Start afresh so nothing of the earlier value is left behind
+				value.*field.member = M{};
+			}
+			seen.set(index);
+			readJSON(reader, value.*field.member);
+			return true;
+		}
+
+		template<typename T> void readObject(jsonReader_t &reader, T &value)
+		{
+			constexpr auto &fields{jsonFields_t<T>::fields};
+			// Which of the fields have been read from this object so far, to catch any given more than once
+			std::bitset<std::tuple_size<std::decay_t<decltype(fields)>>::value> seen{};
+			reader.beginObject();
+			std::string_view key{};
+			while (reader.nextMember(key))
+			{
+				const auto hash{hashKey(key)};
+				const bool found{std::apply([&](const auto &...field)
+				{
+					size_t index{0U};
+					return (readField(reader, value, field, key, hash, seen, index++) || ...);
+				}, fields)};
+				if (!found)
+					reader.skip(key);
+			}
+		}
+	}
+
+	template<typename T> void readJSON(jsonReader_t &reader, T &value)
+	{
+		if constexpr (std::is_same<T, bool>::value)
+			value = reader.boolean();
+		else if constexpr (std::is_integral<T>::value)
+			value = internal::readInteger<T>(reader);
+		else if constexpr (std::is_floating_point<T>::value)
+			value = T(reader.floatingPoint());
+		else if constexpr (std::is_enum<T>::value)
+			value = T(internal::readInteger<std::underlying_type_t<T>>(reader));
+		else if constexpr (std::is_same<T, std::string>::value)
+			value = reader.string();
+		else if constexpr (internal::isOptional<T>::value)
+		{
+			if (reader.null())
+				value.reset();
+			else
+				readJSON(reader, value.emplace());
+		}
+		else if constexpr (internal::isVector<T>::value)
+		{
+			value.clear();
+			reader.beginArray();
+			while (reader.nextElement())
+			{
+				typename T::value_type element{};
+				readJSON(reader, element);
+				value.push_back(std::move(element));
+			}
+		}
+		else
+			internal::readObject(reader, value);
+	}
+
+	namespace internal
+	{
+		template<typename T> struct boundValue_t final : bindTarget_t
+		{
+		private:
+			T &value;
+
+		public:
+			boundValue_t(T &target) noexcept : value{target} { }
+			void read(jsonReader_t &reader) final { readJSON(reader, value); }
+		};
+	}
+
+	// Decodes the document into value, which must be a struct or std::vector as documents are always
+	// an object or an array
+	template<typename T> void bindJSON(const std::string_view json, T &value, const parseLimits_t &limits)
+	{
+		internal::boundValue_t<T> target{value};
+		internal::bindJSON(json, target, limits);
+	}
+
+	template<typename T> void bindJSON(const std::string_view json, T &value)
+		{ bindJSON(json, value, parseLimits_t{}); }
+
+	template<typename T> void bindJSON(stream_t &json, T &value, const parseLimits_t &limits)
+	{
+		internal::boundValue_t<T> target{value};
+		internal::bindJSON(json, target, limits);
+	}
+
+	template<typename T> void bindJSON(stream_t &json, T &value)
+		{ bindJSON(json, value, parseLimits_t{}); }
+
+	template<typename T> T bindJSON(const std::string_view json)
+	{
+		T value{};
+		bindJSON(json, value, parseLimits_t{});
+		return value;
+	}
 #endif
 
 	rSON_API bool writeJSON(JSONAtomContainer atom, stream_t &stream);
@@ -786,10 +1463,17 @@ namespace rSON
 	constexpr mode_t normalMode{S_IWUSR | S_IRUSR | S_IRGRP | S_IROTH};
 #	endif
 
+	namespace internal
+	{
+		// Parses the whole of file, mapping it into memory rather than reading it through when it's large
+		// enough for that to be worthwhile and the platform supports it
+		rSON_API std::unique_ptr<JSONAtom> parseFile(fileStream_t &file);
+	}
+
 	[[nodiscard]] inline std::unique_ptr<JSONAtom> parseJSON(const std::filesystem::path &fileName)
 	{
 		fileStream_t stream{fileName.c_str(), normalFlags};
-		return rSON::parseJSON(stream);
+		return internal::parseFile(stream);
 	}
 #endif
 }
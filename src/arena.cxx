@@ -0,0 +1,117 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// SPDX-FileCopyrightText: 2026 agent <agent@local>
+// SPDX-FileContributor: Written by agent <agent@local>
+
+#include <cstring>
+#include <algorithm>
+#include "internal/arena.hxx"
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+// The smallest block worth allocating, and the largest the blocks grow to on their own
+constexpr static size_t minBlockSize{4096U};
+constexpr static size_t maxBlockSize{64U << 20U};
+constexpr static size_t hugePageSize{2U << 20U};
+
+using rSON::internal::arena_t;
+
+arena_t::arena_t(const size_t sizeHint) : blockSize{std::clamp(sizeHint, minBlockSize, maxBlockSize)} { }
+
+arena_t::~arena_t() noexcept
+{
+	destroyKept();
+	for (const auto &block : blocks)
+		::operator delete(block.memory, block.alignment);
+}
+
+// Moves on to the next block big enough for the allocation that didn't fit in the last one, reusing the
+// blocks kept when the arena was reset before starting a new one
+void *arena_t::grow(const size_t size, const size_t alignment)
+{
+	while (++current < blocks.size())
+	{
+		const auto &block{blocks[current]};
+		if (block.length >= size + alignment)
+		{
+			next = static_cast<char *>(block.memory);
+			end = next + block.length;
+			return allocate(size, alignment);
+		}
+	}
+
+	auto length{std::max(blockSize, size + alignment)};
+	auto blockAlignment{std::align_val_t{alignof(std::max_align_t)}};
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+	const bool hugePages{length >= hugePageSize};
+	if (hugePages)
+	{
+		length = (length + hugePageSize - 1U) & ~(hugePageSize - 1U);
+		blockAlignment = std::align_val_t{hugePageSize};
+	}
+#endif
+	blocks.reserve(blocks.size() + 1U);
+	auto *const memory{static_cast<char *>(::operator new(length, blockAlignment))};
+	blocks.push_back({memory, length, blockAlignment});
+	current = blocks.size() - 1U;
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+	// This is only advice, so if the kernel won't take it the block is simply backed by normal pages
+	if (hugePages)
+		madvise(memory, length, MADV_HUGEPAGE);
+#endif
+	next = memory;
+	end = memory + length;
+	blockSize = std::min(blockSize * 2U, maxBlockSize);
+	return allocate(size, alignment);
+}
+
+// Documents parsed into the same arena one after another tend to be much the same size, so every block
+// is kept for the next, which then needs nothing more from the heap
+void arena_t::reset() noexcept
+{
+	destroyKept();
+	current = 0U;
+	if (blocks.empty())
+		return;
+	next = static_cast<char *>(blocks.front().memory);
+	end = next + blocks.front().length;
+}
+
+// The copy is NUL terminated so it can also be handed out as a C string
+std::string_view arena_t::copy(const std::string_view value)
+{
+	if (value.empty())
+		return {""};
+	auto *const result{static_cast<char *>(allocate(value.length() + 1U, 1U))};
+	std::memcpy(result, value.data(), value.length());
+	result[value.length()] = '\0';
+	return {result, value.length()};
+}
+
+// The most recent block is checked first, as that's the one anything just made in the arena is in
+bool arena_t::owns(const void *const memory) const noexcept
+{
+	const auto *const address{static_cast<const char *>(memory)};
+	return std::any_of(blocks.rbegin(), blocks.rend(), [&](const block_t &block) noexcept
+	{
+		const auto *const begin{static_cast<const char *>(block.memory)};
+		return address >= begin && address < begin + block.length;
+	});
+}
+
+void arena_t::keep(void *const object, const delete_t destroy)
+{
+	std::lock_guard<std::mutex> lock{keptLock};
+	kept.push_back({object, destroy});
+}
+
+void arena_t::destroyKept() noexcept
+{
+	for (const auto &object : kept)
+		object.destroy(object.object);
+	kept.clear();
+}
+
+void *rSON::internal::allocate(arena_t &arena, const size_t size, const size_t alignment)
+	{ return arena.allocate(size, alignment); }
@@ -0,0 +1,246 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// SPDX-FileCopyrightText: 2026 agent <agent@local>
+// SPDX-FileContributor: Written by agent <agent@local>
+
+#include <cmath>
+#include "internal/types.hxx"
+#include "internal/parser.hxx"
+
+inline bool isNumberStart(const char chr) noexcept { return chr == '-' || (chr >= '0' && chr <= '9'); }
+
+// Counts another value read from the document against the node limit
+void countNode(reader_t &reader)
+{
+	if (++reader.nodes > reader.parser.limits().maxNodes)
+		throw JSONParserError(JSON_PARSER_TOO_LARGE);
+}
+
+JSONAtomType jsonReader_t::type() const
+{
+	const auto chr{reader.parser.currentChar()};
+	switch (chr)
+	{
+		case '{':
+			return JSON_TYPE_OBJECT;
+		case '[':
+			return JSON_TYPE_ARRAY;
+		case '"':
+			return JSON_TYPE_STRING;
+		case 't':
+		case 'f':
+			return JSON_TYPE_BOOL;
+		case 'n':
+			return JSON_TYPE_NULL;
+		default:
+			if (isNumberStart(chr))
+				return JSON_TYPE_INT;
+	}
+	throw JSONParserError(JSON_PARSER_BAD_JSON);
+}
+
+bool jsonReader_t::null()
+{
+	if (reader.parser.currentChar() != 'n')
+		return false;
+	countNode(reader);
+	// Any other literal starting with 'n' is malformed, which literal() deals with
+	reader.parser.literal();
+	return true;
+}
+
+bool jsonReader_t::boolean()
+{
+	const auto chr{reader.parser.currentChar()};
+	if (chr != 't' && chr != 'f')
+		throw JSONTypeError(type(), JSON_TYPE_BOOL);
+	countNode(reader);
+	return reader.parser.literal() == literal_t::trueValue;
+}
+
+// Fails on a number that couldn't be kept as an integer - if it's beyond limit it's too large for any
+// integer it could be bound to, otherwise it's simply not an integer
+[[noreturn]] void notInteger(const number_t &value, const double limit)
+{
+	if (std::fabs(value.value) >= limit)
+		throw JSONParserError(JSON_PARSER_TOO_LARGE);
+	throw JSONTypeError(JSON_TYPE_FLOAT, JSON_TYPE_INT);
+}
+
+number_t readInteger(reader_t &reader, const jsonReader_t &jsonReader)
+{
+	if (!isNumberStart(reader.parser.currentChar()))
+		throw JSONTypeError(jsonReader.type(), JSON_TYPE_INT);
+	countNode(reader);
+	return reader.parser.number();
+}
+
+int64_t jsonReader_t::integer()
+{
+	const auto value{readInteger(reader, *this)};
+	if (!value.integral)
+		notInteger(value, 0x1p63);
+	return value.integer;
+}
+
+// Integers between INT64_MAX and UINT64_MAX are only ever kept exactly in wideInteger
+uint64_t jsonReader_t::unsignedInteger()
+{
+	const auto value{readInteger(reader, *this)};
+	if (value.wideInteger)
+		return *value.wideInteger;
+	if (!value.integral)
+		notInteger(value, 0x1p64);
+	if (value.integer < 0)
+		throw JSONParserError(JSON_PARSER_TOO_LARGE);
+	return uint64_t(value.integer);
+}
+
+double jsonReader_t::floatingPoint()
+{
+	if (!isNumberStart(reader.parser.currentChar()))
+		throw JSONTypeError(type(), JSON_TYPE_FLOAT);
+	countNode(reader);
+	const auto value{reader.parser.number()};
+	return value.integral ? double(value.integer) : value.value;
+}
+
+std::string jsonReader_t::string()
+{
+	if (reader.parser.currentChar() != '"')
+		throw JSONTypeError(type(), JSON_TYPE_STRING);
+	countNode(reader);
+	reader.storage.clear();
+	const auto value{reader.parser.string(reader.storage, true)};
+	// Take over the decoded copy if there is one rather than copying it again
+	if (value.data() == reader.storage.data())
+		return std::move(reader.storage);
+	return std::string{value};
+}
+
+void jsonReader_t::beginObject()
+{
+	if (reader.parser.currentChar() != '{')
+		throw JSONTypeError(type(), JSON_TYPE_OBJECT);
+	if (reader.members.size() >= reader.parser.limits().maxDepth)
+		throw JSONParserError(JSON_PARSER_TOO_DEEP);
+	countNode(reader);
+	reader.parser.match('{', true);
+	reader.members.push_back(0U);
+	if (reader.parser.limits().duplicateKeys == duplicateKeys_t::reject)
+		reader.skippedKeys.emplace_back();
+}
+
+bool jsonReader_t::nextMember(std::string_view &key)
+{
+	auto &parser{reader.parser};
+	auto &members{reader.members.back()};
+	// After the first member, either another follows or the object ends
+	if (members && parser.currentChar() == ',')
+		parser.match(',', true);
+	else if (members || parser.currentChar() == '}')
+	{
+		// Like document(), leave whatever follows the outermost container alone
+		parser.match('}', reader.members.size() > 1U);
+		reader.members.pop_back();
+		if (parser.limits().duplicateKeys == duplicateKeys_t::reject)
+			reader.skippedKeys.pop_back();
+		return false;
+	}
+	if (++members > parser.limits().maxMembers)
+		throw JSONParserError(JSON_PARSER_TOO_LARGE);
+	reader.storage.clear();
+	key = parser.string(reader.storage, true);
+	parser.match(':', true);
+	return true;
+}
+
+void jsonReader_t::beginArray()
+{
+	if (reader.parser.currentChar() != '[')
+		throw JSONTypeError(type(), JSON_TYPE_ARRAY);
+	if (reader.members.size() >= reader.parser.limits().maxDepth)
+		throw JSONParserError(JSON_PARSER_TOO_DEEP);
+	countNode(reader);
+	reader.parser.match('[', true);
+	reader.members.push_back(0U);
+}
+
+bool jsonReader_t::nextElement()
+{
+	auto &parser{reader.parser};
+	auto &elements{reader.members.back()};
+	if (elements && parser.currentChar() == ',')
+		parser.match(',', true);
+	else if (elements || parser.currentChar() == ']')
+	{
+		parser.match(']', reader.members.size() > 1U);
+		reader.members.pop_back();
+		return false;
+	}
+	if (++elements > parser.limits().maxMembers)
+		throw JSONParserError(JSON_PARSER_TOO_LARGE);
+	return true;
+}
+
+bool jsonReader_t::replaceDuplicate() const
+{
+	switch (reader.parser.limits().duplicateKeys)
+	{
+		case duplicateKeys_t::keepLast:
+			return true;
+		case duplicateKeys_t::reject:
+			throw JSONParserError(JSON_PARSER_DUPLICATE_KEY);
+		default:
+			return false;
+	}
+}
+
+void jsonReader_t::skip()
+{
+	auto &parser{reader.parser};
+	// The skipped value is checked in full, and may only nest as deeply and hold as many values
+	// as is left of the limits at this point
+	const auto limits{parser.limits()};
+	auto skipLimits{limits};
+	skipLimits.maxDepth -= reader.members.size();
+	skipLimits.maxNodes -= reader.nodes;
+	parser.limits(skipLimits);
+	reader.nodes += validateValue(parser);
+	parser.limits(limits);
+	parser.skipWhite();
+}
+
+void jsonReader_t::skip(const std::string_view key)
+{
+	if (reader.parser.limits().duplicateKeys == duplicateKeys_t::reject &&
+		!reader.skippedKeys.back().emplace(key).second)
+		throw JSONParserError(JSON_PARSER_DUPLICATE_KEY);
+	skip();
+}
+
+// Decodes the document into target, which like any other document must be an object or an array
+void bind(JSONParser &parser, bindTarget_t &target)
+{
+	const auto chr{parser.currentChar()};
+	if (chr != '{' && chr != '[')
+		throw JSONParserError(JSON_PARSER_BAD_JSON);
+	reader_t state{parser};
+	jsonReader_t reader{state};
+	target.read(reader);
+}
+
+void rSON::internal::bindJSON(const std::string_view json, bindTarget_t &target, const parseLimits_t &limits)
+{
+	JSONParser parser{json};
+	parser.limits(limits);
+	bind(parser, target);
+}
+
+void rSON::internal::bindJSON(stream_t &json, bindTarget_t &target, const parseLimits_t &limits) try
+{
+	JSONParser parser{json};
+	parser.limits(limits);
+	bind(parser, target);
+	json.readSync();
+}
+catch (...) { json.readSync(); throw; }
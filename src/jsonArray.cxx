@@ -6,6 +6,7 @@
 
 #include <algorithm>
 #include "internal/types.hxx"
+#include "internal/arena.hxx"
 #include "internal/string.hxx"
 
 #if !defined(_MSC_VER) || _MSC_VER >= 1928
@@ -17,6 +18,17 @@ JSONArray::JSONArray() : JSONAtom{JSON_TYPE_ARRAY}, arr{} {}
 JSONArray::JSONArray(JSONArray &array) : JSONArray{}
 	{ arr->clone(*array.arr); }
 
+JSONArray::JSONArray(OpaquePtr<array_t> &&value) noexcept : JSONAtom{JSON_TYPE_ARRAY}, arr{std::move(value)} { }
+
+// Parses the members of a lazily parsed array, leaving it as it was if they turn out to be malformed
+void array_t::loadPending() const
+{
+	array_t loaded{};
+	pending->load(loaded);
+	children = std::move(loaded.children);
+	pending.reset();
+}
+
 void array_t::clone(const array_t &array)
 {
 	for (const auto &atom : array)
@@ -46,32 +58,54 @@ void array_t::clone(const array_t &array)
 	}
 }
 
+// As for object_t, members of an array made in an arena that weren't made in it are deleted with the arena
+void array_t::adopt(const std::unique_ptr<JSONAtom> &value)
+{
+	if (auto *const memory{arena()}; memory && !memory->owns(value.get()))
+		memory->keep(value.get(), internal::del<JSONAtom>);
+}
+
 JSONAtom &array_t::add(std::unique_ptr<JSONAtom> &&value)
-	{ return *children.emplace_back(std::move(value)); }
+{
+	load();
+	const auto &result{children.emplace_back(std::move(value))};
+	adopt(result);
+	return *result;
+}
 
 void array_t::del(const size_t key)
 {
+	load();
 	if (key >= children.size())
 		throw JSONArrayError{JSON_ARRAY_OOB};
+	if (arena())
+		children[key].release();
 	children.erase(children.begin() + key);
 }
 
 void array_t::del(const JSONAtom &value)
 {
+	load();
 	const auto &atom = std::find_if(children.begin(), children.end(),
 		[&](const std::unique_ptr<JSONAtom> &atom) -> bool { return atom.get() == &value; });
+	if (arena() && atom != children.end())
+		atom->release();
 	children.erase(atom);
 }
 
 JSONAtom &array_t::operator [](const size_t key) const
 {
+	load();
 	if (key >= children.size())
 		throw JSONArrayError{JSON_ARRAY_OOB};
 	return *children[key];
 }
 
-const JSONAtom *array_t::last() const noexcept
-	{ return children.empty() ? nullptr : children.back().get(); }
+const JSONAtom *array_t::last() const
+{
+	load();
+	return children.empty() ? nullptr : children.back().get();
+}
 
 void JSONArray::add(std::unique_ptr<JSONAtom> &&value)
 	{ arr->add(std::move(value)); }
@@ -89,7 +123,7 @@ void JSONArray::del(const JSONAtom &value) { arr->del(value); }
 JSONAtom &JSONArray::operator [](const size_t key) const { return (*arr)[key]; }
 size_t JSONArray::size() const { return arr->size(); }
 
-JSONArray::iterator JSONArray::begin() noexcept
+JSONArray::iterator JSONArray::begin()
 {
 	// This must be a lambda otherwise constexpr evaluation of the pointer check fails
 	return [&]()
@@ -102,7 +136,7 @@ JSONArray::iterator JSONArray::begin() noexcept
 	}();
 }
 
-JSONArray::iterator JSONArray::begin() const noexcept
+JSONArray::iterator JSONArray::begin() const
 {
 	// This must be a lambda otherwise constexpr evaluation of the pointer check fails
 	return [&]()
@@ -115,7 +149,7 @@ JSONArray::iterator JSONArray::begin() const noexcept
 	}();
 }
 
-JSONArray::iterator JSONArray::end() noexcept
+JSONArray::iterator JSONArray::end()
 {
 	// This must be a lambda otherwise constexpr evaluation of the pointer check fails
 	return [&]()
@@ -128,7 +162,7 @@ JSONArray::iterator JSONArray::end() noexcept
 	}();
 }
 
-JSONArray::iterator JSONArray::end() const noexcept
+JSONArray::iterator JSONArray::end() const
 {
 	// This must be a lambda otherwise constexpr evaluation of the pointer check fails
 	return [&]()
@@ -17,6 +17,12 @@ const char *JSONParserError::error() const noexcept
 			return "The JSON parser has determined it was fed with bad JSON";
 		case JSON_PARSER_BAD_FILE:
 			return "The JSON parser could not read the file it was asked to parse";
+		case JSON_PARSER_TOO_DEEP:
+			return "The JSON parser found objects and arrays nested deeper than it was allowed to go";
+		case JSON_PARSER_TOO_LARGE:
+			return "The JSON parser found more data than it was allowed to read";
+		case JSON_PARSER_DUPLICATE_KEY:
+			return "The JSON parser found an object with the same key more than once";
 		default:
 			break;
 	}
@@ -6,6 +6,7 @@
 
 #include <algorithm>
 #include "internal/types.hxx"
+#include "internal/arena.hxx"
 #include "internal/string.hxx"
 
 #if !defined(_MSC_VER) || _MSC_VER >= 1928
@@ -17,6 +18,19 @@ JSONObject::JSONObject() : JSONAtom{JSON_TYPE_OBJECT}, obj{} { }
 JSONObject::JSONObject(JSONObject &object) : JSONObject{}
 	{ obj->clone(*object.obj); }
 
+JSONObject::JSONObject(OpaquePtr<object_t> &&value) noexcept : JSONAtom{JSON_TYPE_OBJECT}, obj{std::move(value)} { }
+
+// Parses the members of a lazily parsed object. They're parsed into a separate object first so that if
+// they turn out to be malformed, this one is left as it was and every later use reports the same error.
+void object_t::loadPending() const
+{
+	object_t loaded{};
+	pending->load(loaded);
+	children = std::move(loaded.children);
+	mapKeys = std::move(loaded.mapKeys);
+	pending.reset();
+}
+
 void object_t::clone(const object_t &object)
 {
 	for (const auto &[key, atom] : object)
@@ -46,43 +60,121 @@ void object_t::clone(const object_t &object)
 	}
 }
 
+// The members of an object made in an arena are never deleted, so any member that wasn't made in the
+// arena along with the object is handed to the arena to delete when it goes
+void object_t::adopt(const std::unique_ptr<JSONAtom> &value)
+{
+	if (auto *const memory{arena()}; memory && !memory->owns(value.get()))
+		memory->keep(value.get(), internal::del<JSONAtom>);
+}
+
+// Objects made in an arena are never destroyed, which leaves nothing behind so long as everything they hold
+// is in the arena too. Keys too long to be held inside a std::string, and the list keys() hands out, are
+// not - so an object made in an arena that comes to have either asks the arena to tear it down when it goes.
+void object_t::tearDownWithArena() const
+{
+	if (auto *const memory{arena()}; memory && !tornDown)
+	{
+		memory->keep(const_cast<object_t *>(this), tearDown);
+		tornDown = true;
+	}
+}
+
+// The members are either in the arena or kept by it, so they're let go of rather than deleted
+void object_t::tearDown(void *const object) noexcept
+{
+	auto *const self{static_cast<object_t *>(object)};
+	for (auto &member : self->children)
+		member.second.release();
+	self->~object_t();
+}
+
+// Adds the member if there isn't one by that name already. If there is, neither key nor value is taken.
 JSONAtom *object_t::add(std::string &&key, std::unique_ptr<JSONAtom> &&value)
 {
-	if (children.find(key) != children.end())
+	load();
+	const auto result{children.try_emplace(std::move(key), std::move(value))};
+	if (!result.second)
 		return nullptr;
-	const auto result{children.emplace(std::move(key), std::move(value))};
-	if (result.second)
+	adopt(result.first->second);
+	const auto &memberKey{result.first->first};
+	if (!arena())
+		mapKeys.push_back(memberKey.c_str());
+	else
 	{
-		mapKeys.push_back(result.first->first.c_str());
-		return result.first->second.get();
+		if (memberKey.capacity() > std::string{}.capacity())
+			tearDownWithArena();
+		order.push_back(memberKey.c_str());
+		if (!mapKeys.empty())
+			mapKeys.push_back(memberKey.c_str());
 	}
-	return nullptr;
+	return result.first->second.get();
+}
+
+// Adds the member, or if there is one by that name already, replaces its value
+JSONAtom *object_t::assign(std::string &&key, std::unique_ptr<JSONAtom> &&value)
+{
+	load();
+	const auto member{children.find(key)};
+	if (member == children.end())
+		return add(std::move(key), std::move(value));
+	if (arena())
+		member->second.release();
+	member->second = std::move(value);
+	adopt(member->second);
+	return member->second.get();
 }
 
 void object_t::del(const std::string_view &key)
 {
 	if (key.empty())
 		return;
+	load();
 	const auto &atom = children.find(key);
 	if (atom != children.end())
 	{
-		const auto &atomKey = std::find_if(mapKeys.begin(), mapKeys.end(),
-			[&](const std::string_view atom) -> bool { return key == atom; });
-		mapKeys.erase(atomKey);
+		const auto erase = [&](auto &keys)
+		{
+			const auto &atomKey = std::find_if(keys.begin(), keys.end(),
+				[&](const std::string_view atom) -> bool { return key == atom; });
+			if (atomKey != keys.end())
+				keys.erase(atomKey);
+		};
+		erase(mapKeys);
+		if (arena())
+		{
+			erase(order);
+			atom->second.release();
+		}
 		children.erase(atom);
 	}
 }
 
 JSONAtom &object_t::operator [](const std::string_view &key) const
 {
+	load();
 	const auto &node = children.find(key);
 	if (node == children.end())
 		throw JSONObjectError(JSON_OBJECT_BAD_KEY);
 	return *node->second;
 }
 
-bool object_t::exists(const std::string_view &key) const noexcept
-	{ return children.find(key) != children.end(); }
+const std::vector<const char *> &object_t::keys() const
+{
+	load();
+	if (arena() && mapKeys.size() != order.size())
+	{
+		tearDownWithArena();
+		mapKeys.assign(order.begin(), order.end());
+	}
+	return mapKeys;
+}
+
+bool object_t::exists(const std::string_view &key) const
+{
+	load();
+	return children.find(key) != children.end();
+}
 
 bool JSONObject::add(const char *const key, std::unique_ptr<JSONAtom> &&value)
 	{ return obj->add(key, std::move(value)); }
@@ -128,10 +220,10 @@ bool JSONObject::exists(const std::string &key) const
 bool JSONObject::exists(const std::string_view key) const
 	{ return obj->exists(key); }
 size_t JSONObject::size() const { return obj->size(); }
-JSONObject::iterator JSONObject::begin() noexcept { return obj->begin(); }
-JSONObject::iterator JSONObject::begin() const noexcept { return obj->begin(); }
-JSONObject::iterator JSONObject::end() noexcept { return obj->end(); }
-JSONObject::iterator JSONObject::end() const noexcept { return obj->end(); }
+JSONObject::iterator JSONObject::begin() { return obj->begin(); }
+JSONObject::iterator JSONObject::begin() const { return obj->begin(); }
+JSONObject::iterator JSONObject::end() { return obj->end(); }
+JSONObject::iterator JSONObject::end() const { return obj->end(); }
 
 bool JSONObject::add(const char *const key, std::nullptr_t)
 	{ return obj->add(key, std::make_unique<JSONNull>()); }
@@ -5,9 +5,11 @@
 // SPDX-FileContributor: Modified by Amyspark <amy@amyspark.me>
 
 #include <stdio.h>
+#include <string.h>
 #include <ctype.h>
 #include <utility>
 #include "internal/types.hxx"
+#include "internal/arena.hxx"
 
 uint8_t hex2int(char c)
 {
@@ -23,50 +25,105 @@ uint8_t hex2int(char c)
 		throw JSONParserError(JSON_PARSER_BAD_JSON);
 }
 
-void writeValue(const uint8_t *&readPos, uint8_t *&writePos, const char value)
+// Encodes a code point as UTF-8. NUL is encoded as an overlong pair so it never terminates a string early
+size_t encodeUTF8(const uint32_t codePoint, char *const result) noexcept
 {
-	*writePos = value;
-	++readPos;
-	++writePos;
-}
-
-void parseUnicode(const uint8_t *&readPos, uint8_t *&writePos)
-{
-	uint8_t i;
-	uint16_t charVal = 0;
-	for (i = 1; i < 5; i++)
+	if (codePoint == 0U)
 	{
-		charVal <<= 4;
-		charVal += hex2int(readPos[i]);
+		result[0] = char(0xC0U);
+		result[1] = char(0x80U);
+		return 2;
 	}
-	readPos += 5;
-	if (charVal == 0x0000)
+	else if (codePoint <= 0x7FU)
 	{
-		writePos[0] = 0xC0;
-		writePos[1] = 0x80;
-		writePos += 2;
+		result[0] = char(codePoint);
+		return 1;
 	}
-	else if (charVal <= 0x007F)
+	else if (codePoint <= 0x7FFU)
 	{
-		writePos[0] = charVal & 0x7F;
-		writePos++;
+		result[0] = char(0xC0U | (codePoint >> 6U));
+		result[1] = char(0x80U | (codePoint & 0x3FU));
+		return 2;
 	}
-	else if (charVal <= 0x07FF)
+	else if (codePoint <= 0xFFFFU)
 	{
-		writePos[1] = 0x80 | (charVal & 0x3F);
-		charVal >>= 6;
-		writePos[0] = 0xC0 | (charVal & 0x1F);
-		writePos += 2;
+		result[0] = char(0xE0U | (codePoint >> 12U));
+		result[1] = char(0x80U | ((codePoint >> 6U) & 0x3FU));
+		result[2] = char(0x80U | (codePoint & 0x3FU));
+		return 3;
 	}
-	else
+	result[0] = char(0xF0U | (codePoint >> 18U));
+	result[1] = char(0x80U | ((codePoint >> 12U) & 0x3FU));
+	result[2] = char(0x80U | ((codePoint >> 6U) & 0x3FU));
+	result[3] = char(0x80U | (codePoint & 0x3FU));
+	return 4;
+}
+
+inline bool isHighSurrogate(const uint16_t unit) noexcept { return unit >= 0xD800U && unit <= 0xDBFFU; }
+inline bool isLowSurrogate(const uint16_t unit) noexcept { return unit >= 0xDC00U && unit <= 0xDFFFU; }
+
+size_t escapeDecoder_t::decode(const char escape, const char *const hex, char *const result)
+{
+	if (escape != 'u')
+	{
+		char value{};
+		switch (escape)
+		{
+			case '"':
+			case '\\':
+			case '/':
+				value = escape;
+				break;
+			case 'b':
+				value = '\x08';
+				break;
+			case 'f':
+				value = '\x0C';
+				break;
+			case 'n':
+				value = '\n';
+				break;
+			case 'r':
+				value = '\r';
+				break;
+			case 't':
+				value = '\t';
+				break;
+			default:
+				throw JSONParserError(JSON_PARSER_BAD_JSON);
+		}
+		const auto count{flush(result)};
+		result[count] = value;
+		return count + 1U;
+	}
+
+	uint16_t unit{0U};
+	for (size_t i{0}; i < 4U; ++i)
+		unit = uint16_t((unit << 4U) | hex2int(hex[i]));
+
+	if (highSurrogate && isLowSurrogate(unit))
+	{
+		const uint32_t codePoint{0x10000U + ((uint32_t{highSurrogate} - 0xD800U) << 10U) + (unit - 0xDC00U)};
+		highSurrogate = 0U;
+		return encodeUTF8(codePoint, result);
+	}
+	const auto count{flush(result)};
+	// Hold a high surrogate back until we know whether a low surrogate follows it
+	if (isHighSurrogate(unit))
 	{
-		writePos[2] = 0x80 | (charVal & 0x3F);
-		charVal >>= 6;
-		writePos[1] = 0x80 | (charVal & 0x3F);
-		charVal >>= 6;
-		writePos[0] = 0xE0 | (charVal & 0x0F);
-		writePos += 3;
+		highSurrogate = unit;
+		return count;
 	}
+	return count + encodeUTF8(unit, result + count);
+}
+
+size_t escapeDecoder_t::flush(char *const result) noexcept
+{
+	if (!highSurrogate)
+		return 0U;
+	const auto count{encodeUTF8(highSurrogate, result)};
+	highSurrogate = 0U;
+	return count;
 }
 
 JSONString::JSONString(char *const value, const size_t length) : JSONString{std::string{value, length}} { }
@@ -75,80 +132,146 @@ JSONString::JSONString(const std::string &value) : JSONString{std::string_view{v
 
 JSONString::JSONString(std::string &&value) : JSONAtom{JSON_TYPE_STRING}, str{makeOpaque<string_t>(std::move(value))} { }
 JSONString::JSONString(const std::string_view &value) : JSONAtom{JSON_TYPE_STRING}, str{makeOpaque<string_t>(value)} { }
+JSONString::JSONString(OpaquePtr<internal::string_t> &&value) noexcept : JSONAtom{JSON_TYPE_STRING}, str{std::move(value)} { }
+
+string_t::string_t(const std::string_view &str) : storage{std::string{str}} { }
+string_t::string_t(borrow_t, const std::string_view &str, std::shared_ptr<const std::string> owner,
+	const bool terminated, arena_t *const arena) noexcept :
+		storage{borrowed_t{str, std::move(owner), terminated, arena}} { }
 
-string_t::string_t(const std::string_view &str) : string{str} { }
+string_t::string_t(unescaped_t, std::string &&str) noexcept : storage{std::move(str)} { }
 
-string_t::string_t(std::string &&str) : string{std::move(str)}
+// Unescapes str. No escape decodes to more bytes than it is written in, so this can be done in place.
+string_t::string_t(std::string &&str) : storage{std::move(str)}
 {
-	const uint8_t *readPos = (uint8_t *)string.data();
-	uint8_t *writePos = (uint8_t *)string.data();
-	bool slash = false;
+	auto &string{*std::get_if<std::string>(&storage)};
+	escapeDecoder_t decoder{};
+	char decoded[escapeDecoder_t::maxLength];
+	size_t readPos{0};
+	size_t writePos{0};
 
-	while (*readPos != 0)
+	const auto write = [&](const char *const value, const size_t length) noexcept
 	{
-		if (!slash && *readPos == '\\')
-		{
-			slash = true;
-			readPos++;
-		}
-		else
+		memmove(string.data() + writePos, value, length);
+		writePos += length;
+	};
+
+	while (true)
+	{
+		const auto slash{string.find('\\', readPos)};
+		const auto runEnd{slash == std::string::npos ? string.size() : slash};
+		if (runEnd != readPos)
 		{
-			if (slash)
-			{
-				switch (*readPos)
-				{
-					case 'u':
-					{
-						parseUnicode(readPos, writePos);
-						break;
-					}
-					case 'n':
-						writeValue(readPos, writePos, '\n');
-						break;
-					case 'r':
-						writeValue(readPos, writePos, '\r');
-						break;
-					case 't':
-						writeValue(readPos, writePos, '\t');
-						break;
-					case '"':
-					case '\\':
-					case '/':
-						writeValue(readPos, writePos, *readPos);
-						break;
-					case 'b':
-						writeValue(readPos, writePos, '\x08');
-						break;
-					case 'f':
-						writeValue(readPos, writePos, '\x0C');
-						break;
-				}
-				slash = false;
-			}
-			else
-			{
-				if (writePos != readPos)
-					*writePos = *readPos;
-				writePos++;
-				readPos++;
-			}
+			write(decoded, decoder.flush(decoded));
+			write(string.data() + readPos, runEnd - readPos);
 		}
+		if (slash == std::string::npos)
+			break;
+
+		const size_t escapeLength{slash + 1U < string.size() && string[slash + 1U] == 'u' ? 6U : 2U};
+		if (slash + escapeLength > string.size())
+			throw JSONParserError(JSON_PARSER_BAD_JSON);
+		write(decoded, decoder.decode(string[slash + 1U], string.data() + slash + 2U, decoded));
+		readPos = slash + escapeLength;
 	}
-	writePos[0] = 0;
+	write(decoded, decoder.flush(decoded));
 	// Properly truncate the string storage to the new length so the length is properly reported
-	string.erase(string.begin() + (writePos - (uint8_t *)string.data()), string.end());
+	string.resize(writePos);
 }
 
+string_t::~string_t() noexcept { delete copy.load(std::memory_order_relaxed); }
+
 string_t &string_t::operator =(string_t &&str) noexcept
 {
-	std::swap(string, str.string);
+	std::swap(storage, str.storage);
+	copy.store(str.copy.exchange(copy.load(std::memory_order_relaxed), std::memory_order_relaxed),
+		std::memory_order_relaxed);
 	return *this;
 }
 
+// Strings made in an arena stay in it when they're replaced, as they're never destroyed to free anything else
+void string_t::assign(string_t &&str)
+{
+	const auto *const string{std::get_if<borrowed_t>(&storage)};
+	if (!string || !string->arena)
+	{
+		*this = std::move(str);
+		return;
+	}
+	auto &arena{*string->arena};
+	storage = borrowed_t{arena.copy(str.view()), nullptr, true, &arena};
+	// Any copy of the old value belongs to the arena
+	copy.store(nullptr, std::memory_order_relaxed);
+}
+
+// There's no way to hand back a borrowed string as a std::string without one to refer to. An interned
+// string's owner is exactly that, but anything else has to be copied out of the buffer it was parsed
+// from. The copy is made once, by whichever thread gets there first, and never changes after that.
+// Strings made in an arena are never destroyed, so the arena keeps the copy (or copies, if several threads
+// race to make one) for them.
+const std::string &string_t::borrowedValue(const borrowed_t &string) const
+{
+	const auto &owner{string.owner};
+	if (owner && owner->data() == string.value.data() && owner->size() == string.value.size())
+		return *owner;
+	if (const auto *const result{copy.load(std::memory_order_acquire)})
+		return *result;
+	auto value{std::make_unique<const std::string>(string.value)};
+	if (string.arena)
+		string.arena->keep(const_cast<std::string *>(value.get()), del<std::string>);
+	const std::string *result{nullptr};
+	if (copy.compare_exchange_strong(result, value.get(), std::memory_order_acq_rel, std::memory_order_acquire))
+		result = value.release();
+	else if (string.arena)
+		value.release();
+	return *result;
+}
+
+const std::string &string_t::value() const
+{
+	if (const auto *const string{std::get_if<borrowed_t>(&storage)})
+		return borrowedValue(*string);
+	return *std::get_if<std::string>(&storage);
+}
+
+// Borrowed strings that are followed by a NUL are handed out as they are, without needing a std::string
+const char *string_t::c_str() const
+{
+	if (const auto *const string{std::get_if<borrowed_t>(&storage)}; string && string->terminated)
+		return string->value.data();
+	return value().c_str();
+}
+
+std::string_view string_t::view() const noexcept
+{
+	if (const auto *const string{std::get_if<borrowed_t>(&storage)})
+		return string->value;
+	return *std::get_if<std::string>(&storage);
+}
+
+pool_t::pool_t(const size_t longest) : minLength{std::string{}.capacity() + 1U}, maxLength{longest} { }
+
+const std::shared_ptr<const std::string> &pool_t::intern(const std::string_view value)
+{
+	if (const auto string{strings.find(value)}; string != strings.end())
+		return string->second;
+	auto interned{std::make_shared<const std::string>(value)};
+	// Key the string by a view of the pool's own copy, which never moves
+	const std::string_view key{*interned};
+	return strings.emplace(key, std::move(interned)).first->second;
+}
+
+stringPool_t::stringPool_t() : stringPool_t{64U} { }
+stringPool_t::stringPool_t(const size_t maxLength) : strings{makeOpaque<pool_t>(maxLength)} { }
+size_t stringPool_t::size() const noexcept { return strings->size(); }
+void stringPool_t::clear() noexcept { strings->clear(); }
+
 JSONString::operator const char *() const
-	{ return str->value().c_str(); }
+	{ return str->c_str(); }
 JSONString::operator const std::string &() const
 	{ return str->value(); }
+std::string_view JSONString::view() const noexcept
+	{ return str->view(); }
 
 void JSONString::set(char *value)
 	{ set(std::string{value}); }
@@ -157,9 +280,9 @@ void JSONString::set(const char *value)
 void JSONString::set(const std::string &value)
 	{ set(std::string_view{value}); }
 void JSONString::set(std::string &&value)
-	{ *str = string_t{std::move(value)}; }
+	{ str->assign(string_t{std::move(value)}); }
 void JSONString::set(const std::string_view &value)
-	{ *str = string_t{value}; }
+	{ str->assign(string_t{value}); }
 
 size_t JSONString::len() const noexcept
 {
@@ -0,0 +1,902 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// SPDX-FileCopyrightText: 2026 agent <agent@local>
+// SPDX-FileContributor: Written by agent <agent@local>
+
+#include <cfloat>
+#include <cstdlib>
+#include <cstring>
+#include "internal/number.hxx"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Decimal to binary conversion per the Eisel-Lemire algorithm as described in
+// "Number Parsing at a Gigabyte per Second" (Lemire, 2021), falling back to the C library
+// only for numbers with more significant digits than we can hold exactly.
+
+constexpr int64_t smallestPowerOfFive{-342};
+constexpr int64_t largestPowerOfFive{308};
+
+// The powers of five from 5^-342 to 5^308, normalised so the top bit is set and truncated to 128 bits
+const uint64_t powersOfFive[][2]
+{
+	{0xeef453d6923bd65aU, 0x113faa2906a13b3fU}, // 5^-342
+	{0x9558b4661b6565f8U, 0x4ac7ca59a424c507U}, // 5^-341
+	{0xbaaee17fa23ebf76U, 0x5d79bcf00d2df649U}, // 5^-340
+	{0xe95a99df8ace6f53U, 0xf4d82c2c107973dcU}, // 5^-339
+	{0x91d8a02bb6c10594U, 0x79071b9b8a4be869U}, // 5^-338
+	{0xb64ec836a47146f9U, 0x9748e2826cdee284U}, // 5^-337
+	{0xe3e27a444d8d98b7U, 0xfd1b1b2308169b25U}, // 5^-336
+	{0x8e6d8c6ab0787f72U, 0xfe30f0f5e50e20f7U}, // 5^-335
+	{0xb208ef855c969f4fU, 0xbdbd2d335e51a935U}, // 5^-334
+	{0xde8b2b66b3bc4723U, 0xad2c788035e61382U}, // 5^-333
+	{0x8b16fb203055ac76U, 0x4c3bcb5021afcc31U}, // 5^-332
+	{0xaddcb9e83c6b1793U, 0xdf4abe242a1bbf3dU}, // 5^-331
+	{0xd953e8624b85dd78U, 0xd71d6dad34a2af0dU}, // 5^-330
+	{0x87d4713d6f33aa6bU, 0x8672648c40e5ad68U}, // 5^-329
+	{0xa9c98d8ccb009506U, 0x680efdaf511f18c2U}, // 5^-328
+	{0xd43bf0effdc0ba48U, 0x0212bd1b2566def2U}, // 5^-327
+	{0x84a57695fe98746dU, 0x014bb630f7604b57U}, // 5^-326
+	{0xa5ced43b7e3e9188U, 0x419ea3bd35385e2dU}, // 5^-325
+	{0xcf42894a5dce35eaU, 0x52064cac828675b9U}, // 5^-324
+	{0x818995ce7aa0e1b2U, 0x7343efebd1940993U}, // 5^-323
+	{0xa1ebfb4219491a1fU, 0x1014ebe6c5f90bf8U}, // 5^-322
+	{0xca66fa129f9b60a6U, 0xd41a26e077774ef6U}, // 5^-321
+	{0xfd00b897478238d0U, 0x8920b098955522b4U}, // 5^-320
+	{0x9e20735e8cb16382U, 0x55b46e5f5d5535b0U}, // 5^-319
+	{0xc5a890362fddbc62U, 0xeb2189f734aa831dU}, // 5^-318
+	{0xf712b443bbd52b7bU, 0xa5e9ec7501d523e4U}, // 5^-317
+	{0x9a6bb0aa55653b2dU, 0x47b233c92125366eU}, // 5^-316
+	{0xc1069cd4eabe89f8U, 0x999ec0bb696e840aU}, // 5^-315
+	{0xf148440a256e2c76U, 0xc00670ea43ca250dU}, // 5^-314
+	{0x96cd2a865764dbcaU, 0x380406926a5e5728U}, // 5^-313
+	{0xbc807527ed3e12bcU, 0xc605083704f5ecf2U}, // 5^-312
+	{0xeba09271e88d976bU, 0xf7864a44c633682eU}, // 5^-311
+	{0x93445b8731587ea3U, 0x7ab3ee6afbe0211dU}, // 5^-310
+	{0xb8157268fdae9e4cU, 0x5960ea05bad82964U}, // 5^-309
+	{0xe61acf033d1a45dfU, 0x6fb92487298e33bdU}, // 5^-308
+	{0x8fd0c16206306babU, 0xa5d3b6d479f8e056U}, // 5^-307
+	{0xb3c4f1ba87bc8696U, 0x8f48a4899877186cU}, // 5^-306
+	{0xe0b62e2929aba83cU, 0x331acdabfe94de87U}, // 5^-305
+	{0x8c71dcd9ba0b4925U, 0x9ff0c08b7f1d0b14U}, // 5^-304
+	{0xaf8e5410288e1b6fU, 0x07ecf0ae5ee44dd9U}, // 5^-303
+	{0xdb71e91432b1a24aU, 0xc9e82cd9f69d6150U}, // 5^-302
+	{0x892731ac9faf056eU, 0xbe311c083a225cd2U}, // 5^-301
+	{0xab70fe17c79ac6caU, 0x6dbd630a48aaf406U}, // 5^-300
+	{0xd64d3d9db981787dU, 0x092cbbccdad5b108U}, // 5^-299
+	{0x85f0468293f0eb4eU, 0x25bbf56008c58ea5U}, // 5^-298
+	{0xa76c582338ed2621U, 0xaf2af2b80af6f24eU}, // 5^-297
+	{0xd1476e2c07286faaU, 0x1af5af660db4aee1U}, // 5^-296
+	{0x82cca4db847945caU, 0x50d98d9fc890ed4dU}, // 5^-295
+	{0xa37fce126597973cU, 0xe50ff107bab528a0U}, // 5^-294
+	{0xcc5fc196fefd7d0cU, 0x1e53ed49a96272c8U}, // 5^-293
+	{0xff77b1fcbebcdc4fU, 0x25e8e89c13bb0f7aU}, // 5^-292
+	{0x9faacf3df73609b1U, 0x77b191618c54e9acU}, // 5^-291
+	{0xc795830d75038c1dU, 0xd59df5b9ef6a2417U}, // 5^-290
+	{0xf97ae3d0d2446f25U, 0x4b0573286b44ad1dU}, // 5^-289
+	{0x9becce62836ac577U, 0x4ee367f9430aec32U}, // 5^-288
+	{0xc2e801fb244576d5U, 0x229c41f793cda73fU}, // 5^-287
+	{0xf3a20279ed56d48aU, 0x6b43527578c1110fU}, // 5^-286
+	{0x9845418c345644d6U, 0x830a13896b78aaa9U}, // 5^-285
+	{0xbe5691ef416bd60cU, 0x23cc986bc656d553U}, // 5^-284
+	{0xedec366b11c6cb8fU, 0x2cbfbe86b7ec8aa8U}, // 5^-283
+	{0x94b3a202eb1c3f39U, 0x7bf7d71432f3d6a9U}, // 5^-282
+	{0xb9e08a83a5e34f07U, 0xdaf5ccd93fb0cc53U}, // 5^-281
+	{0xe858ad248f5c22c9U, 0xd1b3400f8f9cff68U}, // 5^-280
+	{0x91376c36d99995beU, 0x23100809b9c21fa1U}, // 5^-279
+	{0xb58547448ffffb2dU, 0xabd40a0c2832a78aU}, // 5^-278
+	{0xe2e69915b3fff9f9U, 0x16c90c8f323f516cU}, // 5^-277
+	{0x8dd01fad907ffc3bU, 0xae3da7d97f6792e3U}, // 5^-276
+	{0xb1442798f49ffb4aU, 0x99cd11cfdf41779cU}, // 5^-275
+	{0xdd95317f31c7fa1dU, 0x40405643d711d583U}, // 5^-274
+	{0x8a7d3eef7f1cfc52U, 0x482835ea666b2572U}, // 5^-273
+	{0xad1c8eab5ee43b66U, 0xda3243650005eecfU}, // 5^-272
+	{0xd863b256369d4a40U, 0x90bed43e40076a82U}, // 5^-271
+	{0x873e4f75e2224e68U, 0x5a7744a6e804a291U}, // 5^-270
+	{0xa90de3535aaae202U, 0x711515d0a205cb36U}, // 5^-269
+	{0xd3515c2831559a83U, 0x0d5a5b44ca873e03U}, // 5^-268
+	{0x8412d9991ed58091U, 0xe858790afe9486c2U}, // 5^-267
+	{0xa5178fff668ae0b6U, 0x626e974dbe39a872U}, // 5^-266
+	{0xce5d73ff402d98e3U, 0xfb0a3d212dc8128fU}, // 5^-265
+	{0x80fa687f881c7f8eU, 0x7ce66634bc9d0b99U}, // 5^-264
+	{0xa139029f6a239f72U, 0x1c1fffc1ebc44e80U}, // 5^-263
+	{0xc987434744ac874eU, 0xa327ffb266b56220U}, // 5^-262
+	{0xfbe9141915d7a922U, 0x4bf1ff9f0062baa8U}, // 5^-261
+	{0x9d71ac8fada6c9b5U, 0x6f773fc3603db4a9U}, // 5^-260
+	{0xc4ce17b399107c22U, 0xcb550fb4384d21d3U}, // 5^-259
+	{0xf6019da07f549b2bU, 0x7e2a53a146606a48U}, // 5^-258
+	{0x99c102844f94e0fbU, 0x2eda7444cbfc426dU}, // 5^-257
+	{0xc0314325637a1939U, 0xfa911155fefb5308U}, // 5^-256
+	{0xf03d93eebc589f88U, 0x793555ab7eba27caU}, // 5^-255
+	{0x96267c7535b763b5U, 0x4bc1558b2f3458deU}, // 5^-254
+	{0xbbb01b9283253ca2U, 0x9eb1aaedfb016f16U}, // 5^-253
+	{0xea9c227723ee8bcbU, 0x465e15a979c1cadcU}, // 5^-252
+	{0x92a1958a7675175fU, 0x0bfacd89ec191ec9U}, // 5^-251
+	{0xb749faed14125d36U, 0xcef980ec671f667bU}, // 5^-250
+	{0xe51c79a85916f484U, 0x82b7e12780e7401aU}, // 5^-249
+	{0x8f31cc0937ae58d2U, 0xd1b2ecb8b0908810U}, // 5^-248
+	{0xb2fe3f0b8599ef07U, 0x861fa7e6dcb4aa15U}, // 5^-247
+	{0xdfbdcece67006ac9U, 0x67a791e093e1d49aU}, // 5^-246
+	{0x8bd6a141006042bdU, 0xe0c8bb2c5c6d24e0U}, // 5^-245
+	{0xaecc49914078536dU, 0x58fae9f773886e18U}, // 5^-244
+	{0xda7f5bf590966848U, 0xaf39a475506a899eU}, // 5^-243
+	{0x888f99797a5e012dU, 0x6d8406c952429603U}, // 5^-242
+	{0xaab37fd7d8f58178U, 0xc8e5087ba6d33b83U}, // 5^-241
+	{0xd5605fcdcf32e1d6U, 0xfb1e4a9a90880a64U}, // 5^-240
+	{0x855c3be0a17fcd26U, 0x5cf2eea09a55067fU}, // 5^-239
+	{0xa6b34ad8c9dfc06fU, 0xf42faa48c0ea481eU}, // 5^-238
+	{0xd0601d8efc57b08bU, 0xf13b94daf124da26U}, // 5^-237
+	{0x823c12795db6ce57U, 0x76c53d08d6b70858U}, // 5^-236
+	{0xa2cb1717b52481edU, 0x54768c4b0c64ca6eU}, // 5^-235
+	{0xcb7ddcdda26da268U, 0xa9942f5dcf7dfd09U}, // 5^-234
+	{0xfe5d54150b090b02U, 0xd3f93b35435d7c4cU}, // 5^-233
+	{0x9efa548d26e5a6e1U, 0xc47bc5014a1a6dafU}, // 5^-232
+	{0xc6b8e9b0709f109aU, 0x359ab6419ca1091bU}, // 5^-231
+	{0xf867241c8cc6d4c0U, 0xc30163d203c94b62U}, // 5^-230
+	{0x9b407691d7fc44f8U, 0x79e0de63425dcf1dU}, // 5^-229
+	{0xc21094364dfb5636U, 0x985915fc12f542e4U}, // 5^-228
+	{0xf294b943e17a2bc4U, 0x3e6f5b7b17b2939dU}, // 5^-227
+	{0x979cf3ca6cec5b5aU, 0xa705992ceecf9c42U}, // 5^-226
+	{0xbd8430bd08277231U, 0x50c6ff782a838353U}, // 5^-225
+	{0xece53cec4a314ebdU, 0xa4f8bf5635246428U}, // 5^-224
+	{0x940f4613ae5ed136U, 0x871b7795e136be99U}, // 5^-223
+	{0xb913179899f68584U, 0x28e2557b59846e3fU}, // 5^-222
+	{0xe757dd7ec07426e5U, 0x331aeada2fe589cfU}, // 5^-221
+	{0x9096ea6f3848984fU, 0x3ff0d2c85def7621U}, // 5^-220
+	{0xb4bca50b065abe63U, 0x0fed077a756b53a9U}, // 5^-219
+	{0xe1ebce4dc7f16dfbU, 0xd3e8495912c62894U}, // 5^-218
+	{0x8d3360f09cf6e4bdU, 0x64712dd7abbbd95cU}, // 5^-217
+	{0xb080392cc4349decU, 0xbd8d794d96aacfb3U}, // 5^-216
+	{0xdca04777f541c567U, 0xecf0d7a0fc5583a0U}, // 5^-215
+	{0x89e42caaf9491b60U, 0xf41686c49db57244U}, // 5^-214
+	{0xac5d37d5b79b6239U, 0x311c2875c522ced5U}, // 5^-213
+	{0xd77485cb25823ac7U, 0x7d633293366b828bU}, // 5^-212
+	{0x86a8d39ef77164bcU, 0xae5dff9c02033197U}, // 5^-211
+	{0xa8530886b54dbdebU, 0xd9f57f830283fdfcU}, // 5^-210
+	{0xd267caa862a12d66U, 0xd072df63c324fd7bU}, // 5^-209
+	{0x8380dea93da4bc60U, 0x4247cb9e59f71e6dU}, // 5^-208
+	{0xa46116538d0deb78U, 0x52d9be85f074e608U}, // 5^-207
+	{0xcd795be870516656U, 0x67902e276c921f8bU}, // 5^-206
+	{0x806bd9714632dff6U, 0x00ba1cd8a3db53b6U}, // 5^-205
+	{0xa086cfcd97bf97f3U, 0x80e8a40eccd228a4U}, // 5^-204
+	{0xc8a883c0fdaf7df0U, 0x6122cd128006b2cdU}, // 5^-203
+	{0xfad2a4b13d1b5d6cU, 0x796b805720085f81U}, // 5^-202
+	{0x9cc3a6eec6311a63U, 0xcbe3303674053bb0U}, // 5^-201
+	{0xc3f490aa77bd60fcU, 0xbedbfc4411068a9cU}, // 5^-200
+	{0xf4f1b4d515acb93bU, 0xee92fb5515482d44U}, // 5^-199
+	{0x991711052d8bf3c5U, 0x751bdd152d4d1c4aU}, // 5^-198
+	{0xbf5cd54678eef0b6U, 0xd262d45a78a0635dU}, // 5^-197
+	{0xef340a98172aace4U, 0x86fb897116c87c34U}, // 5^-196
+	{0x9580869f0e7aac0eU, 0xd45d35e6ae3d4da0U}, // 5^-195
+	{0xbae0a846d2195712U, 0x8974836059cca109U}, // 5^-194
+	{0xe998d258869facd7U, 0x2bd1a438703fc94bU}, // 5^-193
+	{0x91ff83775423cc06U, 0x7b6306a34627ddcfU}, // 5^-192
+	{0xb67f6455292cbf08U, 0x1a3bc84c17b1d542U}, // 5^-191
+	{0xe41f3d6a7377eecaU, 0x20caba5f1d9e4a93U}, // 5^-190
+	{0x8e938662882af53eU, 0x547eb47b7282ee9cU}, // 5^-189
+	{0xb23867fb2a35b28dU, 0xe99e619a4f23aa43U}, // 5^-188
+	{0xdec681f9f4c31f31U, 0x6405fa00e2ec94d4U}, // 5^-187
+	{0x8b3c113c38f9f37eU, 0xde83bc408dd3dd04U}, // 5^-186
+	{0xae0b158b4738705eU, 0x9624ab50b148d445U}, // 5^-185
+	{0xd98ddaee19068c76U, 0x3badd624dd9b0957U}, // 5^-184
+	{0x87f8a8d4cfa417c9U, 0xe54ca5d70a80e5d6U}, // 5^-183
+	{0xa9f6d30a038d1dbcU, 0x5e9fcf4ccd211f4cU}, // 5^-182
+	{0xd47487cc8470652bU, 0x7647c3200069671fU}, // 5^-181
+	{0x84c8d4dfd2c63f3bU, 0x29ecd9f40041e073U}, // 5^-180
+	{0xa5fb0a17c777cf09U, 0xf468107100525890U}, // 5^-179
+	{0xcf79cc9db955c2ccU, 0x7182148d4066eeb4U}, // 5^-178
+	{0x81ac1fe293d599bfU, 0xc6f14cd848405530U}, // 5^-177
+	{0xa21727db38cb002fU, 0xb8ada00e5a506a7cU}, // 5^-176
+	{0xca9cf1d206fdc03bU, 0xa6d90811f0e4851cU}, // 5^-175
+	{0xfd442e4688bd304aU, 0x908f4a166d1da663U}, // 5^-174
+	{0x9e4a9cec15763e2eU, 0x9a598e4e043287feU}, // 5^-173
+	{0xc5dd44271ad3cdbaU, 0x40eff1e1853f29fdU}, // 5^-172
+	{0xf7549530e188c128U, 0xd12bee59e68ef47cU}, // 5^-171
+	{0x9a94dd3e8cf578b9U, 0x82bb74f8301958ceU}, // 5^-170
+	{0xc13a148e3032d6e7U, 0xe36a52363c1faf01U}, // 5^-169
+	{0xf18899b1bc3f8ca1U, 0xdc44e6c3cb279ac1U}, // 5^-168
+	{0x96f5600f15a7b7e5U, 0x29ab103a5ef8c0b9U}, // 5^-167
+	{0xbcb2b812db11a5deU, 0x7415d448f6b6f0e7U}, // 5^-166
+	{0xebdf661791d60f56U, 0x111b495b3464ad21U}, // 5^-165
+	{0x936b9fcebb25c995U, 0xcab10dd900beec34U}, // 5^-164
+	{0xb84687c269ef3bfbU, 0x3d5d514f40eea742U}, // 5^-163
+	{0xe65829b3046b0afaU, 0x0cb4a5a3112a5112U}, // 5^-162
+	{0x8ff71a0fe2c2e6dcU, 0x47f0e785eaba72abU}, // 5^-161
+	{0xb3f4e093db73a093U, 0x59ed216765690f56U}, // 5^-160
+	{0xe0f218b8d25088b8U, 0x306869c13ec3532cU}, // 5^-159
+	{0x8c974f7383725573U, 0x1e414218c73a13fbU}, // 5^-158
+	{0xafbd2350644eeacfU, 0xe5d1929ef90898faU}, // 5^-157
+	{0xdbac6c247d62a583U, 0xdf45f746b74abf39U}, // 5^-156
+	{0x894bc396ce5da772U, 0x6b8bba8c328eb783U}, // 5^-155
+	{0xab9eb47c81f5114fU, 0x066ea92f3f326564U}, // 5^-154
+	{0xd686619ba27255a2U, 0xc80a537b0efefebdU}, // 5^-153
+	{0x8613fd0145877585U, 0xbd06742ce95f5f36U}, // 5^-152
+	{0xa798fc4196e952e7U, 0x2c48113823b73704U}, // 5^-151
+	{0xd17f3b51fca3a7a0U, 0xf75a15862ca504c5U}, // 5^-150
+	{0x82ef85133de648c4U, 0x9a984d73dbe722fbU}, // 5^-149
+	{0xa3ab66580d5fdaf5U, 0xc13e60d0d2e0ebbaU}, // 5^-148
+	{0xcc963fee10b7d1b3U, 0x318df905079926a8U}, // 5^-147
+	{0xffbbcfe994e5c61fU, 0xfdf17746497f7052U}, // 5^-146
+	{0x9fd561f1fd0f9bd3U, 0xfeb6ea8bedefa633U}, // 5^-145
+	{0xc7caba6e7c5382c8U, 0xfe64a52ee96b8fc0U}, // 5^-144
+	{0xf9bd690a1b68637bU, 0x3dfdce7aa3c673b0U}, // 5^-143
+	{0x9c1661a651213e2dU, 0x06bea10ca65c084eU}, // 5^-142
+	{0xc31bfa0fe5698db8U, 0x486e494fcff30a62U}, // 5^-141
+	{0xf3e2f893dec3f126U, 0x5a89dba3c3efccfaU}, // 5^-140
+	{0x986ddb5c6b3a76b7U, 0xf89629465a75e01cU}, // 5^-139
+	{0xbe89523386091465U, 0xf6bbb397f1135823U}, // 5^-138
+	{0xee2ba6c0678b597fU, 0x746aa07ded582e2cU}, // 5^-137
+	{0x94db483840b717efU, 0xa8c2a44eb4571cdcU}, // 5^-136
+	{0xba121a4650e4ddebU, 0x92f34d62616ce413U}, // 5^-135
+	{0xe896a0d7e51e1566U, 0x77b020baf9c81d17U}, // 5^-134
+	{0x915e2486ef32cd60U, 0x0ace1474dc1d122eU}, // 5^-133
+	{0xb5b5ada8aaff80b8U, 0x0d819992132456baU}, // 5^-132
+	{0xe3231912d5bf60e6U, 0x10e1fff697ed6c69U}, // 5^-131
+	{0x8df5efabc5979c8fU, 0xca8d3ffa1ef463c1U}, // 5^-130
+	{0xb1736b96b6fd83b3U, 0xbd308ff8a6b17cb2U}, // 5^-129
+	{0xddd0467c64bce4a0U, 0xac7cb3f6d05ddbdeU}, // 5^-128
+	{0x8aa22c0dbef60ee4U, 0x6bcdf07a423aa96bU}, // 5^-127
+	{0xad4ab7112eb3929dU, 0x86c16c98d2c953c6U}, // 5^-126
+	{0xd89d64d57a607744U, 0xe871c7bf077ba8b7U}, // 5^-125
+	{0x87625f056c7c4a8bU, 0x11471cd764ad4972U}, // 5^-124
+	{0xa93af6c6c79b5d2dU, 0xd598e40d3dd89bcfU}, // 5^-123
+	{0xd389b47879823479U, 0x4aff1d108d4ec2c3U}, // 5^-122
+	{0x843610cb4bf160cbU, 0xcedf722a585139baU}, // 5^-121
+	{0xa54394fe1eedb8feU, 0xc2974eb4ee658828U}, // 5^-120
+	{0xce947a3da6a9273eU, 0x733d226229feea32U}, // 5^-119
+	{0x811ccc668829b887U, 0x0806357d5a3f525fU}, // 5^-118
+	{0xa163ff802a3426a8U, 0xca07c2dcb0cf26f7U}, // 5^-117
+	{0xc9bcff6034c13052U, 0xfc89b393dd02f0b5U}, // 5^-116
+	{0xfc2c3f3841f17c67U, 0xbbac2078d443ace2U}, // 5^-115
+	{0x9d9ba7832936edc0U, 0xd54b944b84aa4c0dU}, // 5^-114
+	{0xc5029163f384a931U, 0x0a9e795e65d4df11U}, // 5^-113
+	{0xf64335bcf065d37dU, 0x4d4617b5ff4a16d5U}, // 5^-112
+	{0x99ea0196163fa42eU, 0x504bced1bf8e4e45U}, // 5^-111
+	{0xc06481fb9bcf8d39U, 0xe45ec2862f71e1d6U}, // 5^-110
+	{0xf07da27a82c37088U, 0x5d767327bb4e5a4cU}, // 5^-109
+	{0x964e858c91ba2655U, 0x3a6a07f8d510f86fU}, // 5^-108
+	{0xbbe226efb628afeaU, 0x890489f70a55368bU}, // 5^-107
+	{0xeadab0aba3b2dbe5U, 0x2b45ac74ccea842eU}, // 5^-106
+	{0x92c8ae6b464fc96fU, 0x3b0b8bc90012929dU}, // 5^-105
+	{0xb77ada0617e3bbcbU, 0x09ce6ebb40173744U}, // 5^-104
+	{0xe55990879ddcaabdU, 0xcc420a6a101d0515U}, // 5^-103
+	{0x8f57fa54c2a9eab6U, 0x9fa946824a12232dU}, // 5^-102
+	{0xb32df8e9f3546564U, 0x47939822dc96abf9U}, // 5^-101
+	{0xdff9772470297ebdU, 0x59787e2b93bc56f7U}, // 5^-100
+	{0x8bfbea76c619ef36U, 0x57eb4edb3c55b65aU}, // 5^-99
+	{0xaefae51477a06b03U, 0xede622920b6b23f1U}, // 5^-98
+	{0xdab99e59958885c4U, 0xe95fab368e45ecedU}, // 5^-97
+	{0x88b402f7fd75539bU, 0x11dbcb0218ebb414U}, // 5^-96
+	{0xaae103b5fcd2a881U, 0xd652bdc29f26a119U}, // 5^-95
+	{0xd59944a37c0752a2U, 0x4be76d3346f0495fU}, // 5^-94
+	{0x857fcae62d8493a5U, 0x6f70a4400c562ddbU}, // 5^-93
+	{0xa6dfbd9fb8e5b88eU, 0xcb4ccd500f6bb952U}, // 5^-92
+	{0xd097ad07a71f26b2U, 0x7e2000a41346a7a7U}, // 5^-91
+	{0x825ecc24c873782fU, 0x8ed400668c0c28c8U}, // 5^-90
+	{0xa2f67f2dfa90563bU, 0x728900802f0f32faU}, // 5^-89
+	{0xcbb41ef979346bcaU, 0x4f2b40a03ad2ffb9U}, // 5^-88
+	{0xfea126b7d78186bcU, 0xe2f610c84987bfa8U}, // 5^-87
+	{0x9f24b832e6b0f436U, 0x0dd9ca7d2df4d7c9U}, // 5^-86
+	{0xc6ede63fa05d3143U, 0x91503d1c79720dbbU}, // 5^-85
+	{0xf8a95fcf88747d94U, 0x75a44c6397ce912aU}, // 5^-84
+	{0x9b69dbe1b548ce7cU, 0xc986afbe3ee11abaU}, // 5^-83
+	{0xc24452da229b021bU, 0xfbe85badce996168U}, // 5^-82
+	{0xf2d56790ab41c2a2U, 0xfae27299423fb9c3U}, // 5^-81
+	{0x97c560ba6b0919a5U, 0xdccd879fc967d41aU}, // 5^-80
+	{0xbdb6b8e905cb600fU, 0x5400e987bbc1c920U}, // 5^-79
+	{0xed246723473e3813U, 0x290123e9aab23b68U}, // 5^-78
+	{0x9436c0760c86e30bU, 0xf9a0b6720aaf6521U}, // 5^-77
+	{0xb94470938fa89bceU, 0xf808e40e8d5b3e69U}, // 5^-76
+	{0xe7958cb87392c2c2U, 0xb60b1d1230b20e04U}, // 5^-75
+	{0x90bd77f3483bb9b9U, 0xb1c6f22b5e6f48c2U}, // 5^-74
+	{0xb4ecd5f01a4aa828U, 0x1e38aeb6360b1af3U}, // 5^-73
+	{0xe2280b6c20dd5232U, 0x25c6da63c38de1b0U}, // 5^-72
+	{0x8d590723948a535fU, 0x579c487e5a38ad0eU}, // 5^-71
+	{0xb0af48ec79ace837U, 0x2d835a9df0c6d851U}, // 5^-70
+	{0xdcdb1b2798182244U, 0xf8e431456cf88e65U}, // 5^-69
+	{0x8a08f0f8bf0f156bU, 0x1b8e9ecb641b58ffU}, // 5^-68
+	{0xac8b2d36eed2dac5U, 0xe272467e3d222f3fU}, // 5^-67
+	{0xd7adf884aa879177U, 0x5b0ed81dcc6abb0fU}, // 5^-66
+	{0x86ccbb52ea94baeaU, 0x98e947129fc2b4e9U}, // 5^-65
+	{0xa87fea27a539e9a5U, 0x3f2398d747b36224U}, // 5^-64
+	{0xd29fe4b18e88640eU, 0x8eec7f0d19a03aadU}, // 5^-63
+	{0x83a3eeeef9153e89U, 0x1953cf68300424acU}, // 5^-62
+	{0xa48ceaaab75a8e2bU, 0x5fa8c3423c052dd7U}, // 5^-61
+	{0xcdb02555653131b6U, 0x3792f412cb06794dU}, // 5^-60
+	{0x808e17555f3ebf11U, 0xe2bbd88bbee40bd0U}, // 5^-59
+	{0xa0b19d2ab70e6ed6U, 0x5b6aceaeae9d0ec4U}, // 5^-58
+	{0xc8de047564d20a8bU, 0xf245825a5a445275U}, // 5^-57
+	{0xfb158592be068d2eU, 0xeed6e2f0f0d56712U}, // 5^-56
+	{0x9ced737bb6c4183dU, 0x55464dd69685606bU}, // 5^-55
+	{0xc428d05aa4751e4cU, 0xaa97e14c3c26b886U}, // 5^-54
+	{0xf53304714d9265dfU, 0xd53dd99f4b3066a8U}, // 5^-53
+	{0x993fe2c6d07b7fabU, 0xe546a8038efe4029U}, // 5^-52
+	{0xbf8fdb78849a5f96U, 0xde98520472bdd033U}, // 5^-51
+	{0xef73d256a5c0f77cU, 0x963e66858f6d4440U}, // 5^-50
+	{0x95a8637627989aadU, 0xdde7001379a44aa8U}, // 5^-49
+	{0xbb127c53b17ec159U, 0x5560c018580d5d52U}, // 5^-48
+	{0xe9d71b689dde71afU, 0xaab8f01e6e10b4a6U}, // 5^-47
+	{0x9226712162ab070dU, 0xcab3961304ca70e8U}, // 5^-46
+	{0xb6b00d69bb55c8d1U, 0x3d607b97c5fd0d22U}, // 5^-45
+	{0xe45c10c42a2b3b05U, 0x8cb89a7db77c506aU}, // 5^-44
+	{0x8eb98a7a9a5b04e3U, 0x77f3608e92adb242U}, // 5^-43
+	{0xb267ed1940f1c61cU, 0x55f038b237591ed3U}, // 5^-42
+	{0xdf01e85f912e37a3U, 0x6b6c46dec52f6688U}, // 5^-41
+	{0x8b61313bbabce2c6U, 0x2323ac4b3b3da015U}, // 5^-40
+	{0xae397d8aa96c1b77U, 0xabec975e0a0d081aU}, // 5^-39
+	{0xd9c7dced53c72255U, 0x96e7bd358c904a21U}, // 5^-38
+	{0x881cea14545c7575U, 0x7e50d64177da2e54U}, // 5^-37
+	{0xaa242499697392d2U, 0xdde50bd1d5d0b9e9U}, // 5^-36
+	{0xd4ad2dbfc3d07787U, 0x955e4ec64b44e864U}, // 5^-35
+	{0x84ec3c97da624ab4U, 0xbd5af13bef0b113eU}, // 5^-34
+	{0xa6274bbdd0fadd61U, 0xecb1ad8aeacdd58eU}, // 5^-33
+	{0xcfb11ead453994baU, 0x67de18eda5814af2U}, // 5^-32
+	{0x81ceb32c4b43fcf4U, 0x80eacf948770ced7U}, // 5^-31
+	{0xa2425ff75e14fc31U, 0xa1258379a94d028dU}, // 5^-30
+	{0xcad2f7f5359a3b3eU, 0x096ee45813a04330U}, // 5^-29
+	{0xfd87b5f28300ca0dU, 0x8bca9d6e188853fcU}, // 5^-28
+	{0x9e74d1b791e07e48U, 0x775ea264cf55347eU}, // 5^-27
+	{0xc612062576589ddaU, 0x95364afe032a819eU}, // 5^-26
+	{0xf79687aed3eec551U, 0x3a83ddbd83f52205U}, // 5^-25
+	{0x9abe14cd44753b52U, 0xc4926a9672793543U}, // 5^-24
+	{0xc16d9a0095928a27U, 0x75b7053c0f178294U}, // 5^-23
+	{0xf1c90080baf72cb1U, 0x5324c68b12dd6339U}, // 5^-22
+	{0x971da05074da7beeU, 0xd3f6fc16ebca5e04U}, // 5^-21
+	{0xbce5086492111aeaU, 0x88f4bb1ca6bcf585U}, // 5^-20
+	{0xec1e4a7db69561a5U, 0x2b31e9e3d06c32e6U}, // 5^-19
+	{0x9392ee8e921d5d07U, 0x3aff322e62439fd0U}, // 5^-18
+	{0xb877aa3236a4b449U, 0x09befeb9fad487c3U}, // 5^-17
+	{0xe69594bec44de15bU, 0x4c2ebe687989a9b4U}, // 5^-16
+	{0x901d7cf73ab0acd9U, 0x0f9d37014bf60a11U}, // 5^-15
+	{0xb424dc35095cd80fU, 0x538484c19ef38c95U}, // 5^-14
+	{0xe12e13424bb40e13U, 0x2865a5f206b06fbaU}, // 5^-13
+	{0x8cbccc096f5088cbU, 0xf93f87b7442e45d4U}, // 5^-12
+	{0xafebff0bcb24aafeU, 0xf78f69a51539d749U}, // 5^-11
+	{0xdbe6fecebdedd5beU, 0xb573440e5a884d1cU}, // 5^-10
+	{0x89705f4136b4a597U, 0x31680a88f8953031U}, // 5^-9
+	{0xabcc77118461cefcU, 0xfdc20d2b36ba7c3eU}, // 5^-8
+	{0xd6bf94d5e57a42bcU, 0x3d32907604691b4dU}, // 5^-7
+	{0x8637bd05af6c69b5U, 0xa63f9a49c2c1b110U}, // 5^-6
+	{0xa7c5ac471b478423U, 0x0fcf80dc33721d54U}, // 5^-5
+	{0xd1b71758e219652bU, 0xd3c36113404ea4a9U}, // 5^-4
+	{0x83126e978d4fdf3bU, 0x645a1cac083126eaU}, // 5^-3
+	{0xa3d70a3d70a3d70aU, 0x3d70a3d70a3d70a4U}, // 5^-2
+	{0xccccccccccccccccU, 0xcccccccccccccccdU}, // 5^-1
+	{0x8000000000000000U, 0x0000000000000000U}, // 5^0
+	{0xa000000000000000U, 0x0000000000000000U}, // 5^1
+	{0xc800000000000000U, 0x0000000000000000U}, // 5^2
+	{0xfa00000000000000U, 0x0000000000000000U}, // 5^3
+	{0x9c40000000000000U, 0x0000000000000000U}, // 5^4
+	{0xc350000000000000U, 0x0000000000000000U}, // 5^5
+	{0xf424000000000000U, 0x0000000000000000U}, // 5^6
+	{0x9896800000000000U, 0x0000000000000000U}, // 5^7
+	{0xbebc200000000000U, 0x0000000000000000U}, // 5^8
+	{0xee6b280000000000U, 0x0000000000000000U}, // 5^9
+	{0x9502f90000000000U, 0x0000000000000000U}, // 5^10
+	{0xba43b74000000000U, 0x0000000000000000U}, // 5^11
+	{0xe8d4a51000000000U, 0x0000000000000000U}, // 5^12
+	{0x9184e72a00000000U, 0x0000000000000000U}, // 5^13
+	{0xb5e620f480000000U, 0x0000000000000000U}, // 5^14
+	{0xe35fa931a0000000U, 0x0000000000000000U}, // 5^15
+	{0x8e1bc9bf04000000U, 0x0000000000000000U}, // 5^16
+	{0xb1a2bc2ec5000000U, 0x0000000000000000U}, // 5^17
+	{0xde0b6b3a76400000U, 0x0000000000000000U}, // 5^18
+	{0x8ac7230489e80000U, 0x0000000000000000U}, // 5^19
+	{0xad78ebc5ac620000U, 0x0000000000000000U}, // 5^20
+	{0xd8d726b7177a8000U, 0x0000000000000000U}, // 5^21
+	{0x878678326eac9000U, 0x0000000000000000U}, // 5^22
+	{0xa968163f0a57b400U, 0x0000000000000000U}, // 5^23
+	{0xd3c21bcecceda100U, 0x0000000000000000U}, // 5^24
+	{0x84595161401484a0U, 0x0000000000000000U}, // 5^25
+	{0xa56fa5b99019a5c8U, 0x0000000000000000U}, // 5^26
+	{0xcecb8f27f4200f3aU, 0x0000000000000000U}, // 5^27
+	{0x813f3978f8940984U, 0x4000000000000000U}, // 5^28
+	{0xa18f07d736b90be5U, 0x5000000000000000U}, // 5^29
+	{0xc9f2c9cd04674edeU, 0xa400000000000000U}, // 5^30
+	{0xfc6f7c4045812296U, 0x4d00000000000000U}, // 5^31
+	{0x9dc5ada82b70b59dU, 0xf020000000000000U}, // 5^32
+	{0xc5371912364ce305U, 0x6c28000000000000U}, // 5^33
+	{0xf684df56c3e01bc6U, 0xc732000000000000U}, // 5^34
+	{0x9a130b963a6c115cU, 0x3c7f400000000000U}, // 5^35
+	{0xc097ce7bc90715b3U, 0x4b9f100000000000U}, // 5^36
+	{0xf0bdc21abb48db20U, 0x1e86d40000000000U}, // 5^37
+	{0x96769950b50d88f4U, 0x1314448000000000U}, // 5^38
+	{0xbc143fa4e250eb31U, 0x17d955a000000000U}, // 5^39
+	{0xeb194f8e1ae525fdU, 0x5dcfab0800000000U}, // 5^40
+	{0x92efd1b8d0cf37beU, 0x5aa1cae500000000U}, // 5^41
+	{0xb7abc627050305adU, 0xf14a3d9e40000000U}, // 5^42
+	{0xe596b7b0c643c719U, 0x6d9ccd05d0000000U}, // 5^43
+	{0x8f7e32ce7bea5c6fU, 0xe4820023a2000000U}, // 5^44
+	{0xb35dbf821ae4f38bU, 0xdda2802c8a800000U}, // 5^45
+	{0xe0352f62a19e306eU, 0xd50b2037ad200000U}, // 5^46
+	{0x8c213d9da502de45U, 0x4526f422cc340000U}, // 5^47
+	{0xaf298d050e4395d6U, 0x9670b12b7f410000U}, // 5^48
+	{0xdaf3f04651d47b4cU, 0x3c0cdd765f114000U}, // 5^49
+	{0x88d8762bf324cd0fU, 0xa5880a69fb6ac800U}, // 5^50
+	{0xab0e93b6efee0053U, 0x8eea0d047a457a00U}, // 5^51
+	{0xd5d238a4abe98068U, 0x72a4904598d6d880U}, // 5^52
+	{0x85a36366eb71f041U, 0x47a6da2b7f864750U}, // 5^53
+	{0xa70c3c40a64e6c51U, 0x999090b65f67d924U}, // 5^54
+	{0xd0cf4b50cfe20765U, 0xfff4b4e3f741cf6dU}, // 5^55
+	{0x82818f1281ed449fU, 0xbff8f10e7a8921a4U}, // 5^56
+	{0xa321f2d7226895c7U, 0xaff72d52192b6a0dU}, // 5^57
+	{0xcbea6f8ceb02bb39U, 0x9bf4f8a69f764490U}, // 5^58
+	{0xfee50b7025c36a08U, 0x02f236d04753d5b4U}, // 5^59
+	{0x9f4f2726179a2245U, 0x01d762422c946590U}, // 5^60
+	{0xc722f0ef9d80aad6U, 0x424d3ad2b7b97ef5U}, // 5^61
+	{0xf8ebad2b84e0d58bU, 0xd2e0898765a7deb2U}, // 5^62
+	{0x9b934c3b330c8577U, 0x63cc55f49f88eb2fU}, // 5^63
+	{0xc2781f49ffcfa6d5U, 0x3cbf6b71c76b25fbU}, // 5^64
+	{0xf316271c7fc3908aU, 0x8bef464e3945ef7aU}, // 5^65
+	{0x97edd871cfda3a56U, 0x97758bf0e3cbb5acU}, // 5^66
+	{0xbde94e8e43d0c8ecU, 0x3d52eeed1cbea317U}, // 5^67
+	{0xed63a231d4c4fb27U, 0x4ca7aaa863ee4bddU}, // 5^68
+	{0x945e455f24fb1cf8U, 0x8fe8caa93e74ef6aU}, // 5^69
+	{0xb975d6b6ee39e436U, 0xb3e2fd538e122b44U}, // 5^70
+	{0xe7d34c64a9c85d44U, 0x60dbbca87196b616U}, // 5^71
+	{0x90e40fbeea1d3a4aU, 0xbc8955e946fe31cdU}, // 5^72
+	{0xb51d13aea4a488ddU, 0x6babab6398bdbe41U}, // 5^73
+	{0xe264589a4dcdab14U, 0xc696963c7eed2dd1U}, // 5^74
+	{0x8d7eb76070a08aecU, 0xfc1e1de5cf543ca2U}, // 5^75
+	{0xb0de65388cc8ada8U, 0x3b25a55f43294bcbU}, // 5^76
+	{0xdd15fe86affad912U, 0x49ef0eb713f39ebeU}, // 5^77
+	{0x8a2dbf142dfcc7abU, 0x6e3569326c784337U}, // 5^78
+	{0xacb92ed9397bf996U, 0x49c2c37f07965404U}, // 5^79
+	{0xd7e77a8f87daf7fbU, 0xdc33745ec97be906U}, // 5^80
+	{0x86f0ac99b4e8dafdU, 0x69a028bb3ded71a3U}, // 5^81
+	{0xa8acd7c0222311bcU, 0xc40832ea0d68ce0cU}, // 5^82
+	{0xd2d80db02aabd62bU, 0xf50a3fa490c30190U}, // 5^83
+	{0x83c7088e1aab65dbU, 0x792667c6da79e0faU}, // 5^84
+	{0xa4b8cab1a1563f52U, 0x577001b891185938U}, // 5^85
+	{0xcde6fd5e09abcf26U, 0xed4c0226b55e6f86U}, // 5^86
+	{0x80b05e5ac60b6178U, 0x544f8158315b05b4U}, // 5^87
+	{0xa0dc75f1778e39d6U, 0x696361ae3db1c721U}, // 5^88
+	{0xc913936dd571c84cU, 0x03bc3a19cd1e38e9U}, // 5^89
+	{0xfb5878494ace3a5fU, 0x04ab48a04065c723U}, // 5^90
+	{0x9d174b2dcec0e47bU, 0x62eb0d64283f9c76U}, // 5^91
+	{0xc45d1df942711d9aU, 0x3ba5d0bd324f8394U}, // 5^92
+	{0xf5746577930d6500U, 0xca8f44ec7ee36479U}, // 5^93
+	{0x9968bf6abbe85f20U, 0x7e998b13cf4e1ecbU}, // 5^94
+	{0xbfc2ef456ae276e8U, 0x9e3fedd8c321a67eU}, // 5^95
+	{0xefb3ab16c59b14a2U, 0xc5cfe94ef3ea101eU}, // 5^96
+	{0x95d04aee3b80ece5U, 0xbba1f1d158724a12U}, // 5^97
+	{0xbb445da9ca61281fU, 0x2a8a6e45ae8edc97U}, // 5^98
+	{0xea1575143cf97226U, 0xf52d09d71a3293bdU}, // 5^99
+	{0x924d692ca61be758U, 0x593c2626705f9c56U}, // 5^100
+	{0xb6e0c377cfa2e12eU, 0x6f8b2fb00c77836cU}, // 5^101
+	{0xe498f455c38b997aU, 0x0b6dfb9c0f956447U}, // 5^102
+	{0x8edf98b59a373fecU, 0x4724bd4189bd5eacU}, // 5^103
+	{0xb2977ee300c50fe7U, 0x58edec91ec2cb657U}, // 5^104
+	{0xdf3d5e9bc0f653e1U, 0x2f2967b66737e3edU}, // 5^105
+	{0x8b865b215899f46cU, 0xbd79e0d20082ee74U}, // 5^106
+	{0xae67f1e9aec07187U, 0xecd8590680a3aa11U}, // 5^107
+	{0xda01ee641a708de9U, 0xe80e6f4820cc9495U}, // 5^108
+	{0x884134fe908658b2U, 0x3109058d147fdcddU}, // 5^109
+	{0xaa51823e34a7eedeU, 0xbd4b46f0599fd415U}, // 5^110
+	{0xd4e5e2cdc1d1ea96U, 0x6c9e18ac7007c91aU}, // 5^111
+	{0x850fadc09923329eU, 0x03e2cf6bc604ddb0U}, // 5^112
+	{0xa6539930bf6bff45U, 0x84db8346b786151cU}, // 5^113
+	{0xcfe87f7cef46ff16U, 0xe612641865679a63U}, // 5^114
+	{0x81f14fae158c5f6eU, 0x4fcb7e8f3f60c07eU}, // 5^115
+	{0xa26da3999aef7749U, 0xe3be5e330f38f09dU}, // 5^116
+	{0xcb090c8001ab551cU, 0x5cadf5bfd3072cc5U}, // 5^117
+	{0xfdcb4fa002162a63U, 0x73d9732fc7c8f7f6U}, // 5^118
+	{0x9e9f11c4014dda7eU, 0x2867e7fddcdd9afaU}, // 5^119
+	{0xc646d63501a1511dU, 0xb281e1fd541501b8U}, // 5^120
+	{0xf7d88bc24209a565U, 0x1f225a7ca91a4226U}, // 5^121
+	{0x9ae757596946075fU, 0x3375788de9b06958U}, // 5^122
+	{0xc1a12d2fc3978937U, 0x0052d6b1641c83aeU}, // 5^123
+	{0xf209787bb47d6b84U, 0xc0678c5dbd23a49aU}, // 5^124
+	{0x9745eb4d50ce6332U, 0xf840b7ba963646e0U}, // 5^125
+	{0xbd176620a501fbffU, 0xb650e5a93bc3d898U}, // 5^126
+	{0xec5d3fa8ce427affU, 0xa3e51f138ab4cebeU}, // 5^127
+	{0x93ba47c980e98cdfU, 0xc66f336c36b10137U}, // 5^128
+	{0xb8a8d9bbe123f017U, 0xb80b0047445d4184U}, // 5^129
+	{0xe6d3102ad96cec1dU, 0xa60dc059157491e5U}, // 5^130
+	{0x9043ea1ac7e41392U, 0x87c89837ad68db2fU}, // 5^131
+	{0xb454e4a179dd1877U, 0x29babe4598c311fbU}, // 5^132
+	{0xe16a1dc9d8545e94U, 0xf4296dd6fef3d67aU}, // 5^133
+	{0x8ce2529e2734bb1dU, 0x1899e4a65f58660cU}, // 5^134
+	{0xb01ae745b101e9e4U, 0x5ec05dcff72e7f8fU}, // 5^135
+	{0xdc21a1171d42645dU, 0x76707543f4fa1f73U}, // 5^136
+	{0x899504ae72497ebaU, 0x6a06494a791c53a8U}, // 5^137
+	{0xabfa45da0edbde69U, 0x0487db9d17636892U}, // 5^138
+	{0xd6f8d7509292d603U, 0x45a9d2845d3c42b6U}, // 5^139
+	{0x865b86925b9bc5c2U, 0x0b8a2392ba45a9b2U}, // 5^140
+	{0xa7f26836f282b732U, 0x8e6cac7768d7141eU}, // 5^141
+	{0xd1ef0244af2364ffU, 0x3207d795430cd926U}, // 5^142
+	{0x8335616aed761f1fU, 0x7f44e6bd49e807b8U}, // 5^143
+	{0xa402b9c5a8d3a6e7U, 0x5f16206c9c6209a6U}, // 5^144
+	{0xcd036837130890a1U, 0x36dba887c37a8c0fU}, // 5^145
+	{0x802221226be55a64U, 0xc2494954da2c9789U}, // 5^146
+	{0xa02aa96b06deb0fdU, 0xf2db9baa10b7bd6cU}, // 5^147
+	{0xc83553c5c8965d3dU, 0x6f92829494e5acc7U}, // 5^148
+	{0xfa42a8b73abbf48cU, 0xcb772339ba1f17f9U}, // 5^149
+	{0x9c69a97284b578d7U, 0xff2a760414536efbU}, // 5^150
+	{0xc38413cf25e2d70dU, 0xfef5138519684abaU}, // 5^151
+	{0xf46518c2ef5b8cd1U, 0x7eb258665fc25d69U}, // 5^152
+	{0x98bf2f79d5993802U, 0xef2f773ffbd97a61U}, // 5^153
+	{0xbeeefb584aff8603U, 0xaafb550ffacfd8faU}, // 5^154
+	{0xeeaaba2e5dbf6784U, 0x95ba2a53f983cf38U}, // 5^155
+	{0x952ab45cfa97a0b2U, 0xdd945a747bf26183U}, // 5^156
+	{0xba756174393d88dfU, 0x94f971119aeef9e4U}, // 5^157
+	{0xe912b9d1478ceb17U, 0x7a37cd5601aab85dU}, // 5^158
+	{0x91abb422ccb812eeU, 0xac62e055c10ab33aU}, // 5^159
+	{0xb616a12b7fe617aaU, 0x577b986b314d6009U}, // 5^160
+	{0xe39c49765fdf9d94U, 0xed5a7e85fda0b80bU}, // 5^161
+	{0x8e41ade9fbebc27dU, 0x14588f13be847307U}, // 5^162
+	{0xb1d219647ae6b31cU, 0x596eb2d8ae258fc8U}, // 5^163
+	{0xde469fbd99a05fe3U, 0x6fca5f8ed9aef3bbU}, // 5^164
+	{0x8aec23d680043beeU, 0x25de7bb9480d5854U}, // 5^165
+	{0xada72ccc20054ae9U, 0xaf561aa79a10ae6aU}, // 5^166
+	{0xd910f7ff28069da4U, 0x1b2ba1518094da04U}, // 5^167
+	{0x87aa9aff79042286U, 0x90fb44d2f05d0842U}, // 5^168
+	{0xa99541bf57452b28U, 0x353a1607ac744a53U}, // 5^169
+	{0xd3fa922f2d1675f2U, 0x42889b8997915ce8U}, // 5^170
+	{0x847c9b5d7c2e09b7U, 0x69956135febada11U}, // 5^171
+	{0xa59bc234db398c25U, 0x43fab9837e699095U}, // 5^172
+	{0xcf02b2c21207ef2eU, 0x94f967e45e03f4bbU}, // 5^173
+	{0x8161afb94b44f57dU, 0x1d1be0eebac278f5U}, // 5^174
+	{0xa1ba1ba79e1632dcU, 0x6462d92a69731732U}, // 5^175
+	{0xca28a291859bbf93U, 0x7d7b8f7503cfdcfeU}, // 5^176
+	{0xfcb2cb35e702af78U, 0x5cda735244c3d43eU}, // 5^177
+	{0x9defbf01b061adabU, 0x3a0888136afa64a7U}, // 5^178
+	{0xc56baec21c7a1916U, 0x088aaa1845b8fdd0U}, // 5^179
+	{0xf6c69a72a3989f5bU, 0x8aad549e57273d45U}, // 5^180
+	{0x9a3c2087a63f6399U, 0x36ac54e2f678864bU}, // 5^181
+	{0xc0cb28a98fcf3c7fU, 0x84576a1bb416a7ddU}, // 5^182
+	{0xf0fdf2d3f3c30b9fU, 0x656d44a2a11c51d5U}, // 5^183
+	{0x969eb7c47859e743U, 0x9f644ae5a4b1b325U}, // 5^184
+	{0xbc4665b596706114U, 0x873d5d9f0dde1feeU}, // 5^185
+	{0xeb57ff22fc0c7959U, 0xa90cb506d155a7eaU}, // 5^186
+	{0x9316ff75dd87cbd8U, 0x09a7f12442d588f2U}, // 5^187
+	{0xb7dcbf5354e9beceU, 0x0c11ed6d538aeb2fU}, // 5^188
+	{0xe5d3ef282a242e81U, 0x8f1668c8a86da5faU}, // 5^189
+	{0x8fa475791a569d10U, 0xf96e017d694487bcU}, // 5^190
+	{0xb38d92d760ec4455U, 0x37c981dcc395a9acU}, // 5^191
+	{0xe070f78d3927556aU, 0x85bbe253f47b1417U}, // 5^192
+	{0x8c469ab843b89562U, 0x93956d7478ccec8eU}, // 5^193
+	{0xaf58416654a6babbU, 0x387ac8d1970027b2U}, // 5^194
+	{0xdb2e51bfe9d0696aU, 0x06997b05fcc0319eU}, // 5^195
+	{0x88fcf317f22241e2U, 0x441fece3bdf81f03U}, // 5^196
+	{0xab3c2fddeeaad25aU, 0xd527e81cad7626c3U}, // 5^197
+	{0xd60b3bd56a5586f1U, 0x8a71e223d8d3b074U}, // 5^198
+	{0x85c7056562757456U, 0xf6872d5667844e49U}, // 5^199
+	{0xa738c6bebb12d16cU, 0xb428f8ac016561dbU}, // 5^200
+	{0xd106f86e69d785c7U, 0xe13336d701beba52U}, // 5^201
+	{0x82a45b450226b39cU, 0xecc0024661173473U}, // 5^202
+	{0xa34d721642b06084U, 0x27f002d7f95d0190U}, // 5^203
+	{0xcc20ce9bd35c78a5U, 0x31ec038df7b441f4U}, // 5^204
+	{0xff290242c83396ceU, 0x7e67047175a15271U}, // 5^205
+	{0x9f79a169bd203e41U, 0x0f0062c6e984d386U}, // 5^206
+	{0xc75809c42c684dd1U, 0x52c07b78a3e60868U}, // 5^207
+	{0xf92e0c3537826145U, 0xa7709a56ccdf8a82U}, // 5^208
+	{0x9bbcc7a142b17ccbU, 0x88a66076400bb691U}, // 5^209
+	{0xc2abf989935ddbfeU, 0x6acff893d00ea435U}, // 5^210
+	{0xf356f7ebf83552feU, 0x0583f6b8c4124d43U}, // 5^211
+	{0x98165af37b2153deU, 0xc3727a337a8b704aU}, // 5^212
+	{0xbe1bf1b059e9a8d6U, 0x744f18c0592e4c5cU}, // 5^213
+	{0xeda2ee1c7064130cU, 0x1162def06f79df73U}, // 5^214
+	{0x9485d4d1c63e8be7U, 0x8addcb5645ac2ba8U}, // 5^215
+	{0xb9a74a0637ce2ee1U, 0x6d953e2bd7173692U}, // 5^216
+	{0xe8111c87c5c1ba99U, 0xc8fa8db6ccdd0437U}, // 5^217
+	{0x910ab1d4db9914a0U, 0x1d9c9892400a22a2U}, // 5^218
+	{0xb54d5e4a127f59c8U, 0x2503beb6d00cab4bU}, // 5^219
+	{0xe2a0b5dc971f303aU, 0x2e44ae64840fd61dU}, // 5^220
+	{0x8da471a9de737e24U, 0x5ceaecfed289e5d2U}, // 5^221
+	{0xb10d8e1456105dadU, 0x7425a83e872c5f47U}, // 5^222
+	{0xdd50f1996b947518U, 0xd12f124e28f77719U}, // 5^223
+	{0x8a5296ffe33cc92fU, 0x82bd6b70d99aaa6fU}, // 5^224
+	{0xace73cbfdc0bfb7bU, 0x636cc64d1001550bU}, // 5^225
+	{0xd8210befd30efa5aU, 0x3c47f7e05401aa4eU}, // 5^226
+	{0x8714a775e3e95c78U, 0x65acfaec34810a71U}, // 5^227
+	{0xa8d9d1535ce3b396U, 0x7f1839a741a14d0dU}, // 5^228
+	{0xd31045a8341ca07cU, 0x1ede48111209a050U}, // 5^229
+	{0x83ea2b892091e44dU, 0x934aed0aab460432U}, // 5^230
+	{0xa4e4b66b68b65d60U, 0xf81da84d5617853fU}, // 5^231
+	{0xce1de40642e3f4b9U, 0x36251260ab9d668eU}, // 5^232
+	{0x80d2ae83e9ce78f3U, 0xc1d72b7c6b426019U}, // 5^233
+	{0xa1075a24e4421730U, 0xb24cf65b8612f81fU}, // 5^234
+	{0xc94930ae1d529cfcU, 0xdee033f26797b627U}, // 5^235
+	{0xfb9b7cd9a4a7443cU, 0x169840ef017da3b1U}, // 5^236
+	{0x9d412e0806e88aa5U, 0x8e1f289560ee864eU}, // 5^237
+	{0xc491798a08a2ad4eU, 0xf1a6f2bab92a27e2U}, // 5^238
+	{0xf5b5d7ec8acb58a2U, 0xae10af696774b1dbU}, // 5^239
+	{0x9991a6f3d6bf1765U, 0xacca6da1e0a8ef29U}, // 5^240
+	{0xbff610b0cc6edd3fU, 0x17fd090a58d32af3U}, // 5^241
+	{0xeff394dcff8a948eU, 0xddfc4b4cef07f5b0U}, // 5^242
+	{0x95f83d0a1fb69cd9U, 0x4abdaf101564f98eU}, // 5^243
+	{0xbb764c4ca7a4440fU, 0x9d6d1ad41abe37f1U}, // 5^244
+	{0xea53df5fd18d5513U, 0x84c86189216dc5edU}, // 5^245
+	{0x92746b9be2f8552cU, 0x32fd3cf5b4e49bb4U}, // 5^246
+	{0xb7118682dbb66a77U, 0x3fbc8c33221dc2a1U}, // 5^247
+	{0xe4d5e82392a40515U, 0x0fabaf3feaa5334aU}, // 5^248
+	{0x8f05b1163ba6832dU, 0x29cb4d87f2a7400eU}, // 5^249
+	{0xb2c71d5bca9023f8U, 0x743e20e9ef511012U}, // 5^250
+	{0xdf78e4b2bd342cf6U, 0x914da9246b255416U}, // 5^251
+	{0x8bab8eefb6409c1aU, 0x1ad089b6c2f7548eU}, // 5^252
+	{0xae9672aba3d0c320U, 0xa184ac2473b529b1U}, // 5^253
+	{0xda3c0f568cc4f3e8U, 0xc9e5d72d90a2741eU}, // 5^254
+	{0x8865899617fb1871U, 0x7e2fa67c7a658892U}, // 5^255
+	{0xaa7eebfb9df9de8dU, 0xddbb901b98feeab7U}, // 5^256
+	{0xd51ea6fa85785631U, 0x552a74227f3ea565U}, // 5^257
+	{0x8533285c936b35deU, 0xd53a88958f87275fU}, // 5^258
+	{0xa67ff273b8460356U, 0x8a892abaf368f137U}, // 5^259
+	{0xd01fef10a657842cU, 0x2d2b7569b0432d85U}, // 5^260
+	{0x8213f56a67f6b29bU, 0x9c3b29620e29fc73U}, // 5^261
+	{0xa298f2c501f45f42U, 0x8349f3ba91b47b8fU}, // 5^262
+	{0xcb3f2f7642717713U, 0x241c70a936219a73U}, // 5^263
+	{0xfe0efb53d30dd4d7U, 0xed238cd383aa0110U}, // 5^264
+	{0x9ec95d1463e8a506U, 0xf4363804324a40aaU}, // 5^265
+	{0xc67bb4597ce2ce48U, 0xb143c6053edcd0d5U}, // 5^266
+	{0xf81aa16fdc1b81daU, 0xdd94b7868e94050aU}, // 5^267
+	{0x9b10a4e5e9913128U, 0xca7cf2b4191c8326U}, // 5^268
+	{0xc1d4ce1f63f57d72U, 0xfd1c2f611f63a3f0U}, // 5^269
+	{0xf24a01a73cf2dccfU, 0xbc633b39673c8cecU}, // 5^270
+	{0x976e41088617ca01U, 0xd5be0503e085d813U}, // 5^271
+	{0xbd49d14aa79dbc82U, 0x4b2d8644d8a74e18U}, // 5^272
+	{0xec9c459d51852ba2U, 0xddf8e7d60ed1219eU}, // 5^273
+	{0x93e1ab8252f33b45U, 0xcabb90e5c942b503U}, // 5^274
+	{0xb8da1662e7b00a17U, 0x3d6a751f3b936243U}, // 5^275
+	{0xe7109bfba19c0c9dU, 0x0cc512670a783ad4U}, // 5^276
+	{0x906a617d450187e2U, 0x27fb2b80668b24c5U}, // 5^277
+	{0xb484f9dc9641e9daU, 0xb1f9f660802dedf6U}, // 5^278
+	{0xe1a63853bbd26451U, 0x5e7873f8a0396973U}, // 5^279
+	{0x8d07e33455637eb2U, 0xdb0b487b6423e1e8U}, // 5^280
+	{0xb049dc016abc5e5fU, 0x91ce1a9a3d2cda62U}, // 5^281
+	{0xdc5c5301c56b75f7U, 0x7641a140cc7810fbU}, // 5^282
+	{0x89b9b3e11b6329baU, 0xa9e904c87fcb0a9dU}, // 5^283
+	{0xac2820d9623bf429U, 0x546345fa9fbdcd44U}, // 5^284
+	{0xd732290fbacaf133U, 0xa97c177947ad4095U}, // 5^285
+	{0x867f59a9d4bed6c0U, 0x49ed8eabcccc485dU}, // 5^286
+	{0xa81f301449ee8c70U, 0x5c68f256bfff5a74U}, // 5^287
+	{0xd226fc195c6a2f8cU, 0x73832eec6fff3111U}, // 5^288
+	{0x83585d8fd9c25db7U, 0xc831fd53c5ff7eabU}, // 5^289
+	{0xa42e74f3d032f525U, 0xba3e7ca8b77f5e55U}, // 5^290
+	{0xcd3a1230c43fb26fU, 0x28ce1bd2e55f35ebU}, // 5^291
+	{0x80444b5e7aa7cf85U, 0x7980d163cf5b81b3U}, // 5^292
+	{0xa0555e361951c366U, 0xd7e105bcc332621fU}, // 5^293
+	{0xc86ab5c39fa63440U, 0x8dd9472bf3fefaa7U}, // 5^294
+	{0xfa856334878fc150U, 0xb14f98f6f0feb951U}, // 5^295
+	{0x9c935e00d4b9d8d2U, 0x6ed1bf9a569f33d3U}, // 5^296
+	{0xc3b8358109e84f07U, 0x0a862f80ec4700c8U}, // 5^297
+	{0xf4a642e14c6262c8U, 0xcd27bb612758c0faU}, // 5^298
+	{0x98e7e9cccfbd7dbdU, 0x8038d51cb897789cU}, // 5^299
+	{0xbf21e44003acdd2cU, 0xe0470a63e6bd56c3U}, // 5^300
+	{0xeeea5d5004981478U, 0x1858ccfce06cac74U}, // 5^301
+	{0x95527a5202df0ccbU, 0x0f37801e0c43ebc8U}, // 5^302
+	{0xbaa718e68396cffdU, 0xd30560258f54e6baU}, // 5^303
+	{0xe950df20247c83fdU, 0x47c6b82ef32a2069U}, // 5^304
+	{0x91d28b7416cdd27eU, 0x4cdc331d57fa5441U}, // 5^305
+	{0xb6472e511c81471dU, 0xe0133fe4adf8e952U}, // 5^306
+	{0xe3d8f9e563a198e5U, 0x58180fddd97723a6U}, // 5^307
+	{0x8e679c2f5e44ff8fU, 0x570f09eaa7ea7648U}, // 5^308
+};
+
+constexpr double powersOfTen[]
+{
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// The layout of a binary64 (double)
+constexpr uint32_t mantissaBits{52U};
+constexpr int32_t minimumExponent{-1023};
+constexpr int32_t infinitePower{0x7FF};
+
+struct value128_t final
+{
+	uint64_t low;
+	uint64_t high;
+};
+
+// A binary floating point value being assembled - power2 is the biased exponent
+struct binaryFloat_t final
+{
+	uint64_t mantissa{0U};
+	int32_t power2{0};
+
+	bool operator ==(const binaryFloat_t &other) const noexcept
+		{ return mantissa == other.mantissa && power2 == other.power2; }
+};
+
+#ifdef __SIZEOF_INT128__
+__extension__ using uint128_t = unsigned __int128;
+#endif
+
+inline value128_t multiply(const uint64_t a, const uint64_t b) noexcept
+{
+#if defined(__SIZEOF_INT128__)
+	const uint128_t product{uint128_t{a} * b};
+	return {uint64_t(product), uint64_t(product >> 64U)};
+#elif defined(_MSC_VER) && defined(_M_X64)
+	uint64_t high{};
+	const uint64_t low{_umul128(a, b, &high)};
+	return {low, high};
+#else
+	const uint64_t aLow{a & 0xFFFFFFFFU};
+	const uint64_t aHigh{a >> 32U};
+	const uint64_t bLow{b & 0xFFFFFFFFU};
+	const uint64_t bHigh{b >> 32U};
+	const uint64_t lowLow{aLow * bLow};
+	const uint64_t lowHigh{aLow * bHigh};
+	const uint64_t highLow{aHigh * bLow};
+	const uint64_t middle{(lowLow >> 32U) + (lowHigh & 0xFFFFFFFFU) + (highLow & 0xFFFFFFFFU)};
+	return {(middle << 32U) | (lowLow & 0xFFFFFFFFU),
+		(aHigh * bHigh) + (lowHigh >> 32U) + (highLow >> 32U) + (middle >> 32U)};
+#endif
+}
+
+inline uint32_t countLeadingZeros(const uint64_t value) noexcept
+{
+#if defined(__GNUC__)
+	return uint32_t(__builtin_clzll(value));
+#elif defined(_MSC_VER) && defined(_M_X64)
+	unsigned long index{};
+	_BitScanReverse64(&index, value);
+	return 63U - index;
+#else
+	uint32_t count{0U};
+	for (uint64_t bit{uint64_t{1U} << 63U}; !(value & bit); bit >>= 1U)
+		++count;
+	return count;
+#endif
+}
+
+// Computes floor(log2(10^q)) + 63 for q in the range of the power table
+constexpr int32_t binaryPower(const int32_t q) noexcept
+	{ return (((152170 + 65536) * q) >> 16) + 63; }
+
+// Finds the double nearest to w * 10^q for a non-zero w
+binaryFloat_t computeFloat(const int64_t q, uint64_t w) noexcept
+{
+	if (!w || q < smallestPowerOfFive)
+		return {};
+	if (q > largestPowerOfFive)
+		return {0U, infinitePower};
+
+	const auto leadingZeros{countLeadingZeros(w)};
+	w <<= leadingZeros;
+	// 128 bits of the power of five is always enough to get the 55 bits we need right
+	// per "Fast Number Parsing Without Fallback" (Mushtak and Lemire, 2023)
+	const auto &power{powersOfFive[q - smallestPowerOfFive]};
+	auto product{multiply(w, power[0])};
+	constexpr uint64_t precisionMask{UINT64_MAX >> (mantissaBits + 3U)};
+	if ((product.high & precisionMask) == precisionMask)
+	{
+		const auto lowerProduct{multiply(w, power[1])};
+		product.low += lowerProduct.high;
+		if (lowerProduct.high > product.low)
+			++product.high;
+	}
+
+	const auto upperBit{uint32_t(product.high >> 63U)};
+	const auto shift{upperBit + 64U - mantissaBits - 3U};
+	binaryFloat_t result{product.high >> shift,
+		binaryPower(int32_t(q)) + int32_t(upperBit) - int32_t(leadingZeros) - minimumExponent};
+
+	// Subnormal results
+	if (result.power2 <= 0)
+	{
+		if (-result.power2 + 1 >= 64)
+			return {};
+		result.mantissa >>= -result.power2 + 1;
+		result.mantissa += result.mantissa & 1U;
+		result.mantissa >>= 1U;
+		result.power2 = result.mantissa < (uint64_t{1U} << mantissaBits) ? 0 : 1;
+		return result;
+	}
+
+	// If we're exactly half way between two doubles, round to even rather than up
+	if (product.low <= 1U && q >= -4 && q <= 23 && (result.mantissa & 3U) == 1U &&
+		(result.mantissa << shift) == product.high)
+		result.mantissa &= ~uint64_t{1U};
+
+	result.mantissa += result.mantissa & 1U;
+	result.mantissa >>= 1U;
+	if (result.mantissa >= (uint64_t{2U} << mantissaBits))
+	{
+		result.mantissa = uint64_t{1U} << mantissaBits;
+		++result.power2;
+	}
+	result.mantissa &= ~(uint64_t{1U} << mantissaBits);
+	if (result.power2 >= infinitePower)
+		return {0U, infinitePower};
+	return result;
+}
+
+inline double toDouble(const binaryFloat_t value, const bool negative) noexcept
+{
+	uint64_t bits{value.mantissa | (uint64_t(value.power2) << mantissaBits)};
+	if (negative)
+		bits |= uint64_t{1U} << 63U;
+	double result{};
+	memcpy(&result, &bits, sizeof(result));
+	return result;
+}
+
+void decimal_t::appendTruncated(const char digit, const bool fraction)
+{
+	if (!truncated)
+	{
+		truncated = true;
+		digits = std::to_string(mantissa);
+	}
+	digits += digit;
+	// Integer digits we can't hold scale what we do hold, fractional ones don't
+	if (!fraction)
+		++exponent;
+}
+
+bool decimal_t::toMagnitude(uint64_t &result) const noexcept
+{
+	uint64_t value{mantissa};
+	int64_t exponent{this->exponent};
+	// When digits were truncated, the full set of them is needed - the exponent counts those that were
+	// dropped, and they can only be worth anything exactly if there were no more than 20 of them
+	if (truncated)
+	{
+		value = 0U;
+		for (const auto digit : digits)
+		{
+			const auto digitValue{uint8_t(digit - '0')};
+			if (value > (UINT64_MAX - digitValue) / 10U)
+				return false;
+			value = (value * 10U) + digitValue;
+		}
+		exponent -= int64_t(digits.length() - maxDigits);
+	}
+	for (int64_t power{exponent}; power < 0 && value; ++power)
+	{
+		if (value % 10U)
+			return false;
+		value /= 10U;
+	}
+	for (int64_t power{0}; power < exponent && value; ++power)
+	{
+		if (value > UINT64_MAX / 10U)
+			return false;
+		value *= 10U;
+	}
+	result = value;
+	return true;
+}
+
+bool decimal_t::toInteger(int64_t &result) const noexcept
+{
+	uint64_t value{};
+	if (!toMagnitude(value) || value > (negative ? uint64_t{INT64_MAX} + 1U : uint64_t{INT64_MAX}))
+		return false;
+	result = negative ? int64_t(~value + 1U) : int64_t(value);
+	return true;
+}
+
+double decimal_t::toDouble() const
+{
+	if (!truncated)
+	{
+#if FLT_EVAL_METHOD == 0 || FLT_EVAL_METHOD == 1
+		// When both the mantissa and the power of ten are exact doubles, one IEEE operation rounds correctly
+		if (exponent >= -22 && exponent <= 22 && mantissa <= (uint64_t{1U} << 53U))
+		{
+			auto value{double(mantissa)};
+			if (exponent < 0)
+				value /= powersOfTen[-exponent];
+			else
+				value *= powersOfTen[exponent];
+			return negative ? -value : value;
+		}
+#endif
+		return ::toDouble(computeFloat(exponent, mantissa), negative);
+	}
+
+	// The true value lies between mantissa and mantissa + 1 - if they round the same, that's our answer
+	const auto value{computeFloat(exponent, mantissa)};
+	if (value == computeFloat(exponent, mantissa + 1U))
+		return ::toDouble(value, negative);
+	// Otherwise go the long way round. There's no radix character, so the locale can't affect this
+	const auto number{digits + 'e' + std::to_string(exponent - int64_t(digits.size() - maxDigits))};
+	const auto result{strtod(number.c_str(), nullptr)};
+	return negative ? -result : result;
+}
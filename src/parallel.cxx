@@ -0,0 +1,438 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// SPDX-FileCopyrightText: 2026 agent <agent@local>
+// SPDX-FileContributor: Written by agent <agent@local>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+#include "internal/types.hxx"
+#include "internal/parser.hxx"
+
+// A run of whole lines from an in-memory input, and what came of parsing them
+struct lineChunk_t final
+{
+	std::string_view json{};
+	size_t offset{0U};
+	std::vector<std::unique_ptr<JSONAtom>> documents{};
+	std::exception_ptr error{};
+};
+
+// A member of the outermost object or array of a document being parsed in parallel - its key, if it's
+// in an object, and where its value starts
+struct member_t final
+{
+	std::string key{};
+	size_t offset{0U};
+};
+
+// A run of members of the outermost object or array, by index, to be parsed together
+struct memberChunk_t final
+{
+	size_t begin{0U};
+	size_t end{0U};
+	std::exception_ptr error{};
+};
+
+// A run of whole lines read from a stream, numbered in the order they were read in
+struct readChunk_t final
+{
+	std::string json{};
+	size_t offset{0U};
+	size_t index{0U};
+};
+
+// Hands chunks read from a stream over to the workers, holding at most capacity of them at once
+// so the reader can't run arbitrarily far ahead of the parsing
+struct chunkQueue_t final
+{
+private:
+	std::mutex lock{};
+	std::condition_variable changed{};
+	std::deque<readChunk_t> chunks{};
+	size_t capacity;
+	bool closed{false};
+	// The errors raised so far, by the index of the chunk they came from
+	std::map<size_t, std::exception_ptr> errors{};
+
+public:
+	chunkQueue_t(const size_t maxChunks) noexcept : capacity{maxChunks} { }
+
+	// Waits for room and queues the chunk, returning false if it's not wanted as parsing has failed
+	bool push(readChunk_t &&chunk)
+	{
+		std::unique_lock<std::mutex> guard{lock};
+		changed.wait(guard, [&]() { return chunks.size() < capacity || !errors.empty(); });
+		if (!errors.empty())
+			return false;
+		chunks.emplace_back(std::move(chunk));
+		changed.notify_all();
+		return true;
+	}
+
+	// Waits for the next chunk, returning nothing once there are no more or parsing has failed
+	std::optional<readChunk_t> pop()
+	{
+		std::unique_lock<std::mutex> guard{lock};
+		changed.wait(guard, [&]() { return !chunks.empty() || closed || !errors.empty(); });
+		if (chunks.empty() || !errors.empty())
+			return std::nullopt;
+		auto chunk{std::move(chunks.front())};
+		chunks.pop_front();
+		changed.notify_all();
+		return chunk;
+	}
+
+	void close()
+	{
+		std::lock_guard<std::mutex> guard{lock};
+		closed = true;
+		changed.notify_all();
+	}
+
+	void fail(const size_t index, std::exception_ptr error)
+	{
+		std::lock_guard<std::mutex> guard{lock};
+		errors.emplace(index, std::move(error));
+		changed.notify_all();
+	}
+
+	bool failed()
+	{
+		std::lock_guard<std::mutex> guard{lock};
+		return !errors.empty();
+	}
+
+	// Throws the error from the earliest chunk that had one, if any did
+	void rethrow()
+	{
+		std::lock_guard<std::mutex> guard{lock};
+		if (!errors.empty())
+			std::rethrow_exception(errors.begin()->second);
+	}
+};
+
+// A set of worker threads, which are always joined before the set goes away
+struct workers_t final
+{
+private:
+	std::vector<std::thread> threads{};
+
+public:
+	workers_t() noexcept = default;
+	workers_t(const workers_t &) = delete;
+	workers_t(workers_t &&) = delete;
+	~workers_t() noexcept { join(); }
+	workers_t &operator =(const workers_t &) = delete;
+	workers_t &operator =(workers_t &&) = delete;
+
+	template<typename work_t> void spawn(const size_t count, const work_t &work)
+	{
+		threads.reserve(count);
+		for (size_t i{0U}; i < count; ++i)
+			threads.emplace_back(work);
+	}
+
+	void join() noexcept
+	{
+		for (auto &thread : threads)
+		{
+			if (thread.joinable())
+				thread.join();
+		}
+	}
+};
+
+size_t threadCount(const parallelOptions_t &options) noexcept
+{
+	if (options.threads)
+		return options.threads;
+	return std::max(std::thread::hardware_concurrency(), 1U);
+}
+
+// Parses each line of a chunk in turn, handing the documents to sink along with where their line starts
+template<typename sink_t> void parseLines(const std::string_view json, const size_t offset,
+	const parseLimits_t &limits, const sink_t &sink)
+{
+	if (json.empty())
+		return;
+	JSONParser parser{json};
+	// The byte limit is for the input as a whole, which the caller checks, rather than for each chunk
+	auto chunkLimits{limits};
+	chunkLimits.maxBytes = SIZE_MAX;
+	parser.limits(chunkLimits);
+	// Lines come straight out of the chunk, so this is never used
+	std::string storage{};
+	while (true)
+	{
+		parser.skipWhite();
+		if (parser.atEnd())
+			return;
+		const auto start{offset + parser.offset()};
+		sink(start, lineDocument(parser.line(storage), chunkLimits));
+	}
+}
+
+// Splits the input into chunks of at least chunkSize bytes (save for the last) that end at the end of a line
+std::vector<lineChunk_t> splitLines(const std::string_view json, const parallelOptions_t &options)
+{
+	if (json.size() > options.limits.maxBytes)
+		throw JSONParserError(JSON_PARSER_TOO_LARGE);
+	const auto chunkSize{options.chunkSize};
+	std::vector<lineChunk_t> chunks{};
+	size_t begin{0U};
+	while (begin < json.size())
+	{
+		const auto split{begin + std::max<size_t>(chunkSize, 1U)};
+		auto end{split < json.size() ? json.find('\n', split - 1U) : json.size()};
+		end = end == std::string_view::npos ? json.size() : end + 1U;
+		chunks.push_back({json.substr(begin, end - begin), begin});
+		begin = end;
+	}
+	return chunks;
+}
+
+// Hands the chunks out in order to the workers, stopping early if parsing one of them fails. As chunks are
+// taken in order, every chunk before the first one to fail is always parsed, so the error thrown is for
+// the earliest problem in the input.
+template<typename chunk_t, typename parse_t> void parseChunks(std::vector<chunk_t> &chunks,
+	const size_t threads, const parse_t &parse)
+{
+	if (chunks.empty())
+		return;
+	std::atomic<size_t> next{0U};
+	std::atomic<bool> failed{false};
+	const auto worker{[&]()
+	{
+		for (auto index{next++}; index < chunks.size() && !failed; index = next++)
+		{
+			auto &chunk{chunks[index]};
+			try
+				{ parse(chunk); }
+			catch (...)
+			{
+				chunk.error = std::current_exception();
+				failed = true;
+			}
+		}
+	}};
+
+	{
+		workers_t workers{};
+		workers.spawn(std::min(threads, chunks.size()) - 1U, worker);
+		worker();
+	}
+
+	for (const auto &chunk : chunks)
+	{
+		if (chunk.error)
+			std::rethrow_exception(chunk.error);
+	}
+}
+
+std::vector<std::unique_ptr<JSONAtom>> rSON::parseJSONLines(const std::string_view json,
+	const parallelOptions_t &options)
+{
+	auto chunks{splitLines(json, options)};
+	if (chunks.empty())
+		return {};
+	parseChunks(chunks, threadCount(options), [&](lineChunk_t &chunk)
+	{
+		parseLines(chunk.json, chunk.offset, options.limits,
+			[&](size_t, std::unique_ptr<JSONAtom> &&result) { chunk.documents.emplace_back(std::move(result)); });
+	});
+
+	size_t count{0U};
+	for (const auto &chunk : chunks)
+		count += chunk.documents.size();
+	std::vector<std::unique_ptr<JSONAtom>> documents{};
+	documents.reserve(count);
+	for (auto &chunk : chunks)
+		std::move(chunk.documents.begin(), chunk.documents.end(), std::back_inserter(documents));
+	return documents;
+}
+
+std::vector<std::unique_ptr<JSONAtom>> rSON::parseJSONLines(const std::string_view json)
+	{ return parseJSONLines(json, parallelOptions_t{}); }
+
+void rSON::parseJSONLines(const std::string_view json, const recordHandler_t &handler,
+	const parallelOptions_t &options)
+{
+	auto chunks{splitLines(json, options)};
+	if (chunks.empty())
+		return;
+	parseChunks(chunks, threadCount(options), [&](lineChunk_t &chunk)
+	{
+		parseLines(chunk.json, chunk.offset, options.limits,
+			[&](const size_t offset, std::unique_ptr<JSONAtom> &&result) { handler(offset, std::move(result)); });
+	});
+}
+
+void rSON::parseJSONLines(const std::string_view json, const recordHandler_t &handler)
+	{ parseJSONLines(json, handler, parallelOptions_t{}); }
+
+void rSON::parseJSONLines(stream_t &json, const recordHandler_t &handler, const parallelOptions_t &options)
+{
+	const auto threads{threadCount(options)};
+	const auto chunkSize{std::max<size_t>(options.chunkSize, 1U)};
+	chunkQueue_t queue{threads * 2U};
+	const auto worker{[&]()
+	{
+		while (auto chunk{queue.pop()})
+		{
+			try
+			{
+				parseLines(chunk->json, chunk->offset, options.limits,
+					[&](const size_t offset, std::unique_ptr<JSONAtom> &&result)
+						{ handler(offset, std::move(result)); });
+			}
+			catch (...)
+				{ queue.fail(chunk->index, std::current_exception()); }
+		}
+	}};
+
+	{
+		workers_t workers{};
+		try
+		{
+			workers.spawn(threads, worker);
+			// The start of a line that didn't fit in the last chunk, to go at the front of the next
+			std::string carry{};
+			size_t offset{0U};
+			size_t index{0U};
+			bool eof{false};
+			while (!eof && !queue.failed())
+			{
+				auto block{std::move(carry)};
+				const auto used{block.size()};
+				block.resize(used + chunkSize);
+				size_t actualLen{0U};
+				eof = json.atEOF() || !json.read(block.data() + used, chunkSize, actualLen) || json.atEOF();
+				// As with JSONParser, a stream reporting EOF as it hands over its final byte is using
+				// that byte as a terminator
+				if (actualLen && json.atEOF())
+					--actualLen;
+				block.resize(used + actualLen);
+				if (offset + block.size() > options.limits.maxBytes)
+					throw JSONParserError(JSON_PARSER_TOO_LARGE);
+
+				// Hand over everything up to the end of the last complete line. The carried part has
+				// no newlines in it, so only what was just read needs looking through.
+				auto split{block.size()};
+				if (!eof)
+				{
+					const auto newline{std::string_view{block}.substr(used).rfind('\n')};
+					split = newline == std::string_view::npos ? 0U : used + newline + 1U;
+				}
+				carry = block.substr(split);
+				block.resize(split);
+				if (block.empty())
+					continue;
+				const auto length{block.size()};
+				if (!queue.push({std::move(block), offset, index++}))
+					break;
+				offset += length;
+			}
+		}
+		catch (...)
+		{
+			queue.close();
+			throw;
+		}
+		queue.close();
+	}
+	queue.rethrow();
+}
+
+void rSON::parseJSONLines(stream_t &json, const recordHandler_t &handler)
+	{ parseJSONLines(json, handler, parallelOptions_t{}); }
+
+std::unique_ptr<JSONAtom> rSON::parseJSON(const std::string_view json, const parallelOptions_t &options)
+{
+	JSONParser parser{json};
+	parser.limits(options.limits);
+	const auto threads{threadCount(options)};
+	const auto open{parser.currentChar()};
+	// Counting the values in the whole document can't be split up, so a node limit means parsing as normal
+	if ((open != '{' && open != '[') || threads == 1U || json.size() <= options.chunkSize ||
+		!options.limits.maxDepth || options.limits.maxNodes != SIZE_MAX)
+		return document(parser);
+	const bool isObject{open == '{'};
+	const char close{isObject ? '}' : ']'};
+
+	// Find where each member starts, only checking that brackets match and strings are terminated for now
+	std::vector<member_t> members{};
+	parser.match(open, true);
+	if (parser.currentChar() != close)
+	{
+		while (true)
+		{
+			if (members.size() == options.limits.maxMembers)
+				throw JSONParserError(JSON_PARSER_TOO_LARGE);
+			member_t member{};
+			if (isObject)
+			{
+				member.key = parser.string();
+				parser.match(':', true);
+			}
+			member.offset = parser.offset();
+			parser.skipValue();
+			parser.skipWhite();
+			members.emplace_back(std::move(member));
+			if (parser.currentChar() != ',')
+				break;
+			parser.match(',', true);
+		}
+	}
+	parser.match(close, false);
+	// An empty object or array padded out past the chunk size has nothing to hand out
+	if (members.empty())
+	{
+		if (isObject)
+			return std::make_unique<JSONObject>();
+		return std::make_unique<JSONArray>();
+	}
+
+	std::vector<memberChunk_t> chunks{};
+	for (size_t begin{0U}; begin < members.size();)
+	{
+		auto end{begin + 1U};
+		while (end < members.size() && members[end].offset - members[begin].offset < options.chunkSize)
+			++end;
+		chunks.push_back({begin, end});
+		begin = end;
+	}
+
+	// Each member is parsed with what's left of the nesting limit once inside the outermost object or array
+	auto limits{options.limits};
+	--limits.maxDepth;
+	std::vector<std::unique_ptr<JSONAtom>> values(members.size());
+	parseChunks(chunks, threads, [&](memberChunk_t &chunk)
+	{
+		for (auto index{chunk.begin}; index < chunk.end; ++index)
+		{
+			JSONParser memberParser{json, members[index].offset, parser.index(), nullptr};
+			memberParser.borrowStrings(false);
+			memberParser.limits(limits);
+			values[index] = value(memberParser);
+		}
+	});
+
+	if (isObject)
+	{
+		auto object{makeOpaque<object_t>()};
+		for (size_t index{0U}; index < members.size(); ++index)
+			addMember(parser, object, std::move(members[index].key), std::move(values[index]), limits.duplicateKeys);
+		return std::make_unique<JSONObject>(std::move(object));
+	}
+	auto array{std::make_unique<JSONArray>()};
+	for (auto &member : values)
+		array->add(std::move(member));
+	return array;
+}
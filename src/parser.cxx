@@ -7,17 +7,23 @@
 // SPDX-FileContributor: Modified by Aki Van Ness <aki@lethalbit.net>
 
 #include <string.h>
+#include <ctype.h>
 #include <math.h>
 #include <stdio.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <iterator>
 
 #if defined(_MSC_VER) || defined(__MACOS__) || defined(__MACOSX__) || defined(__APPLE__)
 #define pow10(x) pow(10.0, (int)x)
 #endif
 #ifndef _WIN32
 #include <unistd.h>
+#include <sys/mman.h>
 #else
 #include <io.h>
 #define O_NOCTTY O_BINARY
@@ -26,29 +32,57 @@
 #include "internal/types.hxx"
 #include "internal/parser.hxx"
 
-// Recognise lower-case letters
-inline bool isLowerAlpha(const char x) noexcept
+// The lexical class of each character, which is what drives token dispatch
+enum class charClass_t : uint8_t
 {
-	return x >= 'a' && x <= 'z';
-}
+	other,
+	whiteSpace,
+	objectBegin,
+	objectEnd,
+	arrayBegin,
+	arrayEnd,
+	quote,
+	colon,
+	comma,
+	minus,
+	digit,
+	lowerAlpha
+};
 
-// Recognise ASCII control characters
-inline bool isControl(const char x) noexcept
+constexpr std::array<charClass_t, 256> makeCharClasses() noexcept
 {
-	return (x >= 0 && x <= 0x1F) || x == 0x7F;
+	std::array<charClass_t, 256> classes{};
+	classes[' '] = charClass_t::whiteSpace;
+	classes['\t'] = charClass_t::whiteSpace;
+	classes['\n'] = charClass_t::whiteSpace;
+	classes['\r'] = charClass_t::whiteSpace;
+	classes['{'] = charClass_t::objectBegin;
+	classes['}'] = charClass_t::objectEnd;
+	classes['['] = charClass_t::arrayBegin;
+	classes[']'] = charClass_t::arrayEnd;
+	classes['"'] = charClass_t::quote;
+	classes[':'] = charClass_t::colon;
+	classes[','] = charClass_t::comma;
+	classes['-'] = charClass_t::minus;
+	for (char chr{'0'}; chr <= '9'; ++chr)
+		classes[uint8_t(chr)] = charClass_t::digit;
+	for (char chr{'a'}; chr <= 'z'; ++chr)
+		classes[uint8_t(chr)] = charClass_t::lowerAlpha;
+	return classes;
 }
 
-// Recognise characters in the file which are deemed in the JSON alphabet
-inline bool isAllowedAlpha(const char x) noexcept
-{
-	return x != '"' && x != '\\' && isControl(x) == false;
-}
+constexpr auto charClasses{makeCharClasses()};
+
+inline charClass_t classOf(const char x) noexcept
+	{ return charClasses[uint8_t(x)]; }
+
+// Recognise lower-case letters
+inline bool isLowerAlpha(const char x) noexcept
+	{ return classOf(x) == charClass_t::lowerAlpha; }
 
 // Recognise standard English numbers
 inline bool isNumber(const char x) noexcept
-{
-	return x >= '0' && x <= '9';
-}
+	{ return classOf(x) == charClass_t::digit; }
 
 inline bool isMinus(const char x) noexcept
 	{ return x == '-'; }
@@ -95,16 +129,15 @@ inline bool isExponent(const char x) noexcept
 	return x == 'e' || x == 'E';
 }
 
-// Recognise a new line character OS agnoistically
-inline bool isNewLine(const char x) noexcept
-{
-	return x == '\n' || x == '\r';
-}
-
 // Recognise whitespace
 inline bool isWhiteSpace(const char x) noexcept
+	{ return classOf(x) == charClass_t::whiteSpace; }
+
+// Checks for the characters that may follow a backslash in a string, other than the 'u' of a unicode escape
+inline bool isEscape(const char x) noexcept
 {
-	return x == ' ' || x == '\t' || isNewLine(x);
+	return x == '"' || x == '\\' || x == '/' || x == 'b' ||
+		x == 'f' || x == 'n' || x == 'r' || x == 't';
 }
 
 // Recognise a hexadecimal digit
@@ -130,234 +163,625 @@ inline bool isBasePrefix(const char x) noexcept
 	return x == 'x' || x == 'b' || x == 'o';
 }
 
-JSONParser::JSONParser(stream_t &toParse) : json(toParse), next(0), lastWasComma(false)
-	{ nextChar(); }
+// Only streams known to end where their input does are read a block at a time. Any other stream may be
+// framing messages, as rpcStream_t does, and reading past the end of one would swallow the start of the
+// next - so those are read a byte at a time, and the parser never takes more from them than it needs.
+size_t JSONParser::readLength(const stream_t &stream) noexcept
+{
+	if (dynamic_cast<const memoryStream_t *>(&stream) || dynamic_cast<const fileStream_t *>(&stream) ||
+		dynamic_cast<const readAheadStream_t *>(&stream))
+		return bufferLength;
+	return 1U;
+}
+
+JSONParser::JSONParser(stream_t &toParse, const errorMode_t mode) : JSONParser{toParse, nullptr, mode} { }
+
+// Sets the parser up to read from toParse, using window for the input window if one is given
+JSONParser::JSONParser(stream_t &toParse, std::unique_ptr<char []> &&window, const errorMode_t mode) :
+	json{&toParse}, blockLength{readLength(toParse)},
+	buffer{window ? std::move(window) : std::unique_ptr<char []>{new char[bufferLength]}},
+	pos{buffer.get()}, end{buffer.get()}, windowOffset{0U}, windowLines{0U}, windowLineStart{0U}, base{nullptr},
+	structurals{}, parseLimits{}, inSitu{false}, owner{}, pool{nullptr}, nodeArena{}, errorMode{mode}, failure{}
+{
+	if (!fillBuffer())
+	{
+		// Hand the window back so a caller that lent us one doesn't lose it
+		if (errorMode == errorMode_t::throwErrors)
+			window = std::move(buffer);
+		fail(JSON_PARSER_EOF);
+	}
+}
+
+JSONParser::JSONParser(const std::string_view toParse) : JSONParser{toParse, structuralIndex_t{}} { }
 
-void JSONParser::nextChar()
+// Sets the parser up to work directly on toParse, indexing it first if it's large enough to benefit.
+// The index is built in the bitmap of index if that can be reused.
+JSONParser::JSONParser(const std::string_view toParse, structuralIndex_t &&index) : json{nullptr},
+	blockLength{0U}, buffer{}, pos{toParse.data()}, end{toParse.data() + toParse.length()}, windowOffset{0U}, windowLines{0U}, windowLineStart{0U},
+	base{toParse.data()}, structurals{}, parseLimits{}, inSitu{false}, owner{}, pool{nullptr},
+	nodeArena{}, errorMode{errorMode_t::throwErrors}, failure{}
 {
-	if (json.atEOF())
+	if (pos == end)
 		throw JSONParserError(JSON_PARSER_EOF);
-	json.read(next);
+	if (toParse.length() >= indexThreshold)
+		structurals = structuralIndex_t{toParse, std::move(index)};
+}
+
+// Sets the parser up for in-situ parsing of toParse, which toParseOwner (if set) keeps alive
+JSONParser::JSONParser(const std::string_view toParse, std::shared_ptr<const std::string> toParseOwner) :
+	JSONParser{toParse}
+{
+	inSitu = true;
+	owner = std::move(toParseOwner);
+}
+// Resumes parsing a document from part way in, such as for a container of a lazily parsed document
+JSONParser::JSONParser(const std::string_view toParse, const size_t offset, const structuralIndex_t &index,
+	std::shared_ptr<const std::string> toParseOwner) : json{nullptr}, blockLength{0U}, buffer{},
+	pos{toParse.data() + offset},
+	end{toParse.data() + toParse.length()}, windowOffset{0U}, windowLines{0U}, windowLineStart{0U},
+	base{toParse.data()}, structurals{index}, parseLimits{}, inSitu{true}, owner{std::move(toParseOwner)},
+	pool{nullptr}, nodeArena{}, errorMode{errorMode_t::throwErrors}, failure{}
+{
+	if (pos >= end)
+		throw JSONParserError(JSON_PARSER_EOF);
+}
+
+// Pulls the next block of input from the stream into the window, returning false on EOF.
+// A stream that reports EOF as soon as it hands us its final byte (memoryStream_t, rpcStream_t)
+// is using that byte as a terminator, so it is not made part of the window.
+bool JSONParser::fillBuffer()
+{
+	// When parsing from memory, running out of window is running out of input, as is having failed
+	if (!json || failure)
+		return false;
+	// Keep count of the lines in the window before it's replaced, so positions can still be worked out
+	const char *const begin{buffer.get()};
+	const auto lines{size_t(std::count(begin, end, '\n'))};
+	if (lines)
+	{
+		windowLines += lines;
+		const auto lineEnd{std::find(std::make_reverse_iterator(end), std::make_reverse_iterator(begin), '\n')};
+		windowLineStart = windowOffset + size_t(lineEnd.base() - begin);
+	}
+	windowOffset += size_t(end - buffer.get());
+	pos = end = buffer.get();
+	if (json->atEOF())
+		return false;
+	size_t actualLen = 0;
+	json->read(buffer.get(), blockLength, actualLen);
+	if (actualLen && json->atEOF())
+		--actualLen;
+	end += actualLen;
+	if (windowOffset + actualLen > parseLimits.maxBytes)
+	{
+		fail(JSON_PARSER_TOO_LARGE);
+		return false;
+	}
+	return pos != end;
+}
+
+void JSONParser::limits(const parseLimits_t &newLimits)
+{
+	parseLimits = newLimits;
+	// For in-memory input, the window is all of it
+	const auto length{json ? windowOffset + size_t(end - buffer.get()) : size_t(end - base)};
+	if (length > parseLimits.maxBytes)
+		fail(JSON_PARSER_TOO_LARGE);
+}
+
+// When keeping status, only the first problem is kept - anything after it is fallout from the input being
+// cut off at it. Keeping the problem's position means the window is cut off at pos rather than emptied.
+void JSONParser::fail(const JSONParserErrorType error)
+{
+	if (errorMode == errorMode_t::throwErrors)
+		throw JSONParserError(error);
+	if (failure)
+		return;
+	failure = error;
+	end = pos;
+}
+
+textPosition_t JSONParser::position() const noexcept
+{
+	const char *const begin{json ? buffer.get() : base};
+	const auto lines{size_t(std::count(begin, pos, '\n'))};
+	if (!lines)
+		return {windowLines + 1U, offset() - windowLineStart + 1U};
+	const auto lineEnd{std::find(std::make_reverse_iterator(pos), std::make_reverse_iterator(begin), '\n')};
+	return {windowLines + lines + 1U, size_t(pos - lineEnd.base()) + 1U};
 }
 
 // This function intentionally ignores EOF to prevent the
 // parser from exiting via exception when it sees the final } or ]
 void JSONParser::skipWhite()
 {
-	while (!json.atEOF() && isWhiteSpace(currentChar()))
-		nextChar();
+	// Outside of a string, the first non-whitespace character after whitespace is always indexed
+	if (structurals.valid())
+	{
+		if (pos != end && isWhiteSpace(*pos))
+			pos = base + structurals.next(size_t(pos - base));
+		return;
+	}
+
+	while (pos != end)
+	{
+		while (pos != end && isWhiteSpace(*pos))
+			++pos;
+		if (pos != end || !fillBuffer())
+			break;
+	}
+}
+
+// Reads the rest of the current line and the newline ending it, returning the line without its newline.
+// In-memory input is returned in place, but a line read from a stream may span several windows, so it is
+// gathered up in storage.
+std::string_view JSONParser::line(std::string &storage)
+{
+	storage.clear();
+	while (true)
+	{
+		const auto *const newline{static_cast<const char *>(memchr(pos, '\n', size_t(end - pos)))};
+		const char *const lineEnd{newline ? newline : end};
+		if (!json)
+		{
+			const std::string_view result{pos, size_t(lineEnd - pos)};
+			pos = newline ? newline + 1 : end;
+			return result;
+		}
+		storage.append(pos, lineEnd);
+		if (newline)
+		{
+			pos = newline + 1;
+			return storage;
+		}
+		pos = end;
+		if (!fillBuffer())
+			return storage;
+	}
 }
 
 // Match the current character with x, and skip whitespace if skip == true.
-// Throws an exception if x and the current character do not match.
+// Fails if x and the current character do not match.
 void JSONParser::match(const char x, const bool skip)
 {
 	if (currentChar() == x)
 	{
-		lastWasComma = x == ',';
 		nextChar();
 		if (skip)
 			skipWhite();
 	}
 	else
-		throw JSONParserError(JSON_PARSER_BAD_JSON);
+		fail(JSON_PARSER_BAD_JSON);
 }
 
-bool JSONParser::lastTokenComma() const noexcept { return lastWasComma; }
-void JSONParser::lastNoComma() noexcept { lastWasComma = false; }
 
-char JSONParser::currentChar()
+// Matches one of the literals "true", "false" and "null". When the window holds all of the
+// literal and the character after it, this is a single fixed-width compare.
+literal_t JSONParser::literal()
 {
-	if (json.atEOF())
-		throw JSONParserError(JSON_PARSER_EOF);
-	return next;
+	const auto match = [this](const char *const word, const size_t length)
+	{
+		if (size_t(end - pos) > length && memcmp(pos, word, length) == 0)
+			pos += length;
+		else
+		{
+			for (size_t i{0}; i < length; ++i)
+			{
+				if (currentChar() != word[i])
+					return fail(JSON_PARSER_BAD_JSON);
+				nextChar();
+			}
+		}
+	};
+
+	literal_t literal{};
+	switch (currentChar())
+	{
+		case 't':
+			match("true", 4U);
+			literal = literal_t::trueValue;
+			break;
+		case 'f':
+			match("false", 5U);
+			literal = literal_t::falseValue;
+			break;
+		case 'n':
+			match("null", 4U);
+			literal = literal_t::nullValue;
+			break;
+		default:
+			fail(JSON_PARSER_BAD_JSON);
+			return literal_t::nullValue;
+	}
+	// The literal must end here, not just start with one of the three words
+	if (isLowerAlpha(currentChar()))
+		fail(JSON_PARSER_BAD_JSON);
+	skipWhite();
+	return literal;
 }
 
-inline char pop(std::queue<char> &queue) noexcept
+// Skips over the string at the current position without decoding it, only checking that it's terminated,
+// contains no control characters and that its escapes are valid
+void JSONParser::skipString()
 {
-	char result = queue.front();
-	queue.pop();
-	return result;
+	match('"', false);
+	if (failed())
+		return;
+	const auto start{offset()};
+	while (true)
+	{
+		pos = findStringSpecial(pos, end);
+		if (pos == end)
+		{
+			checkString(start);
+			if (!fillBuffer())
+				return fail(JSON_PARSER_EOF);
+			continue;
+		}
+		const auto chr{*pos};
+		if (isQuote(chr))
+			break;
+		else if (!isSlash(chr))
+			return fail(JSON_PARSER_BAD_JSON);
+		// Skip the backslash, checking the escape it starts is one that's allowed
+		nextChar();
+		const auto escape{currentChar()};
+		if (escape != 'u' && !isEscape(escape))
+			return fail(JSON_PARSER_BAD_JSON);
+		nextChar();
+		if (escape == 'u')
+		{
+			for (size_t i{0}; i < 4U; ++i)
+			{
+				if (!isHex(currentChar()))
+					return fail(JSON_PARSER_BAD_JSON);
+				nextChar();
+			}
+		}
+	}
+	checkString(start);
+	match('"', true);
 }
 
-// Parses an alpha-numeric literal
-char *JSONParser::literal()
+// Skips over the object or array at the current position by matching up its brackets, without otherwise
+// checking it. With an index, only the indexed positions need looking at - brackets are never marked
+// inside strings.
+void JSONParser::skipContainer()
 {
-	if (!isLowerAlpha(currentChar()))
-		throw JSONParserError(JSON_PARSER_BAD_JSON);
-	std::queue<char> result;
+	// Keep the kind of each bracket still open so one closed by the other kind is caught
+	std::string nesting{};
+	// A bracket closed by the other kind fails and ends the container there
+	const auto closes = [&](const char chr) -> bool
+	{
+		if (isObjectBegin(chr) || isArrayBegin(chr))
+			nesting += chr;
+		else if (isObjectEnd(chr) || isArrayEnd(chr))
+		{
+			if (isObjectEnd(chr) != isObjectBegin(nesting.back()))
+			{
+				fail(JSON_PARSER_BAD_JSON);
+				return true;
+			}
+			nesting.pop_back();
+			return nesting.empty();
+		}
+		return false;
+	};
 
-	while (isLowerAlpha(currentChar()))
+	if (structurals.valid())
 	{
-		result.push(currentChar());
-		nextChar();
+		const size_t length{size_t(end - base)};
+		for (size_t offset{size_t(pos - base)}; offset != length; offset = structurals.next(offset + 1U))
+		{
+			const auto chr{base[offset]};
+			pos = base + offset;
+			if (closes(chr))
+			{
+				match(chr, true);
+				return;
+			}
+		}
+		pos = end;
+		return fail(JSON_PARSER_EOF);
 	}
-	skipWhite();
 
-	return [&](char *const literal) noexcept -> char *
+	while (!failed())
 	{
-		literal[result.size()] = 0;
-		for (size_t i = 0; !result.empty(); ++i)
-			literal[i] = pop(result);
-		return literal;
-	}(new char[result.size() + 1]);
+		const auto chr{currentChar()};
+		if (isQuote(chr))
+		{
+			skipString();
+			continue;
+		}
+		nextChar();
+		if (closes(chr))
+		{
+			skipWhite();
+			return;
+		}
+	}
 }
 
-// Verifies a \u sequence
-void JSONParser::validateUnicodeSequence(std::queue<char> &result)
+// Skips over the value at the current position. Scalars are checked as normal, but nothing is built from them
+void JSONParser::skipValue()
 {
-	char len = 0;
-	for (len = 0; len < 4; len++)
+	switch (classOf(currentChar()))
 	{
-		result.push(currentChar());
-		nextChar();
-		if (!isHex(currentChar()))
+		case charClass_t::objectBegin:
+		case charClass_t::arrayBegin:
+			skipContainer();
+			break;
+		case charClass_t::quote:
+			skipString();
 			break;
+		case charClass_t::minus:
+		case charClass_t::digit:
+			number();
+			break;
+		default:
+			literal();
 	}
-	if (len != 4)
-		throw JSONParserError(JSON_PARSER_BAD_JSON);
 }
 
-// Parses a string per the JSON string rules
-std::string JSONParser::string()
+// Parses a string per the JSON string rules. Runs of plain characters are found a vector at a time and
+// taken whole, while escapes are checked and - if decode is true - decoded to UTF-8 as they are met.
+// The result is a view of the string in the input when it needed no decoding and the input is the caller's
+// memory; otherwise the string is assembled in storage, which the view then refers to.
+std::string_view JSONParser::string(std::string &storage, const bool decode)
 {
 	match('"', false);
-	bool slash = false;
-	std::queue<char> result;
+	if (failed())
+		return {};
+	const char *begin = pos;
+	const auto start{offset()};
+
+	// With an index, the closing quote is the next indexed position - if nothing between
+	// here and there needs looking at more closely, the whole string can be taken in one go
+	if (structurals.valid())
+	{
+		const char *const close{base + structurals.next(size_t(pos - base))};
+		if (close != end && isQuote(*close) && findStringSpecial(pos, close) == close)
+		{
+			pos = close;
+			checkString(start);
+			match('"', true);
+			return {begin, size_t(close - begin)};
+		}
+	}
+
+	// Escapes may straddle input blocks, so they are read a character at a time
+	const auto escapeChar = [this]() -> char
+	{
+		if (pos == end && !fillBuffer())
+		{
+			fail(JSON_PARSER_EOF);
+			return '\0';
+		}
+		return *pos++;
+	};
 
-	while (!isQuote(currentChar()) || slash)
+	escapeDecoder_t decoder{};
+	char decoded[escapeDecoder_t::maxLength];
+	bool escaped{false};
+	while (true)
 	{
-		if (slash)
+		pos = findStringSpecial(pos, end);
+		if (decode && pos != begin)
+			storage.append(decoded, decoder.flush(decoded));
+		if (pos == end)
 		{
-			switch (currentChar())
+			checkString(start);
+			storage.append(begin, pos);
+			if (!fillBuffer())
 			{
-				case '"':
-				case '\\':
-				case '/':
-				case 'b':
-				case 'f':
-				case 'n':
-				case 'r':
-				case 't':
-					break;
-				case 'u':
-					validateUnicodeSequence(result);
-					// Make sure there are 4 hex characters here
-					break;
-				default:
-					throw JSONParserError(JSON_PARSER_BAD_JSON);
+				fail(JSON_PARSER_EOF);
+				return {};
+			}
+			begin = pos;
+			continue;
+		}
+		else if (isQuote(*pos))
+			break;
+		else if (!isSlash(*pos))
+		{
+			fail(JSON_PARSER_BAD_JSON);
+			return {};
+		}
+
+		storage.append(begin, pos);
+		++pos;
+		escaped = true;
+		const char escape{escapeChar()};
+		char hex[4]{};
+		if (escape == 'u')
+		{
+			for (auto &digit : hex)
+			{
+				digit = escapeChar();
+				if (!isHex(digit))
+				{
+					fail(JSON_PARSER_BAD_JSON);
+					return {};
+				}
 			}
-			slash = false;
 		}
+		else if (!isEscape(escape))
+		{
+			fail(JSON_PARSER_BAD_JSON);
+			return {};
+		}
+		if (decode)
+			storage.append(decoded, decoder.decode(escape, hex, decoded));
 		else
 		{
-			slash = isSlash(currentChar());
-			if (!slash && !isAllowedAlpha(currentChar()))
-				throw JSONParserError(JSON_PARSER_BAD_JSON);
+			storage += '\\';
+			storage += escape;
+			if (escape == 'u')
+				storage.append(hex, sizeof(hex));
 		}
-		result.push(currentChar());
-		nextChar();
+		begin = pos;
 	}
 
-	match('"', true);
-	return [&]() noexcept
+	checkString(start);
+	// A high surrogate held back by the decoder and never paired still has to be written out
+	const auto flushed{decode ? decoder.flush(decoded) : 0U};
+	std::string_view result{};
+	// The window only stays valid past the closing quote when it is the caller's memory
+	if (json || escaped || flushed)
 	{
-		std::string string(result.size(), '\0');
-		for (size_t i = 0; !result.empty(); ++i)
-			string[i] = pop(result);
-		return string;
-	}();
+		storage.append(begin, pos);
+		storage.append(decoded, flushed);
+		result = storage;
+	}
+	else
+		result = {begin, size_t(pos - begin)};
+	match('"', true);
+	return result;
+}
+
+// Parses a string, returning it as written (with any escapes intact)
+std::string JSONParser::string()
+{
+	std::string storage{};
+	const auto result{string(storage, false)};
+	if (result.data() != storage.data())
+		return std::string{result};
+	return storage;
 }
 
-// Parses a positive natural number
-size_t JSONParser::number(const bool zeroSpecial, size_t *const decDigits)
+// Parses the digits of a hexadecimal, octal or binary literal, starting from its base prefix.
+// Literals of up to 64 bits are returned in integer, while larger ones are returned as a double in value.
+bool JSONParser::prefixedNumber(uint64_t &integer, double &value)
 {
 	uint8_t base{10};
 	bool (*isValidDigit)(const char) = isNumber;
-
-	const auto nextDigit = [=]()
+	if (currentChar() == 'x')
 	{
-		if (decDigits)
-			++(*decDigits);
-		nextChar();
-	};
-
-	if (!isNumber(currentChar()))
-		throw JSONParserError(JSON_PARSER_BAD_JSON);
+		base = 16;
+		isValidDigit = isHex;
+	}
+	else if (currentChar() == 'o')
+	{
+		base = 8;
+		isValidDigit = isOct;
+	}
+	else if (currentChar() == 'b')
+	{
+		base = 2;
+		isValidDigit = isBin;
+	}
+	else
+	{
+		fail(JSON_PARSER_BAD_JSON);
+		return true;
+	}
+	nextChar();
 
-	if (zeroSpecial && currentChar() == '0')
+	integer = 0U;
+	bool fits{true};
+	while (isValidDigit(currentChar()))
 	{
-		nextDigit();
-		if (!isBasePrefix(currentChar()))
+		auto digit{static_cast<uint8_t>(toupper(currentChar()) - '0')};
+		if (digit > 9U)
+			digit -= 7U;
+
+		if (fits && integer > (UINT64_MAX - digit) / base)
 		{
-			if (isNumber(currentChar()))
-				throw JSONParserError(JSON_PARSER_BAD_JSON);
-			return 0;
+			fits = false;
+			value = double(integer);
 		}
+		if (fits)
+			integer = (integer * base) + digit;
 		else
-		{
-			if (currentChar() == 'x')
-			{
-				base = 16;
-				isValidDigit = isHex;
-			}
-			else if (currentChar() == 'o')
-			{
-				base = 8;
-				isValidDigit = isOct;
-			}
-			else if (currentChar() == 'b')
-			{
-				base = 2;
-				isValidDigit = isBin;
-			}
+			value = (value * base) + digit;
+		nextChar();
+	}
+	return fits;
+}
 
+// Parses a run of decimal digits into value, 8 at a time while the window has that many left in it
+void JSONParser::digits(decimal_t &value, const bool fraction)
+{
+	while (true)
+	{
+		while (end - pos >= 8)
+		{
+			const auto chars{loadEightChars(pos)};
+			if (!isEightDigits(chars) || !value.append(pos, chars, fraction))
+				break;
+			pos += 7;
 			nextChar();
 		}
+		if (!isNumber(currentChar()))
+			break;
+		value.append(currentChar(), fraction);
+		nextChar();
 	}
+}
 
-	size_t num = 0;
-	while (isValidDigit(currentChar()))
+// Parses the digits of a number's exponent. Exponents too large to matter are clamped.
+int64_t JSONParser::exponent()
+{
+	if (!isNumber(currentChar()))
 	{
-		auto digit{static_cast<uint8_t>(currentChar()  - '0')};
-		if (digit > 9U)
-			digit -= 7U;
+		fail(JSON_PARSER_BAD_JSON);
+		return 0;
+	}
+	else if (currentChar() == '0')
+	{
+		nextChar();
+		if (isNumber(currentChar()))
+			fail(JSON_PARSER_BAD_JSON);
+		return 0;
+	}
 
-		num *= base;
-		num += digit;
-		nextDigit();
+	int64_t exponent{0};
+	while (isNumber(currentChar()))
+	{
+		if (exponent < maxExponent)
+			exponent = (exponent * 10) + (currentChar() - '0');
+		nextChar();
 	}
-	return num;
+	return exponent;
 }
 
-// Parses an object
-std::unique_ptr<JSONAtom> object(JSONParser &parser)
+// Turns a string read by the parser into a JSONString, borrowing it from the input when parsing in situ
+// and otherwise sharing the interned copy of it if there is a pool to intern it in
+std::unique_ptr<JSONAtom> string(JSONParser &parser, const std::string_view value, std::string &storage)
 {
-	auto object{std::make_unique<JSONObject>()};
-	parser.match('{', true);
-	while (isObjectEnd(parser.currentChar()) == false)
+	if (value.data() != storage.data() && parser.borrowStrings())
+		return std::make_unique<JSONString>(makeOpaque<string_t>(borrow, value, parser.stringOwner()));
+	if (auto *const pool{parser.stringPool()}; pool && pool->interns(value.length()))
 	{
-		auto key{parser.string()};
-		parser.match(':', true);
-		object->add(std::move(key), expression(parser));
+		const auto &interned{pool->intern(value)};
+		return std::make_unique<JSONString>(makeOpaque<string_t>(borrow, *interned, interned));
 	}
-	if (parser.lastTokenComma())
+	if (value.data() != storage.data())
+		storage = value;
+	return std::make_unique<JSONString>(makeOpaque<string_t>(unescaped, std::move(storage)));
+}
+
+std::unique_ptr<JSONAtom> string(JSONParser &parser)
+{
+	std::string storage{};
+	const auto value{parser.string(storage, true)};
+	return string(parser, value, storage);
+}
+
+// Parses an object
+std::unique_ptr<JSONAtom> object(JSONParser &parser)
+{
+	if (!isObjectBegin(parser.currentChar()))
 		throw JSONParserError(JSON_PARSER_BAD_JSON);
-	parser.match('}', true);
-	return object;
+	return value(parser);
 }
 
 // Parses an array
 std::unique_ptr<JSONAtom> array(JSONParser &parser)
 {
-	auto array{std::make_unique<JSONArray>()};
-	parser.match('[', true);
-	while (!isArrayEnd(parser.currentChar()))
-		array->add(expression(parser));
-	if (parser.lastTokenComma())
+	if (!isArrayBegin(parser.currentChar()))
 		throw JSONParserError(JSON_PARSER_BAD_JSON);
-	parser.match(']', true);
-	return array;
+	return value(parser);
 }
 
 // Raise 10 to the power of power.
@@ -370,141 +794,1765 @@ size_t power10(size_t power)
 	return ret;
 }
 
-// Parses a JSON number, using the positive natural parser.
-std::unique_ptr<JSONAtom> number(JSONParser &parser)
+// Skips over the number at the current position, checking it as number() does without working out its value
+void JSONParser::skipNumber()
+{
+	const auto skipDigits = [this]()
+	{
+		while (isNumber(currentChar()))
+			nextChar();
+	};
+
+	if (isMinus(currentChar()))
+		nextChar();
+	if (!isNumber(currentChar()))
+		return fail(JSON_PARSER_BAD_JSON);
+	else if (currentChar() == '0')
+	{
+		nextChar();
+		if (isBasePrefix(currentChar()))
+		{
+			uint64_t integer{};
+			double approximate{};
+			prefixedNumber(integer, approximate);
+			return skipWhite();
+		}
+		else if (isNumber(currentChar()))
+			return fail(JSON_PARSER_BAD_JSON);
+	}
+	else
+		skipDigits();
+
+	if (currentChar() == '.')
+	{
+		nextChar();
+		if (!isNumber(currentChar()))
+			return fail(JSON_PARSER_BAD_JSON);
+		skipDigits();
+	}
+	if (isExponent(currentChar()))
+	{
+		nextChar();
+		if (currentChar() == '-' || currentChar() == '+')
+			nextChar();
+		exponent();
+	}
+	skipWhite();
+}
+
+// Parses a JSON number. Numbers without a fractional part are integers when they can be represented
+// exactly as one, and all other numbers are converted to the nearest double.
+number_t JSONParser::number()
 {
-	bool sign = false, mulSign = false;
-	int64_t integer = 0;
-	size_t decimal = 0, decDigits = 0, multiplier = 0;
-	bool decimalValid = false;
+	decimal_t value{};
+	bool integral{true};
 
-	if (parser.currentChar() == '-')
+	if (isMinus(currentChar()))
 	{
-		parser.match('-', false);
-		sign = true;
+		match('-', false);
+		value.negative = true;
 	}
-	integer = parser.number(true);
-	if (parser.currentChar() == '.')
+	if (!isNumber(currentChar()))
 	{
-		parser.match('.', false);
-		decimal = parser.number(false, &decDigits);
-		decimalValid = true;
+		fail(JSON_PARSER_BAD_JSON);
+		return {};
 	}
-	if (isExponent(parser.currentChar()))
+	else if (currentChar() == '0')
 	{
-		parser.nextChar();
-		if (parser.currentChar() == '-')
+		nextChar();
+		// Hexadecimal, octal and binary literals that fit in 64 bits are integers, taken as
+		// two's complement bit patterns so the whole range can be written. Longer ones become floats.
+		if (isBasePrefix(currentChar()))
 		{
-			parser.match('-', false);
-			mulSign = true;
+			uint64_t integer{};
+			double approximate{};
+			const bool fits{prefixedNumber(integer, approximate)};
+			skipWhite();
+			if (!fits)
+				return {false, 0, value.negative ? -approximate : approximate};
+			if (!value.negative && integer > uint64_t{INT64_MAX})
+				return {true, int64_t(integer), 0.0, integer};
+			return {true, int64_t(value.negative ? ~integer + 1U : integer), 0.0};
+		}
+		else if (isNumber(currentChar()))
+		{
+			fail(JSON_PARSER_BAD_JSON);
+			return {};
 		}
-		else if (parser.currentChar() == '+')
-			parser.match('+', false);
-		multiplier = parser.number(true);
 	}
-	parser.skipWhite();
+	else
+		digits(value, false);
 
-	if (!decimalValid)
+	if (currentChar() == '.')
 	{
-		const int64_t mul = power10(multiplier);
-		if (mulSign)
-			integer /= mul;
-		else
-			integer *= mul;
-		if (sign)
-			return std::make_unique<JSONInt>(-integer);
-		return std::make_unique<JSONInt>(integer);
+		match('.', false);
+		if (!isNumber(currentChar()))
+		{
+			fail(JSON_PARSER_BAD_JSON);
+			return {};
+		}
+		digits(value, true);
+		integral = false;
 	}
-	else
+	if (isExponent(currentChar()))
 	{
-		const int64_t mul = power10(multiplier);
-		double num = double(decimal) / power10(decDigits);
-		num += integer;
-		if (mulSign)
-			num /= mul;
-		else
-			num *= mul;
-		if (sign)
-			return std::make_unique<JSONFloat>(-num);
-		return std::make_unique<JSONFloat>(num);
+		nextChar();
+		bool negativeExponent{false};
+		if (currentChar() == '-')
+		{
+			match('-', false);
+			negativeExponent = true;
+		}
+		else if (currentChar() == '+')
+			match('+', false);
+		const auto power{exponent()};
+		value.exponent += negativeExponent ? -power : power;
 	}
+	skipWhite();
+
+	int64_t integer{};
+	if (integral && value.toInteger(integer))
+		return {true, integer, 0.0};
+	number_t result{false, 0, value.toDouble()};
+	if (uint64_t magnitude{}; integral && !value.negative && value.toMagnitude(magnitude))
+		result.wideInteger = magnitude;
+	return result;
 }
 
-// Parses the literals "true", "false" and "null"
-std::unique_ptr<JSONAtom> literal(JSONParser &parser)
+std::unique_ptr<JSONAtom> number(const number_t &value)
 {
-	std::unique_ptr<char []> lit(parser.literal());
-	if (strcmp(lit.get(), "true") == 0)
-		return std::make_unique<JSONBool>(true);
-	else if (strcmp(lit.get(), "false") == 0)
-		return std::make_unique<JSONBool>(false);
-	else if (strcmp(lit.get(), "null") == 0)
-		return std::make_unique<JSONNull>();
-	throw JSONParserError(JSON_PARSER_BAD_JSON);
+	if (value.integral)
+		return std::make_unique<JSONInt>(value.integer);
+	return std::make_unique<JSONFloat>(value.value);
 }
 
-// Parses an expression of some sort
-std::unique_ptr<JSONAtom> expression(JSONParser &parser, const bool matchComma)
+std::unique_ptr<JSONAtom> number(JSONParser &parser) { return number(parser.number()); }
+
+// Parses the literals "true", "false" and "null"
+std::unique_ptr<JSONAtom> literal(const literal_t value)
 {
-	std::unique_ptr<JSONAtom> atom{};
-	switch (parser.currentChar())
+	switch (value)
 	{
-		case '{':
-			atom = object(parser);
-			break;
-		case '[':
-			atom = array(parser);
-			break;
-		case '"':
-			atom = std::make_unique<JSONString>(parser.string());
+		case literal_t::trueValue:
+			return std::make_unique<JSONBool>(true);
+		case literal_t::falseValue:
+			return std::make_unique<JSONBool>(false);
+		case literal_t::nullValue:
 			break;
 	}
+	return std::make_unique<JSONNull>();
+}
 
-	if (atom == nullptr)
-	{
-		if (isNumber(parser.currentChar()) || isMinus(parser.currentChar()))
-			atom = number(parser);
-		else
-			atom = literal(parser);
+std::unique_ptr<JSONAtom> literal(JSONParser &parser) { return literal(parser.literal()); }
+
+// Drives handler with the events for the value at the parser's current position. Rather than recursing
+// for nested objects and arrays, the kinds of container still open are kept on an explicit stack, which
+// the parser's nesting limit caps the size of. Object keys are passed through raw unless the handler
+// asks for them to be decoded, and a handler can also ask for strings and numbers to only be checked, not read.
+// Returns how many values there were, counting objects and arrays themselves. When the parser keeps its
+// errors as a status, the first one stops the parse there, with the handler left holding whatever it was
+// given up to that point.
+template<typename handler_t> size_t parse(JSONParser &parser, handler_t &handler, scratch_t &scratch)
+{
+	auto &nesting{scratch.nesting};
+	auto &storage{scratch.storage};
+	nesting.clear();
+	const auto &limits{parser.limits()};
+	const size_t maxDepth{limits.maxDepth};
+	size_t nodes{0U};
+
+	const auto key = [&]()
+	{
+		if constexpr (handler_t::skipStrings)
+			parser.skipString();
+		else
+		{
+			storage.clear();
+			handler.key(parser.string(storage, handler_t::decodeKeys), storage);
+		}
+		parser.match(':', true);
+	};
+
+	while (true)
+	{
+		if (++nodes > limits.maxNodes)
+		{
+			parser.fail(JSON_PARSER_TOO_LARGE);
+			return nodes;
+		}
+		const auto chr{parser.currentChar()};
+		switch (classOf(chr))
+		{
+			case charClass_t::objectBegin:
+			case charClass_t::arrayBegin:
+			{
+				if (nesting.size() >= maxDepth)
+				{
+					parser.fail(JSON_PARSER_TOO_DEEP);
+					return nodes;
+				}
+				const bool isObject{isObjectBegin(chr)};
+				parser.match(chr, true);
+				if (isObject)
+					handler.startObject();
+				else
+					handler.startArray();
+				// Either the container is empty or we go on to parse its first member
+				if (parser.currentChar() != (isObject ? '}' : ']'))
+				{
+					if (!limits.maxMembers)
+					{
+						parser.fail(JSON_PARSER_TOO_LARGE);
+						return nodes;
+					}
+					nesting.push({chr, 1U});
+					if (isObject)
+						key();
+					continue;
+				}
+				parser.nextChar();
+				if (!nesting.empty())
+					parser.skipWhite();
+				if (isObject)
+					handler.endObject();
+				else
+					handler.endArray();
+				break;
+			}
+			case charClass_t::quote:
+			{
+				if constexpr (handler_t::skipStrings)
+					parser.skipString();
+				else
+				{
+					storage.clear();
+					handler.string(parser.string(storage, true), storage);
+				}
+				break;
+			}
+			case charClass_t::minus:
+			case charClass_t::digit:
+			{
+				if constexpr (handler_t::skipNumbers)
+					parser.skipNumber();
+				else
+				{
+					const auto value{parser.number()};
+					if (value.integral)
+						handler.integer(value.integer);
+					else
+						handler.floatingPoint(value.value);
+				}
+				break;
+			}
+			default:
+				switch (parser.literal())
+				{
+					case literal_t::trueValue:
+						handler.boolean(true);
+						break;
+					case literal_t::falseValue:
+						handler.boolean(false);
+						break;
+					case literal_t::nullValue:
+						handler.null();
+						break;
+				}
+		}
+
+		// Having completed a value, either another member follows it or its container ends
+		while (!nesting.empty())
+		{
+			if (parser.failed())
+				return nodes;
+			auto &container{nesting.back()};
+			const bool isObject{container.kind == '{'};
+			if (parser.currentChar() == ',')
+			{
+				if (++container.members > limits.maxMembers)
+				{
+					parser.fail(JSON_PARSER_TOO_LARGE);
+					return nodes;
+				}
+				parser.match(',', true);
+				if (isObject)
+					key();
+				break;
+			}
+			// Whatever follows the outermost object or array is left for the caller
+			parser.match(isObject ? '}' : ']', nesting.size() > 1U);
+			nesting.pop();
+			if (isObject)
+				handler.endObject();
+			else
+				handler.endArray();
+		}
+		if (nesting.empty())
+			return nodes;
 	}
+}
 
-	if (matchComma && !isObjectEnd(parser.currentChar()) && !isArrayEnd(parser.currentChar()))
-		parser.match(',', true);
-	else
-		parser.lastNoComma();
-	return atom;
+template<typename handler_t> size_t parse(JSONParser &parser, handler_t &handler)
+{
+	scratch_t scratch{};
+	return parse(parser, handler, scratch);
+}
+
+// Adds a member to an object being built, dealing with any earlier member with the same key as asked
+void addMember(JSONParser &parser, object_t &object, std::string &&key, std::unique_ptr<JSONAtom> &&value,
+	const duplicateKeys_t duplicateKeys)
+{
+	if (duplicateKeys == duplicateKeys_t::keepLast)
+		object.assign(std::move(key), std::move(value));
+	else if (!object.add(std::move(key), std::move(value)) && duplicateKeys == duplicateKeys_t::reject)
+		parser.fail(JSON_PARSER_DUPLICATE_KEY);
+}
+
+// Frees a document parsed into an arena, given the implementation of its root. Everything below the root
+// node was made in the arena and none of it is destroyed, so this only has to let go of the arena.
+template<typename T> void releaseArena(void *const root) noexcept
+	{ static_cast<T *>(root)->release(); }
+
+// Builds the tree of JSONAtoms for a document from the parser's events
+struct domBuilder_t final
+{
+private:
+	// An object or array that's still being filled in, and the key it will be added to its parent under.
+	// For objects, the object's implementation is kept too so members can be added as the limits say to.
+	struct container_t final
+	{
+		std::unique_ptr<JSONAtom> atom;
+		object_t *object;
+		std::string key;
+	};
+
+	JSONParser &parser;
+	arena_t *const arena;
+	// When parsing into an arena, this is kept in it too
+	std::vector<container_t, allocator_t<container_t>> stack;
+	std::string currentKey{};
+	std::unique_ptr<JSONAtom> result{};
+
+	void insert(std::unique_ptr<JSONAtom> &atom)
+	{
+		if (const auto object{stack.back().object})
+			addMember(parser, *object, std::move(currentKey), std::move(atom), parser.limits().duplicateKeys);
+		else
+			static_cast<JSONArray *>(stack.back().atom.get())->add(std::move(atom));
+	}
+
+	void add(std::unique_ptr<JSONAtom> &&atom)
+	{
+		if (stack.empty())
+			result = std::move(atom);
+		else if (!arena)
+			insert(atom);
+		else
+		{
+			// Nodes made in the arena must never be deleted, so one that isn't added after all (such as a
+			// duplicate member that's dropped) is simply let go of
+			try
+				{ insert(atom); }
+			catch (...)
+			{
+				atom.release();
+				throw;
+			}
+			atom.release();
+		}
+	}
+
+	// Makes a node, in the arena if the document is being parsed into one. The root is always made on
+	// the heap, as it is what's handed back to be deleted.
+	template<typename T, typename... args_t> std::unique_ptr<JSONAtom> node(args_t &&...args)
+	{
+		if (arena && !stack.empty())
+			return std::unique_ptr<JSONAtom>{arena->make<T>(std::forward<args_t>(args)...)};
+		return std::make_unique<T>(std::forward<args_t>(args)...);
+	}
+
+	// Makes the implementation of an object or array, in the arena if the document is being parsed into
+	// one. The root's is what keeps the arena alive, and letting go of it frees the whole document at once.
+	template<typename T> OpaquePtr<T> make()
+	{
+		if (!arena)
+			return makeOpaque<T>();
+		auto *const container{arena->make<T>(arena)};
+		if (!stack.empty())
+			return {container, nullptr};
+		container->keep(parser.arena());
+		return {container, releaseArena<T>};
+	}
+
+	void start(std::unique_ptr<JSONAtom> &&container, object_t *const object)
+		{ stack.push_back({std::move(container), object, std::move(currentKey)}); }
+
+	void end()
+	{
+		auto container{std::move(stack.back())};
+		stack.pop_back();
+		currentKey = std::move(container.key);
+		add(std::move(container.atom));
+	}
+
+public:
+	// Keys are kept as written in the input
+	constexpr static bool decodeKeys{false};
+	constexpr static bool skipStrings{false};
+	constexpr static bool skipNumbers{false};
+
+	domBuilder_t(JSONParser &jsonParser) : parser{jsonParser}, arena{parser.arena().get()},
+		stack{allocator_t<container_t>{arena}}
+		{ stack.reserve(std::min<size_t>(parser.limits().maxDepth, 32U)); }
+
+	domBuilder_t(const domBuilder_t &) = delete;
+	domBuilder_t(domBuilder_t &&) = delete;
+	domBuilder_t &operator =(const domBuilder_t &) = delete;
+	domBuilder_t &operator =(domBuilder_t &&) = delete;
+
+	// If the document couldn't be finished, the containers left open below the root are let go of
+	// rather than deleted when they were made in the arena
+	~domBuilder_t() noexcept
+	{
+		if (arena && !stack.empty())
+		{
+			for (auto container{stack.begin() + 1}; container != stack.end(); ++container)
+				container->atom.release();
+		}
+	}
+
+	void startObject()
+	{
+		auto members{make<object_t>()};
+		auto &object{static_cast<object_t &>(members)};
+		start(node<JSONObject>(std::move(members)), &object);
+	}
+
+	void endObject() { end(); }
+	void startArray() { start(node<JSONArray>(make<array_t>()), nullptr); }
+	void endArray() { end(); }
+
+	void key(const std::string_view value, std::string &) { currentKey.assign(value.data(), value.size()); }
+
+	// Strings in a document parsed into an arena are copied into it
+	void string(const std::string_view value, std::string &storage)
+	{
+		if (arena)
+			add(node<JSONString>(OpaquePtr<string_t>{arena->make<string_t>(borrow, arena->copy(value), nullptr,
+				true, arena), nullptr}));
+		else
+			add(::string(parser, value, storage));
+	}
+
+	void integer(const int64_t value) { add(node<JSONInt>(value)); }
+	void floatingPoint(const double value) { add(node<JSONFloat>(value)); }
+	void boolean(const bool value) { add(node<JSONBool>(value)); }
+	void null() { add(node<JSONNull>()); }
+
+	std::unique_ptr<JSONAtom> document() noexcept { return std::move(result); }
+};
+
+// Passes the parser's events on to a user supplied handler, with keys decoded like any other string
+struct eventAdapter_t final
+{
+private:
+	parseHandler_t &handler;
+
+public:
+	constexpr static bool decodeKeys{true};
+	constexpr static bool skipStrings{false};
+	constexpr static bool skipNumbers{false};
+
+	eventAdapter_t(parseHandler_t &parseHandler) noexcept : handler{parseHandler} { }
+
+	void startObject() { handler.startObject(); }
+	void endObject() { handler.endObject(); }
+	void startArray() { handler.startArray(); }
+	void endArray() { handler.endArray(); }
+	void key(const std::string_view value, std::string &) { handler.key(value); }
+	void string(const std::string_view value, std::string &) { handler.string(value); }
+	void integer(const int64_t value) { handler.integer(value); }
+	void floatingPoint(const double value) { handler.floatingPoint(value); }
+	void boolean(const bool value) { handler.boolean(value); }
+	void null() { handler.null(); }
+};
+
+// Takes no notice of the parser's events, for when a document only needs checking against the grammar
+struct validator_t final
+{
+	constexpr static bool decodeKeys{false};
+	constexpr static bool skipStrings{true};
+	constexpr static bool skipNumbers{true};
+
+	void startObject() noexcept { }
+	void endObject() noexcept { }
+	void startArray() noexcept { }
+	void endArray() noexcept { }
+	void key(std::string_view, std::string &) noexcept { }
+	void string(std::string_view, std::string &) noexcept { }
+	void integer(int64_t) noexcept { }
+	void floatingPoint(double) noexcept { }
+	void boolean(bool) noexcept { }
+	void null() noexcept { }
+};
+
+// As for validator_t, but also catches objects with more than one member with the same key
+struct duplicateChecker_t final
+{
+private:
+	JSONParser &parser;
+	// The keys of each object still open, innermost last
+	std::vector<std::set<std::string, std::less<>>> keys{};
+
+public:
+	// Keys are compared as written in the input, as they are when building a tree
+	constexpr static bool decodeKeys{false};
+	constexpr static bool skipStrings{false};
+	constexpr static bool skipNumbers{true};
+
+	duplicateChecker_t(JSONParser &jsonParser) noexcept : parser{jsonParser} { }
+
+	void startObject() { keys.emplace_back(); }
+	void endObject() noexcept { keys.pop_back(); }
+	void startArray() noexcept { }
+	void endArray() noexcept { }
+
+	void key(const std::string_view value, std::string &)
+	{
+		if (!keys.back().emplace(value).second)
+			parser.fail(JSON_PARSER_DUPLICATE_KEY);
+	}
+
+	void string(std::string_view, std::string &) noexcept { }
+	void integer(int64_t) noexcept { }
+	void floatingPoint(double) noexcept { }
+	void boolean(bool) noexcept { }
+	void null() noexcept { }
+};
+
+// Checks the value at the current position against the full grammar without building anything from it,
+// returning how many values it was made up of. If the limits say to reject duplicate keys, those are
+// checked for too, as they would be when building a tree.
+size_t validateValue(JSONParser &parser)
+{
+	if (parser.limits().duplicateKeys == duplicateKeys_t::reject)
+	{
+		duplicateChecker_t checker{parser};
+		return parse(parser, checker);
+	}
+	validator_t validator{};
+	return parse(parser, validator);
+}
+
+// Parses a value of any sort into a tree of JSONAtoms
+std::unique_ptr<JSONAtom> value(JSONParser &parser)
+{
+	domBuilder_t builder{parser};
+	parse(parser, builder);
+	parser.skipWhite();
+	return builder.document();
+}
+
+// A lazily parsed document - the input, what keeps it alive and its structural index, which every
+// container in the document that has yet to be parsed shares
+struct lazyDocument_t final
+{
+	std::string_view json;
+	std::shared_ptr<const std::string> owner;
+	structuralIndex_t structurals;
+	parseLimits_t limits;
+	// How many values have been parsed out of the document so far, across all the loads
+	mutable size_t nodes{1U};
+};
+
+// The members of an object or array in a lazily parsed document. When loaded, scalar members are parsed
+// in full, but nested objects and arrays are only skipped over and are themselves parsed when first used.
+struct lazyContainer_t final : lazyMembers_t
+{
+private:
+	std::shared_ptr<const lazyDocument_t> document;
+	// Where the container starts in the input, and how deeply it is nested
+	size_t offset;
+	size_t depth;
+
+	std::unique_ptr<JSONAtom> member(JSONParser &parser, size_t &members) const
+	{
+		if (++members > document->limits.maxMembers || ++document->nodes > document->limits.maxNodes)
+			throw JSONParserError(JSON_PARSER_TOO_LARGE);
+		const auto chr{parser.currentChar()};
+		switch (classOf(chr))
+		{
+			case charClass_t::objectBegin:
+			case charClass_t::arrayBegin:
+			{
+				if (depth >= document->limits.maxDepth)
+					throw JSONParserError(JSON_PARSER_TOO_DEEP);
+				auto members{std::make_unique<lazyContainer_t>(document, parser.offset(), depth + 1U)};
+				parser.skipContainer();
+				if (isObjectBegin(chr))
+					return std::make_unique<JSONObject>(makeOpaque<object_t>(std::move(members)));
+				return std::make_unique<JSONArray>(makeOpaque<array_t>(std::move(members)));
+			}
+			case charClass_t::quote:
+				return string(parser);
+			case charClass_t::minus:
+			case charClass_t::digit:
+				return number(parser);
+			default:
+				return literal(parser);
+		}
+	}
+
+	JSONParser parser() const
+	{
+		JSONParser parser{document->json, offset, document->structurals, document->owner};
+		parser.limits(document->limits);
+		return parser;
+	}
+
+public:
+	lazyContainer_t(std::shared_ptr<const lazyDocument_t> lazyDocument, const size_t containerOffset,
+		const size_t containerDepth) noexcept : document{std::move(lazyDocument)}, offset{containerOffset},
+		depth{containerDepth} { }
+
+	void load(object_t &object) const final
+	{
+		auto parser{this->parser()};
+		parser.match('{', true);
+		if (parser.currentChar() == '}')
+			return;
+		size_t members{0U};
+		while (true)
+		{
+			auto key{parser.string()};
+			parser.match(':', true);
+			addMember(parser, object, std::move(key), member(parser, members), document->limits.duplicateKeys);
+			if (parser.currentChar() != ',')
+				break;
+			parser.match(',', true);
+		}
+		parser.match('}', false);
+	}
+
+	void load(array_t &array) const final
+	{
+		auto parser{this->parser()};
+		parser.match('[', true);
+		if (parser.currentChar() == ']')
+			return;
+		size_t members{0U};
+		while (true)
+		{
+			array.add(member(parser, members));
+			if (parser.currentChar() != ',')
+				break;
+			parser.match(',', true);
+		}
+		parser.match(']', false);
+	}
+};
+
+// Parses a complete JSON document, which must be either an object or an array. Nothing after the end of
+// the document is consumed, not even whitespace, so further documents can follow it in the same input.
+std::unique_ptr<JSONAtom> document(JSONParser &parser, scratch_t &scratch)
+{
+	if (!isObjectBegin(parser.currentChar()) && !isArrayBegin(parser.currentChar()))
+	{
+		parser.fail(JSON_PARSER_BAD_JSON);
+		return nullptr;
+	}
+	domBuilder_t builder{parser};
+	parse(parser, builder, scratch);
+	return builder.document();
+}
+
+std::unique_ptr<JSONAtom> document(JSONParser &parser)
+{
+	scratch_t scratch{};
+	return document(parser, scratch);
 }
 
 // The parser entry point
 // This verifies the first character in the string to parse is the beginning of either an array or an object
-// It then performs a try-catch in which expression() is invoked. if an exception is thrown or needs to be thrown,
+// It then performs a try-catch in which document() is invoked. if an exception is thrown or needs to be thrown,
 // the parser object this temporarily creates is cleaned up before the exception is (re)thrown.
 // If everything went OK, this then cleans up the parser object and returns the resulting JSONAtom tree.
-std::unique_ptr<JSONAtom> rSON::parseJSON(stream_t &json) try
+std::unique_ptr<JSONAtom> rSON::parseJSON(stream_t &json, const parseLimits_t &limits) try
+{
+	JSONParser parser(json);
+	parser.limits(limits);
+	auto expr = document(parser);
+	json.readSync();
+	return expr;
+}
+catch (JSONParserError &) { json.readSync(); throw; }
+
+// When the JSON is already in memory, parse it in place rather than copying it through a stream
+std::unique_ptr<JSONAtom> rSON::parseJSON(const std::string_view json, const parseLimits_t &limits)
+{
+	JSONParser parser{json};
+	parser.limits(limits);
+	return document(parser);
+}
+
+std::unique_ptr<JSONAtom> rSON::parseJSON(stream_t &json, const parseLimits_t &limits, stringPool_t &strings) try
+{
+	JSONParser parser(json);
+	parser.limits(limits);
+	parser.stringPool(&strings.pool());
+	auto expr = document(parser);
+	json.readSync();
+	return expr;
+}
+catch (JSONParserError &) { json.readSync(); throw; }
+
+std::unique_ptr<JSONAtom> rSON::parseJSON(const std::string_view json, const parseLimits_t &limits,
+	stringPool_t &strings)
+{
+	JSONParser parser{json};
+	parser.limits(limits);
+	parser.stringPool(&strings.pool());
+	return document(parser);
+}
+
+// Sizes the first block of an arena for a document of the given length. The tree is usually about as
+// big as the document it's parsed from, so most documents fit in one block.
+std::shared_ptr<arena_t> makeArena(const size_t length) { return std::make_shared<arena_t>(length); }
+
+std::unique_ptr<JSONAtom> rSON::parseJSONArena(stream_t &json, const parseLimits_t &limits) try
 {
 	JSONParser parser(json);
-	if (isObjectBegin(parser.currentChar()) || isArrayBegin(parser.currentChar()))
+	parser.limits(limits);
+	parser.arena(makeArena(65536U));
+	auto expr = document(parser);
+	json.readSync();
+	return expr;
+}
+catch (JSONParserError &) { json.readSync(); throw; }
+
+std::unique_ptr<JSONAtom> rSON::parseJSONArena(const std::string_view json, const parseLimits_t &limits)
+{
+	JSONParser parser{json};
+	parser.limits(limits);
+	parser.arena(makeArena(json.length()));
+	return document(parser);
+}
+
+std::unique_ptr<JSONAtom> rSON::parseJSONArena(stream_t &json)
+	{ return parseJSONArena(json, parseLimits_t{}); }
+std::unique_ptr<JSONAtom> rSON::parseJSONArena(const std::string_view json)
+	{ return parseJSONArena(json, parseLimits_t{}); }
+
+parseContext_t::parseContext_t() : context{makeOpaque<context_t>()} { }
+
+// Gets the context's arena ready for another document. If the last document parsed into it is gone,
+// the arena is reset to be allocated from again, otherwise that document keeps it and a new one is made.
+void recycleArena(context_t &context, const size_t length)
+{
+	if (context.arena && context.arena.use_count() == 1)
+		context.arena->reset();
+	else
+		context.arena = makeArena(length);
+}
+
+std::unique_ptr<JSONAtom> parseContext_t::parse(stream_t &json, const parseLimits_t &limits) try
+{
+	auto &state{static_cast<context_t &>(context)};
+	recycleArena(state, 65536U);
+	JSONParser parser{json, std::move(state.buffer)};
+	parser.limits(limits);
+	parser.arena(state.arena);
+	std::unique_ptr<JSONAtom> expr{};
+	try
+		{ expr = document(parser, state.scratch); }
+	catch (JSONParserError &)
 	{
-		auto expr = expression(parser, false);
-		json.readSync();
-		return expr;
+		state.buffer = parser.takeBuffer();
+		throw;
+	}
+	state.buffer = parser.takeBuffer();
+	json.readSync();
+	return expr;
+}
+catch (JSONParserError &) { json.readSync(); throw; }
+
+std::unique_ptr<JSONAtom> parseContext_t::parse(const std::string_view json, const parseLimits_t &limits)
+{
+	auto &state{static_cast<context_t &>(context)};
+	recycleArena(state, json.length());
+	JSONParser parser{json, std::move(state.index)};
+	// Keep hold of the index so its bitmap can be reused, whatever happens. Documents too small to be
+	// indexed leave the bitmap kept from before alone.
+	if (parser.index().valid())
+		state.index = parser.index();
+	parser.limits(limits);
+	parser.arena(state.arena);
+	return document(parser, state.scratch);
+}
+
+std::unique_ptr<JSONAtom> parseContext_t::parse(stream_t &json) { return parse(json, parseLimits_t{}); }
+std::unique_ptr<JSONAtom> parseContext_t::parse(const std::string_view json)
+	{ return parse(json, parseLimits_t{}); }
+
+// A read-only mapping of a whole file, which is left invalid if the file can't be mapped
+struct mappedFile_t final
+{
+private:
+	void *memory{nullptr};
+	size_t length{0U};
+
+public:
+	mappedFile_t(const fileStream_t &file) noexcept
+	{
+#ifndef _WIN32
+		void *const mapping{mmap(nullptr, file.size(), PROT_READ, MAP_PRIVATE, file.descriptor(), 0)};
+		if (mapping == MAP_FAILED)
+			return;
+		memory = mapping;
+		length = file.size();
+		// The parser reads the file through from start to end, so ask for it to be read ahead aggressively
+		madvise(memory, length, MADV_SEQUENTIAL);
+#else
+		static_cast<void>(file);
+#endif
+	}
+
+	mappedFile_t(const mappedFile_t &) = delete;
+	mappedFile_t(mappedFile_t &&) = delete;
+	mappedFile_t &operator =(const mappedFile_t &) = delete;
+	mappedFile_t &operator =(mappedFile_t &&) = delete;
+
+	~mappedFile_t() noexcept
+	{
+#ifndef _WIN32
+		if (memory)
+			munmap(memory, length);
+#endif
+	}
+
+	bool valid() const noexcept { return memory; }
+	std::string_view view() const noexcept { return {static_cast<const char *>(memory), length}; }
+};
+
+// Files smaller than this are read through the stream, as mapping them costs more than it saves
+constexpr static size_t mapThreshold{256U * 1024U};
+
+std::unique_ptr<JSONAtom> rSON::internal::parseFile(fileStream_t &file)
+{
+	if (file.size() >= mapThreshold)
+	{
+		// Files that can't be mapped, such as pipes, can still be read through as normal
+		const mappedFile_t mapping{file};
+		if (mapping.valid())
+			return parseJSON(mapping.view());
+	}
+	return parseJSON(file);
+}
+
+std::unique_ptr<JSONAtom> rSON::parseJSON(stream_t &json, stringPool_t &strings)
+	{ return parseJSON(json, parseLimits_t{}, strings); }
+std::unique_ptr<JSONAtom> rSON::parseJSON(const std::string_view json, stringPool_t &strings)
+	{ return parseJSON(json, parseLimits_t{}, strings); }
+
+const path_t *path_t::find(const std::string_view key) const noexcept
+{
+	const auto child{children.find(key)};
+	if (child != children.end())
+		return child->second.get();
+	return wildcard.get();
+}
+
+const path_t *path_t::find(const size_t index) const noexcept
+{
+	if (!children.empty())
+	{
+		std::array<char, 24> digits{};
+		const auto result{std::to_chars(digits.begin(), digits.end(), index)};
+		const auto child{children.find(std::string_view{digits.data(), size_t(result.ptr - digits.data())})};
+		if (child != children.end())
+			return child->second.get();
+	}
+	return wildcard.get();
+}
+
+projection_t::projection_t(const std::vector<std::string_view> &paths) : root{makeOpaque<path_t>()}
+{
+	for (auto path : paths)
+	{
+		path_t *node{&static_cast<path_t &>(root)};
+		// The empty path is the whole document - any other is a list of components, each introduced by a "/"
+		// (which may be left off the first), and each of which may be empty as in "/" or "/a/"
+		bool more{!path.empty()};
+		if (more && path.front() == '/')
+			path.remove_prefix(1U);
+		while (more)
+		{
+			const auto separator{std::min(path.find('/'), path.length())};
+			std::string component{};
+			// Undo the JSON Pointer escapes - "~1" is "/" and "~0" is "~" - and our own, "~2" for a literal "*"
+			for (size_t i{0}; i < separator; ++i)
+			{
+				if (path[i] == '~' && i + 1U < separator && path[i + 1U] >= '0' && path[i + 1U] <= '2')
+				{
+					const auto escape{path[++i]};
+					component += escape == '0' ? '~' : escape == '1' ? '/' : '*';
+				}
+				else
+					component += path[i];
+			}
+			const auto wildcard{path.substr(0U, separator) == std::string_view{"*"}};
+			more = separator != path.length();
+			path.remove_prefix(std::min(separator + 1U, path.length()));
+
+			auto &child{wildcard ? node->wildcard : node->children[component]};
+			if (!child)
+				child = std::make_unique<path_t>();
+			node = child.get();
+		}
+		node->selected = true;
 	}
+}
+
+// An object or array on the way to the values selected by a projection, its implementation if it's an
+// object, the key it will be added to its parent under, the paths through it, and how many members it's had
+struct projected_t final
+{
+	std::unique_ptr<JSONAtom> atom;
+	object_t *object;
+	std::string key;
+	const path_t *path;
+	size_t index;
+};
+
+// Parses only the parts of a document that paths selects
+std::unique_ptr<JSONAtom> project(JSONParser &parser, const path_t &paths)
+{
+	const auto begin{parser.currentChar()};
+	if (!isObjectBegin(begin) && !isArrayBegin(begin))
+		throw JSONParserError(JSON_PARSER_BAD_JSON);
+	if (paths.selected)
+		return value(parser);
+
+	const auto limits{parser.limits()};
+	std::vector<projected_t> stack{};
+	std::string storage{};
+
+	// Starts a new object or array and, unless it's empty, moves onto its first member
+	const auto open = [&](const char chr, std::string &&key, const path_t *const path) -> bool
+	{
+		if (stack.size() >= limits.maxDepth)
+			throw JSONParserError(JSON_PARSER_TOO_DEEP);
+		const bool isObject{isObjectBegin(chr)};
+		std::unique_ptr<JSONAtom> atom{};
+		object_t *object{nullptr};
+		if (isObject)
+		{
+			auto members{makeOpaque<object_t>()};
+			object = &static_cast<object_t &>(members);
+			atom = std::make_unique<JSONObject>(std::move(members));
+		}
+		else
+			atom = std::make_unique<JSONArray>();
+		stack.push_back({std::move(atom), object, std::move(key), path, 0U});
+		parser.match(chr, true);
+		return parser.currentChar() != (isObject ? '}' : ']');
+	};
+
+	// Adds a value to the innermost open object or array
+	const auto add = [&](std::string &&key, std::unique_ptr<JSONAtom> &&atom)
+	{
+		auto &container{stack.back()};
+		if (container.object)
+			addMember(parser, *container.object, std::move(key), std::move(atom), limits.duplicateKeys);
+		else
+			static_cast<JSONArray *>(container.atom.get())->add(std::move(atom));
+	};
+
+	bool member{open(begin, {}, &paths)};
+	while (true)
+	{
+		if (member)
+		{
+			auto &container{stack.back()};
+			const path_t *path{};
+			std::string key{};
+			if (container.index == limits.maxMembers)
+				throw JSONParserError(JSON_PARSER_TOO_LARGE);
+			if (container.object)
+			{
+				++container.index;
+				// Only the keys of members that are wanted get copied out
+				storage.clear();
+				const auto name{parser.string(storage, false)};
+				path = container.path->find(name);
+				if (path)
+					key = name;
+				parser.match(':', true);
+			}
+			else
+				path = container.path->find(container.index++);
+
+			const auto chr{parser.currentChar()};
+			if (!path)
+				parser.skipValue();
+			else if (path->selected)
+			{
+				// Parse the whole of the value, allowing it only as much nesting as remains
+				auto valueLimits{limits};
+				valueLimits.maxDepth -= stack.size();
+				parser.limits(valueLimits);
+				add(std::move(key), value(parser));
+				parser.limits(limits);
+			}
+			else if (isObjectBegin(chr) || isArrayBegin(chr))
+			{
+				if (open(chr, std::move(key), path))
+					continue;
+				// The container is empty, so nothing in it can be selected
+				parser.nextChar();
+				parser.skipWhite();
+				stack.pop_back();
+			}
+			else
+				parser.skipValue();
+		}
+
+		// Having finished a member, either another follows it or its container ends
+		auto &container{stack.back()};
+		if (parser.currentChar() == ',')
+		{
+			parser.match(',', true);
+			member = true;
+			continue;
+		}
+		parser.match(container.object ? '}' : ']', true);
+		auto finished{std::move(container)};
+		stack.pop_back();
+		if (stack.empty())
+			return std::move(finished.atom);
+		// Only keep objects and arrays that something was selected in
+		const bool empty{finished.object ? finished.object->size() == 0U :
+			finished.atom->asArrayRef().size() == 0U};
+		if (!empty)
+			add(std::move(finished.key), std::move(finished.atom));
+		member = false;
+	}
+}
+
+std::unique_ptr<JSONAtom> rSON::parseJSON(stream_t &json, const projection_t &projection,
+	const parseLimits_t &limits) try
+{
+	JSONParser parser(json);
+	parser.limits(limits);
+	auto expr = project(parser, projection.paths());
+	json.readSync();
+	return expr;
+}
+catch (JSONParserError &) { json.readSync(); throw; }
+
+std::unique_ptr<JSONAtom> rSON::parseJSON(const std::string_view json, const projection_t &projection,
+	const parseLimits_t &limits)
+{
+	JSONParser parser{json};
+	parser.limits(limits);
+	return project(parser, projection.paths());
+}
+
+std::unique_ptr<JSONAtom> rSON::parseJSON(stream_t &json, const projection_t &projection)
+	{ return parseJSON(json, projection, parseLimits_t{}); }
+std::unique_ptr<JSONAtom> rSON::parseJSON(const std::string_view json, const projection_t &projection)
+	{ return parseJSON(json, projection, parseLimits_t{}); }
+
+documentStream_t::documentStream_t(stream_t &json, const documentFormat_t format, const parseLimits_t &limits) :
+	documents{makeOpaque<documents_t>()}
+{
+	documents->format = format;
+	// Empty input simply holds no documents, which the parser reports by failing to start
+	try
+		{ documents->parser.emplace(json); }
+	catch (const JSONParserError &)
+		{ return; }
+	documents->parser->limits(limits);
+}
+
+documentStream_t::documentStream_t(const std::string_view json, const documentFormat_t format,
+	const parseLimits_t &limits) : documents{makeOpaque<documents_t>()}
+{
+	documents->format = format;
+	if (json.empty())
+		return;
+	documents->parser.emplace(json);
+	documents->parser->limits(limits);
+}
+
+// Parses the document making up a line of JSON Lines input, which nothing but whitespace may follow.
+// Parsing only the line means a document can't run on into the lines after it, even when it's malformed.
+std::unique_ptr<JSONAtom> lineDocument(const std::string_view line, const parseLimits_t &limits)
+{
+	JSONParser parser{line};
+	parser.limits(limits);
+	auto result{document(parser)};
+	parser.skipWhite();
+	if (!parser.atEnd())
+		throw JSONParserError(JSON_PARSER_BAD_JSON);
+	return result;
+}
+
+std::unique_ptr<JSONAtom> documentStream_t::next()
+{
+	auto &state{*documents};
+	if (state.error)
+		throw JSONParserError(*state.error);
+	if (!state.parser)
+		return nullptr;
+	auto &parser{*state.parser};
+
+	try
+	{
+		parser.skipWhite();
+		if (parser.atEnd())
+			return nullptr;
+		if (state.format == documentFormat_t::lines)
+			return lineDocument(parser.line(state.line), parser.limits());
+		return document(parser);
+	}
+	catch (const JSONParserError &error)
+	{
+		// A bad line has already been read past, but there's no telling where a bad concatenated document ends
+		if (state.format == documentFormat_t::concatenated)
+			state.error = error.errorType();
+		throw;
+	}
+}
+
+size_t documentStream_t::offset() const noexcept
+{
+	const auto &state{*documents};
+	return state.parser ? state.parser->offset() : 0U;
+}
+
+arrayStream_t::arrayStream_t(stream_t &json, const parseLimits_t &limits) : elements{makeOpaque<elements_t>()}
+{
+	elements->limits = limits;
+	// Empty input can't be an array, but that's reported when the first element is asked for
+	try
+		{ elements->parser.emplace(json); }
+	catch (const JSONParserError &error)
+		{ elements->error = error.errorType(); }
+}
+
+arrayStream_t::arrayStream_t(const std::string_view json, const parseLimits_t &limits) :
+	elements{makeOpaque<elements_t>()}
+{
+	elements->limits = limits;
+	if (json.empty())
+		elements->error = JSON_PARSER_EOF;
+	else
+		elements->parser.emplace(json);
+}
+
+// Opens the array, setting the parser up to parse its elements - which are nested one level inside it
+bool openArray(elements_t &state)
+{
+	auto &parser{*state.parser};
+	if (!state.limits.maxDepth)
+		throw JSONParserError(JSON_PARSER_TOO_DEEP);
+	auto elementLimits{state.limits};
+	--elementLimits.maxDepth;
+	parser.limits(elementLimits);
+	parser.skipWhite();
+	parser.match('[', true);
+	state.started = true;
+	// Either the array is empty or its first element follows
+	return parser.currentChar() != ']';
+}
+
+// Moves on from an element to the next, returning false if the array ends instead
+bool nextElement(JSONParser &parser)
+{
+	if (parser.currentChar() == ',')
+	{
+		parser.match(',', true);
+		return true;
+	}
+	if (parser.currentChar() != ']')
+		throw JSONParserError(JSON_PARSER_BAD_JSON);
+	return false;
+}
+
+std::unique_ptr<JSONAtom> arrayStream_t::next()
+{
+	auto &state{*elements};
+	if (state.error)
+		throw JSONParserError(*state.error);
+	if (state.finished)
+		return nullptr;
+	auto &parser{*state.parser};
+
+	try
+	{
+		if (!(state.started ? nextElement(parser) : openArray(state)))
+		{
+			parser.nextChar();
+			state.finished = true;
+			return nullptr;
+		}
+		if (state.count == state.limits.maxMembers)
+			throw JSONParserError(JSON_PARSER_TOO_LARGE);
+		auto element{value(parser)};
+		++state.count;
+		return element;
+	}
+	catch (const JSONParserError &error)
+	{
+		// There's no telling where a bad element ends, so nothing after it can be read
+		state.error = error.errorType();
+		throw;
+	}
+}
+
+size_t arrayStream_t::count() const noexcept { return elements->count; }
+
+size_t arrayStream_t::offset() const noexcept
+{
+	const auto &state{*elements};
+	return state.parser ? state.parser->offset() : 0U;
+}
+
+// Lazy parsing - the outermost object or array is checked to be complete, but nothing inside it is
+// parsed until it's used
+std::unique_ptr<JSONAtom> parseJSONLazy(const std::string_view json, std::shared_ptr<const std::string> owner,
+	const parseLimits_t &limits)
+{
+	JSONParser parser{json};
+	parser.limits(limits);
+	const auto chr{parser.currentChar()};
+	if (!isObjectBegin(chr) && !isArrayBegin(chr))
+		throw JSONParserError(JSON_PARSER_BAD_JSON);
+	parser.skipContainer();
+
+	auto document{std::make_shared<const lazyDocument_t>(lazyDocument_t{json, std::move(owner), parser.index(), limits})};
+	auto members{std::make_unique<lazyContainer_t>(std::move(document), 0U, 1U)};
+	if (isObjectBegin(chr))
+		return std::make_unique<JSONObject>(makeOpaque<object_t>(std::move(members)));
+	return std::make_unique<JSONArray>(makeOpaque<array_t>(std::move(members)));
+}
+
+std::unique_ptr<JSONAtom> rSON::parseJSONLazy(const std::string_view json)
+	{ return ::parseJSONLazy(json, nullptr, parseLimits_t{}); }
+std::unique_ptr<JSONAtom> rSON::parseJSONLazy(const std::string_view json, const parseLimits_t &limits)
+	{ return ::parseJSONLazy(json, nullptr, limits); }
+std::unique_ptr<JSONAtom> rSON::parseJSONLazy(const std::string &json)
+	{ return ::parseJSONLazy(json, nullptr, parseLimits_t{}); }
+std::unique_ptr<JSONAtom> rSON::parseJSONLazy(std::string &&json)
+	{ return parseJSONLazy(std::move(json), parseLimits_t{}); }
+
+std::unique_ptr<JSONAtom> rSON::parseJSONLazy(std::string &&json, const parseLimits_t &limits)
+{
+	auto owner{std::make_shared<const std::string>(std::move(json))};
+	return ::parseJSONLazy(*owner, owner, limits);
+}
+
+// Checks the document in full, without building anything from it. The parser keeps any problem as its
+// status, so nothing is thrown for bad input.
+validation_t validate(JSONParser &parser, const parseLimits_t &limits)
+{
+	parser.reportErrors(errorMode_t::keepStatus);
+	parser.limits(limits);
+	if (!isObjectBegin(parser.currentChar()) && !isArrayBegin(parser.currentChar()))
+		parser.fail(JSON_PARSER_BAD_JSON);
 	else
+	{
+		validator_t validator{};
+		parse(parser, validator);
+	}
+	if (const auto error{parser.error()})
+		return {false, *error, parser.offset()};
+	return {true, JSON_PARSER_BAD_JSON, parser.offset()};
+}
+
+// Each thread keeps its input window between calls, so only the first stream it checks allocates one
+validation_t rSON::validateJSON(stream_t &json, const parseLimits_t &limits)
+{
+	thread_local std::unique_ptr<char []> window{};
+	JSONParser parser{json, std::move(window), errorMode_t::keepStatus};
+	const auto result{validate(parser, limits)};
+	window = parser.takeBuffer();
+	json.readSync();
+	return result;
+}
+
+// The structural index isn't worth building just to check a document, so this leaves it out
+validation_t rSON::validateJSON(const std::string_view json, const parseLimits_t &limits)
+{
+	if (json.empty())
+		return {false, JSON_PARSER_EOF, 0U};
+	JSONParser parser{json, 0U, structuralIndex_t{}, nullptr};
+	return validate(parser, limits);
+}
+
+validation_t rSON::validateJSON(stream_t &json)
+	{ return validateJSON(json, parseLimits_t{}); }
+validation_t rSON::validateJSON(const std::string_view json)
+	{ return validateJSON(json, parseLimits_t{}); }
+
+// Parses the document, handing back any problem with it. The parser keeps problems with the input as its
+// status, so rejecting a document costs no more than reading up to the problem. Running out of memory and
+// failing to read a stream are still thrown, so they are caught and handed back here too.
+parseResult_t tryParse(JSONParser &parser, const parseLimits_t &limits) noexcept
+{
+	JSONParserErrorType error{JSON_PARSER_BAD_JSON};
+	try
+	{
+		parser.reportErrors(errorMode_t::keepStatus);
+		parser.limits(limits);
+		auto result{document(parser)};
+		if (!parser.failed())
+			return {std::move(result), error, parser.offset(), 0U, 0U};
+		error = *parser.error();
+	}
+	catch (const JSONParserError &parserError)
+		{ error = parserError.errorType(); }
+	catch (const std::bad_alloc &)
+		{ error = JSON_PARSER_TOO_LARGE; }
+	catch (...)
+		{ error = JSON_PARSER_BAD_FILE; }
+	const auto position{parser.position()};
+	return {nullptr, error, parser.offset(), position.line, position.column};
+}
+
+parseResult_t rSON::tryParseJSON(stream_t &json, const parseLimits_t &limits) noexcept
+{
+	std::optional<JSONParser> parser{};
+	JSONParserErrorType error{JSON_PARSER_BAD_JSON};
+	try
+		{ parser.emplace(json, errorMode_t::keepStatus); }
+	catch (const std::bad_alloc &)
+		{ error = JSON_PARSER_TOO_LARGE; }
+	catch (...)
+		{ error = JSON_PARSER_BAD_FILE; }
+	if (!parser)
+	{
+		json.readSync();
+		return {nullptr, error, 0U, 1U, 1U};
+	}
+	auto result{tryParse(*parser, limits)};
+	json.readSync();
+	return result;
+}
+
+parseResult_t rSON::tryParseJSON(const std::string_view json, const parseLimits_t &limits) noexcept
+{
+	if (json.empty())
+		return {nullptr, JSON_PARSER_EOF, 0U, 1U, 1U};
+	std::optional<JSONParser> parser{};
+	try
+		{ parser.emplace(json); }
+	catch (...)
+		{ return {nullptr, JSON_PARSER_TOO_LARGE, 0U, 1U, 1U}; }
+	return tryParse(*parser, limits);
+}
+
+parseResult_t rSON::tryParseJSON(stream_t &json) noexcept
+	{ return tryParseJSON(json, parseLimits_t{}); }
+parseResult_t rSON::tryParseJSON(const std::string_view json) noexcept
+	{ return tryParseJSON(json, parseLimits_t{}); }
+
+// Event-driven parsing, which hands each part of the document to handler as it is read rather than building a tree
+void rSON::parseJSON(stream_t &json, parseHandler_t &handler, const parseLimits_t &limits) try
+{
+	JSONParser parser(json);
+	parser.limits(limits);
+	if (!isObjectBegin(parser.currentChar()) && !isArrayBegin(parser.currentChar()))
 		throw JSONParserError(JSON_PARSER_BAD_JSON);
+	eventAdapter_t adapter{handler};
+	parse(parser, adapter);
+	json.readSync();
 }
 catch (JSONParserError &) { json.readSync(); throw; }
 
-std::unique_ptr<JSONAtom> rSON::parseJSON(const std::string_view json)
+void rSON::parseJSON(const std::string_view json, parseHandler_t &handler, const parseLimits_t &limits)
 {
-	memoryStream_t stream{const_cast<char *>(json.data()), json.length()};
-	return rSON::parseJSON(stream);
+	JSONParser parser{json};
+	parser.limits(limits);
+	if (!isObjectBegin(parser.currentChar()) && !isArrayBegin(parser.currentChar()))
+		throw JSONParserError(JSON_PARSER_BAD_JSON);
+	eventAdapter_t adapter{handler};
+	parse(parser, adapter);
 }
 
-std::unique_ptr<JSONAtom> rSON::parseJSON(const std::string &json)
-	{ return parseJSON(std::string_view{json}); }
+void rSON::parseJSON(stream_t &json, parseHandler_t &handler)
+	{ parseJSON(json, handler, parseLimits_t{}); }
+void rSON::parseJSON(const std::string_view json, parseHandler_t &handler)
+	{ parseJSON(json, handler, parseLimits_t{}); }
 
+std::unique_ptr<JSONAtom> rSON::parseJSON(stream_t &json)
+	{ return parseJSON(json, parseLimits_t{}); }
+std::unique_ptr<JSONAtom> rSON::parseJSON(const std::string_view json)
+	{ return parseJSON(json, parseLimits_t{}); }
+std::unique_ptr<JSONAtom> rSON::parseJSON(const std::string &json)
+	{ return parseJSON(std::string_view{json}, parseLimits_t{}); }
+std::unique_ptr<JSONAtom> rSON::parseJSON(const std::string &json, const parseLimits_t &limits)
+	{ return parseJSON(std::string_view{json}, limits); }
 std::unique_ptr<JSONAtom> rSON::parseJSON(const char *json)
+	{ return parseJSON(std::string_view{json}, parseLimits_t{}); }
+std::unique_ptr<JSONAtom> rSON::parseJSON(const char *json, const parseLimits_t &limits)
+	{ return parseJSON(std::string_view{json}, limits); }
+
+std::unique_ptr<JSONAtom> rSON::parseJSONInSitu(const std::string_view json)
+{
+	JSONParser parser{json, nullptr};
+	return document(parser);
+}
+
+std::unique_ptr<JSONAtom> rSON::parseJSONInSitu(const std::string &json)
+	{ return parseJSONInSitu(std::string_view{json}); }
+
+std::unique_ptr<JSONAtom> rSON::parseJSONInSitu(std::string &&json)
+{
+	auto owner{std::make_shared<const std::string>(std::move(json))};
+	JSONParser parser{*owner, owner};
+	return document(parser);
+}
+
+// Recognise a character that may be part of a number, including the digits and prefixes of
+// hexadecimal, octal and binary literals
+inline bool isNumberChar(const char x) noexcept
+	{ return isHex(x) || isMinus(x) || x == '+' || x == '.' || x == 'x' || x == 'o'; }
+
+pushStatus_t fail(push_t &state, const JSONParserErrorType error) noexcept
+{
+	state.error = error;
+	state.status = pushStatus_t::error;
+	state.result.reset();
+	return state.status;
+}
+
+// Adds a completed value to the innermost open object or array, or when it's the document itself,
+// completes the parse
+void addValue(push_t &state, std::unique_ptr<JSONAtom> &&atom)
+{
+	using expect_t = push_t::expect_t;
+	if (state.stack.empty())
+	{
+		state.result = std::move(atom);
+		state.expect = expect_t::done;
+		state.status = pushStatus_t::complete;
+		return;
+	}
+	auto &container{state.stack.back()};
+	state.expect = expect_t::next;
+	if (!container.object)
+		static_cast<JSONArray *>(container.atom.get())->add(std::move(atom));
+	else if (state.limits.duplicateKeys == duplicateKeys_t::keepLast)
+		container.object->assign(std::move(state.key), std::move(atom));
+	else if (!container.object->add(std::move(state.key), std::move(atom)) &&
+		state.limits.duplicateKeys == duplicateKeys_t::reject)
+		fail(state, JSON_PARSER_DUPLICATE_KEY);
+}
+
+// Counts off another member of the innermost object or array against the limits
+bool startMember(push_t &state)
+{
+	if (++state.stack.back().members > state.limits.maxMembers)
+	{
+		fail(state, JSON_PARSER_TOO_LARGE);
+		return false;
+	}
+	return true;
+}
+
+// Starts reading a value of whichever kind the character that starts it says, failing if it can't start one
+void startValue(push_t &state, const char chr)
+{
+	using expect_t = push_t::expect_t;
+	if (++state.nodes > state.limits.maxNodes)
+	{
+		fail(state, JSON_PARSER_TOO_LARGE);
+		return;
+	}
+	state.token.clear();
+	if (isObjectBegin(chr) || isArrayBegin(chr))
+	{
+		if (state.stack.size() >= state.limits.maxDepth)
+		{
+			fail(state, JSON_PARSER_TOO_DEEP);
+			return;
+		}
+		std::unique_ptr<JSONAtom> atom{};
+		object_t *object{nullptr};
+		if (isObjectBegin(chr))
+		{
+			auto members{makeOpaque<object_t>()};
+			object = &static_cast<object_t &>(members);
+			atom = std::make_unique<JSONObject>(std::move(members));
+		}
+		else
+			atom = std::make_unique<JSONArray>();
+		state.stack.push_back({std::move(atom), object, std::move(state.key), 0U});
+		state.expect = object ? expect_t::keyOrEnd : expect_t::valueOrEnd;
+	}
+	else if (isQuote(chr))
+	{
+		state.isKey = false;
+		state.expect = expect_t::string;
+	}
+	else if (isMinus(chr) || isNumber(chr))
+	{
+		state.token += chr;
+		state.expect = expect_t::number;
+	}
+	else
+	{
+		state.expect = expect_t::literal;
+		if (chr == 't')
+		{
+			state.literal = literal_t::trueValue;
+			state.word = std::string_view{"rue"};
+		}
+		else if (chr == 'f')
+		{
+			state.literal = literal_t::falseValue;
+			state.word = std::string_view{"alse"};
+		}
+		else if (chr == 'n')
+		{
+			state.literal = literal_t::nullValue;
+			state.word = std::string_view{"ull"};
+		}
+		else
+			fail(state, JSON_PARSER_BAD_JSON);
+	}
+}
+
+// Closes the innermost object or array, adding it to its parent
+void closeContainer(push_t &state)
+{
+	auto container{std::move(state.stack.back())};
+	state.stack.pop_back();
+	state.key = std::move(container.key);
+	addValue(state, std::move(container.atom));
+}
+
+// The number just read ended at the current character, so has the parser turn it into a value
+void endNumber(push_t &state)
+{
+	const auto length{state.token.length()};
+	state.token += ' ';
+	JSONParser parser{state.token};
+	parser.reportErrors(errorMode_t::keepStatus);
+	const auto value{parser.number()};
+	if (parser.failed() || !parser.atEnd())
+	{
+		// Report the problem where it is in the number, not where the number ended
+		state.offset -= length - std::min(parser.offset(), length);
+		fail(state, JSON_PARSER_BAD_JSON);
+		return;
+	}
+	addValue(state, number(value));
+}
+
+// The string just read ended, so it becomes either the key of the next member or a value
+void endString(push_t &state)
+{
+	if (state.isKey)
+	{
+		state.key = std::move(state.token);
+		state.expect = push_t::expect_t::colon;
+	}
+	else
+		addValue(state, std::make_unique<JSONString>(makeOpaque<string_t>(std::move(state.token))));
+}
+
+pushParser_t::pushParser_t() : pushParser_t{parseLimits_t{}} { }
+pushParser_t::pushParser_t(const parseLimits_t &limits) : push{makeOpaque<push_t>()}
+	{ push->limits = limits; }
+
+// Takes the chunk a character at a time, except for the plain runs of strings which are taken whole.
+// Each character either moves the parser on to what it expects next or is the problem with the input.
+pushStatus_t pushParser_t::feed(const std::string_view chunk)
+{
+	using expect_t = push_t::expect_t;
+	auto &state{*push};
+	state.used = 0U;
+	if (state.status != pushStatus_t::needMore)
+		return state.status;
+
+	const char *const begin{chunk.data()};
+	const char *const end{begin + chunk.length()};
+	const char *pos{begin};
+	const auto &limits{state.limits};
+	while (pos != end)
+	{
+		if (state.expect == expect_t::string && !state.escaped && !state.hexDigits)
+		{
+			const char *const run{findStringSpecial(pos, end)};
+			state.token.append(pos, run);
+			state.offset += size_t(run - pos);
+			pos = run;
+			if (state.token.length() > limits.maxStringLength || state.offset - state.start > limits.maxBytes)
+				return fail(state, JSON_PARSER_TOO_LARGE);
+			if (pos == end)
+				break;
+		}
+
+		const auto chr{*pos};
+		switch (state.expect)
+		{
+			case expect_t::document:
+				if (isWhiteSpace(chr))
+					break;
+				if (!isObjectBegin(chr) && !isArrayBegin(chr))
+					return fail(state, JSON_PARSER_BAD_JSON);
+				state.start = state.offset;
+				startValue(state, chr);
+				break;
+			case expect_t::valueOrEnd:
+				if (isArrayEnd(chr))
+				{
+					closeContainer(state);
+					break;
+				}
+				[[fallthrough]];
+			case expect_t::value:
+				if (isWhiteSpace(chr))
+					break;
+				if (state.expect == expect_t::valueOrEnd && !startMember(state))
+					return state.status;
+				startValue(state, chr);
+				break;
+			case expect_t::keyOrEnd:
+				if (isObjectEnd(chr))
+				{
+					closeContainer(state);
+					break;
+				}
+				if (isQuote(chr) && !startMember(state))
+					return state.status;
+				[[fallthrough]];
+			case expect_t::key:
+				if (isWhiteSpace(chr))
+					break;
+				if (!isQuote(chr))
+					return fail(state, JSON_PARSER_BAD_JSON);
+				state.token.clear();
+				state.isKey = true;
+				state.expect = expect_t::string;
+				break;
+			case expect_t::colon:
+				if (isWhiteSpace(chr))
+					break;
+				if (chr != ':')
+					return fail(state, JSON_PARSER_BAD_JSON);
+				state.expect = expect_t::value;
+				break;
+			case expect_t::next:
+			{
+				if (isWhiteSpace(chr))
+					break;
+				const bool isObject{state.stack.back().object != nullptr};
+				if (chr == ',')
+				{
+					if (!startMember(state))
+						return state.status;
+					state.expect = isObject ? expect_t::key : expect_t::value;
+				}
+				else if (chr == (isObject ? '}' : ']'))
+					closeContainer(state);
+				else
+					return fail(state, JSON_PARSER_BAD_JSON);
+				break;
+			}
+			case expect_t::string:
+				if (state.hexDigits)
+				{
+					if (!isHex(chr))
+						return fail(state, JSON_PARSER_BAD_JSON);
+					--state.hexDigits;
+				}
+				else if (state.escaped)
+				{
+					if (chr == 'u')
+						state.hexDigits = 4U;
+					else if (!isEscape(chr))
+						return fail(state, JSON_PARSER_BAD_JSON);
+					state.escaped = false;
+				}
+				else if (isQuote(chr))
+				{
+					endString(state);
+					break;
+				}
+				else if (isSlash(chr))
+					state.escaped = true;
+				else
+					return fail(state, JSON_PARSER_BAD_JSON);
+				state.token += chr;
+				if (state.token.length() > limits.maxStringLength)
+					return fail(state, JSON_PARSER_TOO_LARGE);
+				break;
+			case expect_t::number:
+				if (isNumberChar(chr))
+				{
+					state.token += chr;
+					break;
+				}
+				// The character after the number has yet to be dealt with, so go round again for it
+				endNumber(state);
+				if (state.status != pushStatus_t::needMore)
+					return state.status;
+				continue;
+			case expect_t::literal:
+				if (chr != state.word.front())
+					return fail(state, JSON_PARSER_BAD_JSON);
+				state.word.remove_prefix(1U);
+				if (state.word.empty())
+					addValue(state, literal(state.literal));
+				break;
+			case expect_t::done:
+				break;
+		}
+		if (state.status == pushStatus_t::error)
+			return state.status;
+		++pos;
+		++state.offset;
+		// Don't take in more of the document than the limits allow
+		if (state.expect != expect_t::document && state.offset - state.start > limits.maxBytes)
+			return fail(state, JSON_PARSER_TOO_LARGE);
+		if (state.status == pushStatus_t::complete)
+			break;
+	}
+	state.used = size_t(pos - begin);
+	return state.status;
+}
+
+pushStatus_t pushParser_t::finish() noexcept
 {
-	memoryStream_t stream{const_cast<char *>(json), length(json)};
-	return rSON::parseJSON(stream);
+	if (push->status == pushStatus_t::needMore)
+		return fail(*push, JSON_PARSER_EOF);
+	return push->status;
 }
+
+void pushParser_t::reset() noexcept
+{
+	auto &state{*push};
+	state.expect = push_t::expect_t::document;
+	state.status = pushStatus_t::needMore;
+	state.error = JSON_PARSER_BAD_JSON;
+	state.offset = 0U;
+	state.start = 0U;
+	state.used = 0U;
+	state.nodes = 0U;
+	state.stack.clear();
+	state.token.clear();
+	state.escaped = false;
+	state.hexDigits = 0U;
+	state.key.clear();
+	state.result.reset();
+}
+
+pushStatus_t pushParser_t::status() const noexcept { return push->status; }
+size_t pushParser_t::consumed() const noexcept { return push->used; }
+size_t pushParser_t::offset() const noexcept { return push->offset; }
+JSONParserErrorType pushParser_t::error() const noexcept { return push->error; }
+std::unique_ptr<JSONAtom> pushParser_t::document() noexcept { return std::move(push->result); }
@@ -15,7 +15,14 @@
 using ssize_t = typename std::make_signed<size_t>::type;
 #endif
 #include <errno.h>
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <exception>
+#include <mutex>
 #include <system_error>
+#include <thread>
+#include <vector>
 
 #include "internal/types.hxx"
 
@@ -109,3 +116,171 @@ bool memoryStream_t::write(const void *const value, const size_t valueLen) noexc
 	// If we did not acomplish a complete write, we consider that a failure.
 	return valueLen == actualLen;
 }
+
+// The state shared between a readAheadStream_t and the thread reading its source. Blocks are filled in
+// order around the ring by the reader, and consumed in the same order - ready counts the blocks that
+// have been filled but not yet consumed, so the reader owns every block that isn't ready.
+struct rSON::internal::readAhead_t final
+{
+private:
+	struct block_t final
+	{
+		std::unique_ptr<char []> data;
+		size_t length{0U};
+		// Whether the source said it was at its end straight after this block was read from it
+		bool last{false};
+	};
+
+	stream_t &source;
+	const size_t blockSize;
+	std::vector<block_t> blocks;
+	mutable std::mutex lock{};
+	std::condition_variable changed{};
+	size_t readIndex{0U};
+	size_t writeIndex{0U};
+	size_t ready{0U};
+	// How much of the block at readIndex has already been consumed
+	size_t offset{0U};
+	// Whether the reader is done with the source, and whether this stream has been read to its end.
+	// These differ as the end is only reported once the blocks before it have been consumed, and
+	// then exactly as the source would have reported it had it been read directly.
+	bool finished{false};
+	bool ended{false};
+	bool stopping{false};
+	std::exception_ptr error{};
+	std::thread reader;
+
+	void readSource();
+
+public:
+	readAhead_t(stream_t &stream, size_t size, size_t count);
+	readAhead_t(const readAhead_t &) = delete;
+	readAhead_t(readAhead_t &&) = delete;
+	~readAhead_t() noexcept;
+	readAhead_t &operator =(const readAhead_t &) = delete;
+	readAhead_t &operator =(readAhead_t &&) = delete;
+
+	bool read(char *value, size_t valueLen, size_t &actualLen);
+	bool atEOF() const;
+};
+
+readAhead_t::readAhead_t(stream_t &stream, const size_t size, const size_t count) : source{stream},
+	blockSize{std::max<size_t>(size, 1U)}, blocks(std::max<size_t>(count, 2U)), reader{}
+{
+	for (auto &block : blocks)
+		block.data.reset(new char[blockSize]);
+	reader = std::thread{[this]() { readSource(); }};
+}
+
+readAhead_t::~readAhead_t() noexcept
+{
+	{
+		std::lock_guard<std::mutex> guard{lock};
+		stopping = true;
+	}
+	changed.notify_all();
+	reader.join();
+}
+
+void readAhead_t::readSource()
+{
+	while (true)
+	{
+		std::unique_lock<std::mutex> guard{lock};
+		changed.wait(guard, [this]() { return stopping || ready < blocks.size(); });
+		if (stopping)
+			return;
+		auto &block{blocks[writeIndex]};
+		guard.unlock();
+
+		bool exhausted{false};
+		std::exception_ptr failure{};
+		try
+		{
+			block.length = 0U;
+			exhausted = !source.read(block.data.get(), blockSize, block.length) || !block.length;
+			block.last = source.atEOF();
+			exhausted |= block.last;
+		}
+		catch (...)
+			{ failure = std::current_exception(); }
+
+		guard.lock();
+		if (block.length)
+		{
+			writeIndex = (writeIndex + 1U) % blocks.size();
+			++ready;
+		}
+		error = failure;
+		finished = exhausted || failure;
+		guard.unlock();
+		changed.notify_all();
+		if (finished)
+			return;
+	}
+}
+
+bool readAhead_t::read(char *const value, const size_t valueLen, size_t &actualLen)
+{
+	actualLen = 0U;
+	std::unique_lock<std::mutex> guard{lock};
+	changed.wait(guard, [this]() { return ready || finished; });
+	if (!ready)
+	{
+		if (error)
+			std::rethrow_exception(error);
+		ended = true;
+		return false;
+	}
+
+	// Hand over as much as is ready, without waiting for any more
+	bool consumed{false};
+	while (actualLen < valueLen && ready)
+	{
+		const auto &block{blocks[readIndex]};
+		const auto length{std::min(valueLen - actualLen, block.length - offset)};
+		std::memcpy(value + actualLen, block.data.get() + offset, length);
+		actualLen += length;
+		offset += length;
+		if (offset == block.length)
+		{
+			ended = block.last;
+			readIndex = (readIndex + 1U) % blocks.size();
+			--ready;
+			offset = 0U;
+			consumed = true;
+		}
+	}
+	guard.unlock();
+	if (consumed)
+		changed.notify_all();
+	return true;
+}
+
+bool readAhead_t::atEOF() const
+{
+	std::lock_guard<std::mutex> guard{lock};
+	return ended;
+}
+
+readAheadStream_t::readAheadStream_t(stream_t &source, const size_t blockSize, const size_t blocks) :
+	state{makeOpaque<readAhead_t>(source, blockSize, blocks)} { }
+
+// Tells the OS that file will be read sequentially, before anything is read from it
+stream_t &sequential(fileStream_t &file) noexcept
+{
+#if !defined(_WIN32) && !defined(__APPLE__)
+	// This is only advice, so there's nothing to be done if it's not taken
+	posix_fadvise(file.descriptor(), 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+	return file;
+}
+
+readAheadStream_t::readAheadStream_t(fileStream_t &source, const size_t blockSize, const size_t blocks) :
+	readAheadStream_t{sequential(source), blockSize, blocks} { }
+
+readAheadStream_t::~readAheadStream_t() noexcept = default;
+
+bool readAheadStream_t::read(void *const value, const size_t valueLen, size_t &actualLen)
+	{ return state->read(static_cast<char *>(value), valueLen, actualLen); }
+bool readAheadStream_t::atEOF() const { return state->atEOF(); }
@@ -0,0 +1,346 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+// SPDX-FileCopyrightText: 2026 agent <agent@local>
+// SPDX-FileContributor: Written by agent <agent@local>
+
+#include <cstring>
+#include <algorithm>
+#include "internal/structural.hxx"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__)
+#define rSON_SSE2
+#include <emmintrin.h>
+#if defined(__GNUC__)
+#define rSON_AVX2
+#include <immintrin.h>
+#endif
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// The character classes of a 64 byte block of input, one bit per byte
+struct blockMasks_t final
+{
+	uint64_t quote{0U};
+	uint64_t backslash{0U};
+	uint64_t whiteSpace{0U};
+	uint64_t op{0U};
+};
+
+using classifier_t = blockMasks_t (*)(const char *block) noexcept;
+
+inline size_t countTrailingZeros(const uint64_t value) noexcept
+{
+#ifdef _MSC_VER
+	unsigned long index{};
+	_BitScanForward64(&index, value);
+	return index;
+#else
+	return static_cast<size_t>(__builtin_ctzll(value));
+#endif
+}
+
+blockMasks_t classifyScalar(const char *const block) noexcept
+{
+	blockMasks_t masks{};
+	for (size_t i{0}; i < 64U; ++i)
+	{
+		const uint64_t bit{uint64_t{1U} << i};
+		switch (block[i])
+		{
+			case '"':
+				masks.quote |= bit;
+				break;
+			case '\\':
+				masks.backslash |= bit;
+				break;
+			case ' ':
+			case '\t':
+			case '\n':
+			case '\r':
+				masks.whiteSpace |= bit;
+				break;
+			case '{':
+			case '}':
+			case '[':
+			case ']':
+			case ':':
+			case ',':
+				masks.op |= bit;
+				break;
+		}
+	}
+	return masks;
+}
+
+#ifdef rSON_SSE2
+blockMasks_t classifySSE2(const char *const block) noexcept
+{
+	const auto quote{_mm_set1_epi8('"')};
+	const auto backslash{_mm_set1_epi8('\\')};
+	const auto space{_mm_set1_epi8(' ')};
+	const auto tab{_mm_set1_epi8('\t')};
+	const auto newLine{_mm_set1_epi8('\n')};
+	const auto carriageReturn{_mm_set1_epi8('\r')};
+	// '[' and ']' are '{' and '}' without bit 5, so setting it folds the brackets onto the braces
+	const auto caseBit{_mm_set1_epi8(0x20)};
+	const auto braceOpen{_mm_set1_epi8('{')};
+	const auto braceClose{_mm_set1_epi8('}')};
+	const auto colon{_mm_set1_epi8(':')};
+	const auto comma{_mm_set1_epi8(',')};
+
+	blockMasks_t masks{};
+	for (size_t i{0}; i < 4U; ++i)
+	{
+		const auto chunk{_mm_loadu_si128(static_cast<const __m128i *>(static_cast<const void *>(block + i * 16U)))};
+		const auto folded{_mm_or_si128(chunk, caseBit)};
+		const auto mask = [&](const __m128i matches) noexcept -> uint64_t
+			{ return uint64_t{static_cast<uint16_t>(_mm_movemask_epi8(matches))} << (i * 16U); };
+
+		masks.quote |= mask(_mm_cmpeq_epi8(chunk, quote));
+		masks.backslash |= mask(_mm_cmpeq_epi8(chunk, backslash));
+		masks.whiteSpace |= mask(_mm_or_si128(
+			_mm_or_si128(_mm_cmpeq_epi8(chunk, space), _mm_cmpeq_epi8(chunk, tab)),
+			_mm_or_si128(_mm_cmpeq_epi8(chunk, newLine), _mm_cmpeq_epi8(chunk, carriageReturn))
+		));
+		masks.op |= mask(_mm_or_si128(
+			_mm_or_si128(_mm_cmpeq_epi8(folded, braceOpen), _mm_cmpeq_epi8(folded, braceClose)),
+			_mm_or_si128(_mm_cmpeq_epi8(chunk, colon), _mm_cmpeq_epi8(chunk, comma))
+		));
+	}
+	return masks;
+}
+#endif
+
+#ifdef rSON_AVX2
+__attribute__((target("avx2"))) blockMasks_t classifyAVX2(const char *const block) noexcept
+{
+	const auto quote{_mm256_set1_epi8('"')};
+	const auto backslash{_mm256_set1_epi8('\\')};
+	const auto space{_mm256_set1_epi8(' ')};
+	const auto tab{_mm256_set1_epi8('\t')};
+	const auto newLine{_mm256_set1_epi8('\n')};
+	const auto carriageReturn{_mm256_set1_epi8('\r')};
+	const auto caseBit{_mm256_set1_epi8(0x20)};
+	const auto braceOpen{_mm256_set1_epi8('{')};
+	const auto braceClose{_mm256_set1_epi8('}')};
+	const auto colon{_mm256_set1_epi8(':')};
+	const auto comma{_mm256_set1_epi8(',')};
+
+	// Lambdas don't inherit the target attribute, so the movemasks are spelt out in full here
+	blockMasks_t masks{};
+	for (size_t i{0}; i < 2U; ++i)
+	{
+		const auto chunk{_mm256_loadu_si256(static_cast<const __m256i *>(static_cast<const void *>(block + i * 32U)))};
+		const auto folded{_mm256_or_si256(chunk, caseBit)};
+		const size_t shift{i * 32U};
+
+		masks.quote |= uint64_t{static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, quote)))} << shift;
+		masks.backslash |=
+			uint64_t{static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, backslash)))} << shift;
+		const auto whiteSpace{_mm256_or_si256(
+			_mm256_or_si256(_mm256_cmpeq_epi8(chunk, space), _mm256_cmpeq_epi8(chunk, tab)),
+			_mm256_or_si256(_mm256_cmpeq_epi8(chunk, newLine), _mm256_cmpeq_epi8(chunk, carriageReturn))
+		)};
+		masks.whiteSpace |= uint64_t{static_cast<uint32_t>(_mm256_movemask_epi8(whiteSpace))} << shift;
+		const auto op{_mm256_or_si256(
+			_mm256_or_si256(_mm256_cmpeq_epi8(folded, braceOpen), _mm256_cmpeq_epi8(folded, braceClose)),
+			_mm256_or_si256(_mm256_cmpeq_epi8(chunk, colon), _mm256_cmpeq_epi8(chunk, comma))
+		)};
+		masks.op |= uint64_t{static_cast<uint32_t>(_mm256_movemask_epi8(op))} << shift;
+	}
+	return masks;
+}
+#endif
+
+// Picks the widest classifier the CPU we're running on supports
+classifier_t selectClassifier() noexcept
+{
+#ifdef rSON_AVX2
+	if (__builtin_cpu_supports("avx2"))
+		return classifyAVX2;
+#endif
+#ifdef rSON_SSE2
+	return classifySSE2;
+#else
+	return classifyScalar;
+#endif
+}
+
+// Returns the characters escaped by a backslash in the block. escapeCarry says whether
+// the first character of the block was escaped by the last character of the previous one.
+inline uint64_t findEscaped(uint64_t backslash, uint64_t &escapeCarry) noexcept
+{
+	uint64_t escaped{escapeCarry};
+	escapeCarry = 0U;
+	// Backslashes are rare, so walk them in order - an escaped backslash escapes nothing
+	while (backslash)
+	{
+		const uint64_t bit{backslash & (~backslash + 1U)};
+		backslash ^= bit;
+		if (escaped & bit)
+			continue;
+		if (bit == uint64_t{1U} << 63U)
+			escapeCarry = 1U;
+		else
+			escaped |= bit << 1U;
+	}
+	return escaped;
+}
+
+// Turns the bits marking quotes into a mask of everything from each opening quote up to
+// (but not including) its closing quote
+inline uint64_t prefixXor(uint64_t bits) noexcept
+{
+	bits ^= bits << 1U;
+	bits ^= bits << 2U;
+	bits ^= bits << 4U;
+	bits ^= bits << 8U;
+	bits ^= bits << 16U;
+	bits ^= bits << 32U;
+	return bits;
+}
+
+structuralIndex_t::structuralIndex_t(const std::string_view json) : structuralIndex_t{json, structuralIndex_t{}} { }
+
+structuralIndex_t::structuralIndex_t(const std::string_view json, structuralIndex_t &&reuse) :
+	blocks{(json.length() + 63U) / 64U}, length{json.length()}
+{
+	if (!blocks)
+		return;
+	if (reuse.bitmap.use_count() == 1 && reuse.capacity >= blocks)
+	{
+		bitmap = std::move(reuse.bitmap);
+		capacity = reuse.capacity;
+	}
+	else
+	{
+		bitmap.reset(new uint64_t[blocks]);
+		capacity = blocks;
+	}
+	const auto classify{selectClassifier()};
+	uint64_t escapeCarry{0U};
+	uint64_t inStringCarry{0U};
+	uint64_t scalarCarry{0U};
+
+	auto *const index{bitmap.get()};
+	for (size_t block{0}; block < blocks; ++block)
+	{
+		const size_t offset{block * 64U};
+		blockMasks_t masks{};
+		if (length - offset >= 64U)
+			masks = classify(json.data() + offset);
+		else
+		{
+			// Pad the final partial block out with whitespace, which never gets marked
+			char tail[64];
+			memset(tail, ' ', sizeof(tail));
+			memcpy(tail, json.data() + offset, length - offset);
+			masks = classify(tail);
+		}
+
+		const uint64_t quotes{masks.quote & ~findEscaped(masks.backslash, escapeCarry)};
+		const uint64_t inString{prefixXor(quotes) ^ inStringCarry};
+		inStringCarry = inString >> 63U ? ~uint64_t{0U} : 0U;
+		// Numbers and literals start at any non-whitespace, non-operator character that doesn't follow another
+		const uint64_t scalar{~(masks.op | masks.whiteSpace)};
+		const uint64_t nonQuoteScalar{scalar & ~masks.quote};
+		const uint64_t scalarStart{scalar & ~((nonQuoteScalar << 1U) | scalarCarry)};
+		scalarCarry = nonQuoteScalar >> 63U;
+
+		index[block] = ((masks.op | scalarStart) & ~inString) | quotes;
+	}
+}
+
+size_t structuralIndex_t::next(const size_t offset) const noexcept
+{
+	size_t word{offset / 64U};
+	if (word >= blocks)
+		return length;
+	uint64_t bits{bitmap[word] & (~uint64_t{0U} << (offset % 64U))};
+	while (!bits)
+	{
+		if (++word == blocks)
+			return length;
+		bits = bitmap[word];
+	}
+	return std::min(word * 64U + countTrailingZeros(bits), length);
+}
+
+inline bool isStringSpecial(const char chr) noexcept
+	{ return chr == '"' || chr == '\\' || (chr >= 0 && chr <= 0x1F) || chr == 0x7F; }
+
+using stringScanner_t = const char *(*)(const char *begin, const char *end) noexcept;
+
+const char *findStringSpecialScalar(const char *begin, const char *const end) noexcept
+{
+	while (begin != end && !isStringSpecial(*begin))
+		++begin;
+	return begin;
+}
+
+#ifdef rSON_SSE2
+const char *findStringSpecialSSE2(const char *begin, const char *const end) noexcept
+{
+	const auto quote{_mm_set1_epi8('"')};
+	const auto backslash{_mm_set1_epi8('\\')};
+	const auto del{_mm_set1_epi8(0x7F)};
+	const auto maxControl{_mm_set1_epi8(0x1F)};
+
+	for (; end - begin >= 16; begin += 16)
+	{
+		const auto chunk{_mm_loadu_si128(static_cast<const __m128i *>(static_cast<const void *>(begin)))};
+		// A byte is a control character if the unsigned max of it and 0x1F is 0x1F
+		const auto special{_mm_or_si128(
+			_mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)),
+			_mm_or_si128(_mm_cmpeq_epi8(chunk, del), _mm_cmpeq_epi8(_mm_max_epu8(chunk, maxControl), maxControl))
+		)};
+		const auto mask{static_cast<uint32_t>(_mm_movemask_epi8(special))};
+		if (mask)
+			return begin + countTrailingZeros(mask);
+	}
+	return findStringSpecialScalar(begin, end);
+}
+#endif
+
+#ifdef rSON_AVX2
+__attribute__((target("avx2"))) const char *findStringSpecialAVX2(const char *begin, const char *const end) noexcept
+{
+	const auto quote{_mm256_set1_epi8('"')};
+	const auto backslash{_mm256_set1_epi8('\\')};
+	const auto del{_mm256_set1_epi8(0x7F)};
+	const auto maxControl{_mm256_set1_epi8(0x1F)};
+
+	for (; end - begin >= 32; begin += 32)
+	{
+		const auto chunk{_mm256_loadu_si256(static_cast<const __m256i *>(static_cast<const void *>(begin)))};
+		const auto special{_mm256_or_si256(
+			_mm256_or_si256(_mm256_cmpeq_epi8(chunk, quote), _mm256_cmpeq_epi8(chunk, backslash)),
+			_mm256_or_si256(_mm256_cmpeq_epi8(chunk, del), _mm256_cmpeq_epi8(_mm256_max_epu8(chunk, maxControl), maxControl))
+		)};
+		const auto mask{static_cast<uint32_t>(_mm256_movemask_epi8(special))};
+		if (mask)
+			return begin + countTrailingZeros(mask);
+	}
+	return findStringSpecialSSE2(begin, end);
+}
+#endif
+
+stringScanner_t selectStringScanner() noexcept
+{
+#ifdef rSON_AVX2
+	if (__builtin_cpu_supports("avx2"))
+		return findStringSpecialAVX2;
+#endif
+#ifdef rSON_SSE2
+	return findStringSpecialSSE2;
+#else
+	return findStringSpecialScalar;
+#endif
+}
+
+const char *findStringSpecial(const char *const begin, const char *const end) noexcept
+{
+	static const auto scanner{selectStringScanner()};
+	return scanner(begin, end);
+}
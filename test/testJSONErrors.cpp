@@ -16,6 +16,9 @@ void testParserError()
 	tryParserErrorOk(JSON_PARSER_EOF);
 	tryParserErrorOk(JSON_PARSER_BAD_JSON);
 	tryParserErrorOk(JSON_PARSER_BAD_FILE);
+	tryParserErrorOk(JSON_PARSER_TOO_DEEP);
+	tryParserErrorOk(JSON_PARSER_TOO_LARGE);
+	tryParserErrorOk(JSON_PARSER_DUPLICATE_KEY);
 
 	const JSONParserError err{static_cast<JSONParserErrorType>(-1)};
 	assertNotNull(err.what());
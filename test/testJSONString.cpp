@@ -66,10 +66,15 @@ void testEscapes()
 	TRY("\\u0155"s, assertStringEqual(str, "\xC5\x95"));
 	TRY("\\u5555"s, assertStringEqual(str, "\xE5\x95\x95"));
 	TRY("\\u5A5A"s, assertStringEqual(str, "\xE5\xA9\x9A"));
+	TRY("\\uD83D\\uDE00"s, assertStringEqual(str, "\xF0\x9F\x98\x80"));
+	TRY("a\\uD83Db"s, assertStringEqual(str, "a\xED\xA0\xBD" "b"));
+	TRY("\\uD83D\\n"s, assertStringEqual(str, "\xED\xA0\xBD\n"));
 	TRY_SHOULD_FAIL("\\u5A5Q"s);
 	TRY_SHOULD_FAIL("\\u%A5A"s);
 	TRY_SHOULD_FAIL("\\u5=5A"s);
 	TRY_SHOULD_FAIL("\\u5A^A"s);
+	TRY_SHOULD_FAIL("\\u5A"s);
+	TRY_SHOULD_FAIL("\\q"s);
 }
 
 #undef TRY_SHOULD_FAIL
@@ -4,21 +4,84 @@
 // SPDX-FileContributor: Written by Rachel Mant <git@dragonmux.network>
 // SPDX-FileContributor: Modified by Aki Van Ness <aki@lethalbit.net>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <optional>
 #include <string>
+#include <thread>
+#include <vector>
 #include <substrate/fd>
 #include "test.h"
 #include "internal/parser.hxx"
 
 using namespace std::literals::string_literals;
+using namespace std::literals::string_view_literals;
 using substrate::fd_t;
 
+// Counts every allocation made through operator new, so tests can check what a parse allocates. Every form
+// of new and delete is replaced - the nothrow and aligned ones included - so that whichever form allocated a
+// block, the one freeing it agrees on where it came from.
+static std::atomic<size_t> allocations{0U};
+
+static void *allocate(const size_t size, const size_t alignment = alignof(std::max_align_t)) noexcept
+{
+	++allocations;
+	if (alignment <= alignof(std::max_align_t))
+		return malloc(size ? size : 1U);
+	// aligned_alloc() requires the size be a multiple of the alignment
+	return aligned_alloc(alignment, (std::max<size_t>(size, 1U) + alignment - 1U) & ~(alignment - 1U));
+}
+
+void *operator new(const size_t size)
+{
+	if (auto *const memory{allocate(size)})
+		return memory;
+	throw std::bad_alloc{};
+}
+
+void *operator new(const size_t size, const std::align_val_t alignment)
+{
+	if (auto *const memory{allocate(size, static_cast<size_t>(alignment))})
+		return memory;
+	throw std::bad_alloc{};
+}
+
+void *operator new[](const size_t size) { return operator new(size); }
+void *operator new[](const size_t size, const std::align_val_t alignment) { return operator new(size, alignment); }
+void *operator new(const size_t size, const std::nothrow_t &) noexcept { return allocate(size); }
+void *operator new[](const size_t size, const std::nothrow_t &) noexcept { return allocate(size); }
+void *operator new(const size_t size, const std::align_val_t alignment, const std::nothrow_t &) noexcept
+	{ return allocate(size, static_cast<size_t>(alignment)); }
+void *operator new[](const size_t size, const std::align_val_t alignment, const std::nothrow_t &) noexcept
+	{ return allocate(size, static_cast<size_t>(alignment)); }
+
+void operator delete(void *const memory) noexcept { free(memory); }
+void operator delete[](void *const memory) noexcept { free(memory); }
+void operator delete(void *const memory, size_t) noexcept { free(memory); }
+void operator delete[](void *const memory, size_t) noexcept { free(memory); }
+void operator delete(void *const memory, std::align_val_t) noexcept { free(memory); }
+void operator delete[](void *const memory, std::align_val_t) noexcept { free(memory); }
+void operator delete(void *const memory, size_t, std::align_val_t) noexcept { free(memory); }
+void operator delete[](void *const memory, size_t, std::align_val_t) noexcept { free(memory); }
+void operator delete(void *const memory, const std::nothrow_t &) noexcept { free(memory); }
+void operator delete[](void *const memory, const std::nothrow_t &) noexcept { free(memory); }
+void operator delete(void *const memory, std::align_val_t, const std::nothrow_t &) noexcept { free(memory); }
+void operator delete[](void *const memory, std::align_val_t, const std::nothrow_t &) noexcept { free(memory); }
+
 void testParserViability()
 {
 	const char *const json = "[]";
 	memoryStream_t stream(const_cast<char *const>(json), length(json));
 	JSONParser parser(stream);
 	assertTrue(parser.currentChar() == '[');
-	assertFalse(stream.atEOF());
+	// The parser pulls its input in blocks, so this small input should be consumed whole
+	assertTrue(stream.atEOF());
 }
 
 void tryViabilityFail(JSONParser &parser, void test(JSONParser &))
@@ -42,6 +105,214 @@ void testStreamViability()
 	tryViabilityFail(parser, [](JSONParser &parser) { parser.nextChar(); });
 }
 
+void testStreamBlocks()
+{
+	// Build an array that spans several of the parser's input blocks
+	std::string json{"["};
+	for (size_t i{0}; i < 32768U; ++i)
+		json += "1,\t";
+	json += "2]";
+	memoryStream_t stream{json.data(), json.size() + 1};
+	JSONParser parser{stream};
+	try
+	{
+		auto atom{array(parser)};
+		assertNotNull(atom.get());
+		const JSONArray &array{*atom};
+		assertIntEqual(array.size(), 32769);
+		assertIntEqual(array[0].asInt(), 1);
+		assertIntEqual(array[32767].asInt(), 1);
+		assertIntEqual(array[32768].asInt(), 2);
+	}
+	catch (const JSONParserError &err)
+		{ fail(err.error()); }
+}
+
+void testNumberBlocks()
+{
+	// Put a long number across the boundary between two of the parser's input blocks at every alignment
+	for (size_t offset{32750U}; offset < 32768U; ++offset)
+	{
+		std::string json{"[" + std::string(offset - 1U, ' ') + "1234567890123456.789012345678e2]"};
+		memoryStream_t stream{json.data(), json.size() + 1U};
+		JSONParser parser{stream};
+		try
+		{
+			auto atom{array(parser)};
+			assertTrue(atom->asArrayRef()[0].asFloat() == 1234567890123456.789012345678e2);
+		}
+		catch (const JSONParserError &err)
+			{ fail(err.error()); }
+	}
+}
+
+// A source with rpcStream_t's semantics - reads hand back as much of what has arrived as fits, the end of a
+// message is a read that ends in a newline, and syncing skips past the rest of the current message
+struct messageStream_t final : public stream_t
+{
+private:
+	std::string_view data;
+	char lastRead{0};
+
+public:
+	messageStream_t(const std::string_view messages) noexcept : data{messages} { }
+
+	bool read(void *const value, const size_t valueLen, size_t &actualLen) noexcept final
+	{
+		actualLen = std::min(valueLen, data.size());
+		memcpy(value, data.data(), actualLen);
+		data.remove_prefix(actualLen);
+		if (actualLen)
+			lastRead = static_cast<char *>(value)[actualLen - 1U];
+		return actualLen == valueLen;
+	}
+
+	bool atEOF() const noexcept final { return lastRead == '\n'; }
+
+	void readSync() noexcept final
+	{
+		if (lastRead != '\n')
+		{
+			const auto newline{data.find('\n')};
+			data.remove_prefix(newline == std::string_view::npos ? data.size() : newline + 1U);
+		}
+		lastRead = 0;
+	}
+};
+
+// Messages that arrive together must each be parsed in turn, without the first swallowing the rest
+void testPipelinedMessages()
+{
+	messageStream_t stream{"[1]\n{\"a\": [2, 3]}\n[4]\n"sv};
+	try
+	{
+		assertIntEqual(parseJSON(stream)->asArrayRef()[0].asInt(), 1);
+		assertIntEqual(parseJSON(stream)->asObjectRef()["a"][size_t{1U}].asInt(), 3);
+		assertIntEqual(parseJSON(stream)->asArrayRef()[0].asInt(), 4);
+	}
+	catch (const JSONParserError &err)
+		{ fail(err.error()); }
+}
+
+// A source that hands out its data in small pieces and then fails, to check errors make it through read-ahead
+struct failingStream_t final : public stream_t
+{
+private:
+	std::string_view data;
+
+public:
+	failingStream_t(const std::string_view json) noexcept : data{json} { }
+
+	bool read(void *const value, const size_t valueLen, size_t &actualLen) final
+	{
+		if (data.empty())
+			throw std::system_error{EIO, std::system_category()};
+		actualLen = std::min<size_t>({valueLen, data.size(), 100U});
+		memcpy(value, data.data(), actualLen);
+		data.remove_prefix(actualLen);
+		return true;
+	}
+
+	bool atEOF() const noexcept final { return false; }
+};
+
+void testReadAheadStream()
+{
+	std::string json{"["};
+	for (size_t i{0U}; i < 20000U; ++i)
+		json += "{\"id\": "s + std::to_string(i) + ", \"name\": \"record\"},"s;
+	json.back() = ']';
+	const auto check = [](const std::unique_ptr<JSONAtom> &atom)
+	{
+		assertNotNull(atom.get());
+		const auto &array{atom->asArrayRef()};
+		assertIntEqual(array.size(), 20000U);
+		assertIntEqual(array[19999U]["id"].asInt(), 19999);
+	};
+
+	// Blocks much smaller than the parser's window, so reads span blocks and the ring wraps many times
+	for (const auto &[blockSize, blocks] : {std::pair<size_t, size_t>{1000U, 2U}, {65536U, 3U}, {1U << 20U, 3U}})
+	{
+		memoryStream_t source{json.data(), json.length() + 1U};
+		readAheadStream_t stream{source, blockSize, blocks};
+		check(parseJSON(stream));
+	}
+
+	[&]()
+	{
+		fd_t file{"readAhead.json", O_WRONLY | O_CREAT | O_TRUNC | O_NOCTTY, substrate::normalMode};
+		assertTrue(file.valid());
+		assertTrue(file.write(json));
+	}();
+	try
+	{
+		fileStream_t file{"readAhead.json", O_RDONLY | O_NOCTTY};
+		readAheadStream_t stream{file};
+		check(parseJSON(stream));
+		size_t actualLen{0U};
+		char buffer[16];
+		assertTrue(stream.atEOF());
+		assertFalse(stream.read(buffer, sizeof(buffer), actualLen));
+		assertIntEqual(actualLen, 0U);
+	}
+	catch (const JSONParserError &err)
+		{ fail(err.error()); }
+	unlink("readAhead.json");
+
+	// An empty source is at its end straight away, and a truncated one ends early
+	std::string empty{};
+	memoryStream_t emptySource{empty.data(), 0U};
+	readAheadStream_t emptyStream{emptySource};
+	size_t actualLen{0U};
+	char buffer[16];
+	assertFalse(emptyStream.read(buffer, sizeof(buffer), actualLen));
+	assertTrue(emptyStream.atEOF());
+	try
+	{
+		memoryStream_t source{json.data(), json.length() / 2U};
+		readAheadStream_t stream{source, 4096U, 2U};
+		parseJSON(stream);
+		fail("Parsing succeeded on truncated input");
+	}
+	catch (const JSONParserError &err)
+		{ assertTrue(err.errorType() == JSON_PARSER_EOF); }
+
+	// Errors from the source come out once everything read before them has been used
+	failingStream_t failingSource{"[1, 2, 3,"sv};
+	readAheadStream_t failingStream{failingSource, 4U, 2U};
+	std::string read{};
+	try
+	{
+		while (true)
+		{
+			assertTrue(failingStream.read(buffer, sizeof(buffer), actualLen));
+			read.append(buffer, actualLen);
+		}
+	}
+	catch (const std::system_error &error)
+		{ assertIntEqual(error.code().value(), EIO); }
+	assertStringEqual(read.c_str(), "[1, 2, 3,");
+	assertFalse(failingStream.atEOF());
+}
+
+void testStructuralIndex()
+{
+	const std::string_view json{R"({"a\"b": [true, -1 ,"c\\"], "d": null})"};
+	const std::vector<size_t> expected{0, 1, 6, 7, 9, 10, 14, 16, 19, 20, 24, 25, 26, 28, 30, 31, 33, 37};
+	// Shift the document through every alignment against the 64 byte blocks the index is built from
+	for (size_t shift{0}; shift < 70U; ++shift)
+	{
+		const std::string input{std::string(shift, ' ') + std::string{json}};
+		const structuralIndex_t index{input};
+		assertTrue(index.valid());
+		std::vector<size_t> positions{};
+		for (size_t offset{index.next(0)}; offset != input.size(); offset = index.next(offset + 1U))
+			positions.push_back(offset - shift);
+		assertTrue(positions == expected);
+	}
+	assertFalse(structuralIndex_t{}.valid());
+}
+
 void testPower10()
 {
 	assertIntEqual(power10(0), 1);
@@ -85,9 +356,34 @@ void testLiteral()
 	tryLiteralOk("false ", [](const JSONAtom &atom) { assertFalse(atom.asBool()); });
 	tryLiteralOk("null ", [](const JSONAtom &atom) { assertNull(atom.asNull()); });
 
+	tryLiteralOk("null]", [](const JSONAtom &atom) { assertNull(atom.asNull()); });
+
 	tryLiteralFail("invalid ");
 	tryLiteralFail("a ");
 	tryLiteralFail("0 ");
+	tryLiteralFail("truex ");
+	tryLiteralFail("fals ");
+	tryLiteralFail("nul");
+	tryLiteralFail("nulL ");
+
+	// Literals straddling the boundary between two of the parser's input blocks
+	for (size_t offset{32763U}; offset < 32768U; ++offset)
+	{
+		std::string json{"[" + std::string(offset - 1U, ' ') + "false, null, true]"};
+		memoryStream_t stream{json.data(), json.size() + 1U};
+		JSONParser parser{stream};
+		try
+		{
+			auto atom{array(parser)};
+			const auto &array{atom->asArrayRef()};
+			assertIntEqual(array.size(), 3);
+			assertFalse(array[0].asBool());
+			assertNull(array[1].asNull());
+			assertTrue(array[2].asBool());
+		}
+		catch (const JSONParserError &err)
+			{ fail(err.error()); }
+	}
 }
 
 void tryNumberOk(const char *const json, void tests(const JSONAtom &))
@@ -133,6 +429,35 @@ void testIntNumber()
 	tryNumberOk("0xFF ", [](const JSONAtom &atom) { assertIntEqual(atom.asInt(), 255); });
 	tryNumberOk("0o666 ", [](const JSONAtom &atom) { assertIntEqual(atom.asInt(), 438); });
 	tryNumberOk("0b111 ", [](const JSONAtom &atom) { assertIntEqual(atom.asInt(), 7); });
+	tryNumberOk("0xff ", [](const JSONAtom &atom) { assertIntEqual(atom.asInt(), 255); });
+	tryNumberOk("-0x10 ", [](const JSONAtom &atom) { assertIntEqual(atom.asInt(), -16); });
+	tryNumberOk("12345678901234567 ",
+		[](const JSONAtom &atom) { assertInt64Equal(atom.asInt(), int64_t{12345678901234567}); });
+	tryNumberOk("9223372036854775807 ",
+		[](const JSONAtom &atom) { assertInt64Equal(atom.asInt(), INT64_MAX); });
+	tryNumberOk("-9223372036854775808 ",
+		[](const JSONAtom &atom) { assertInt64Equal(atom.asInt(), INT64_MIN); });
+	tryNumberOk("0x7fffffffffffffff ", [](const JSONAtom &atom) { assertInt64Equal(atom.asInt(), INT64_MAX); });
+	// Prefixed literals take the whole 64 bits as a two's complement pattern
+	tryNumberOk("0xFFFFFFFFFFFFFFFF ", [](const JSONAtom &atom) { assertInt64Equal(atom.asInt(), -1); });
+	// Integers which don't fit get promoted to floats rather than wrapping
+	tryNumberOk("9223372036854775808 ", [](const JSONAtom &atom)
+	{
+		assertIntEqual(atom.getType(), JSON_TYPE_FLOAT);
+		assertTrue(atom.asFloat() == 9223372036854775808.0);
+	});
+	tryNumberOk("-123456789012345678901234567890 ", [](const JSONAtom &atom)
+	{
+		assertIntEqual(atom.getType(), JSON_TYPE_FLOAT);
+		assertTrue(atom.asFloat() == -123456789012345678901234567890.0);
+	});
+	tryNumberOk("0x10000000000000000 ", [](const JSONAtom &atom)
+	{
+		assertIntEqual(atom.getType(), JSON_TYPE_FLOAT);
+		assertTrue(atom.asFloat() == 18446744073709551616.0);
+	});
+	tryNumberOk("1e18 ", [](const JSONAtom &atom) { assertInt64Equal(atom.asInt(), int64_t{1000000000000000000}); });
+	tryNumberOk("1e19 ", [](const JSONAtom &atom) { assertTrue(atom.asFloat() == 1e19); });
 
 
 	tryNumberFail("");
@@ -159,6 +484,29 @@ void testFloatNumber()
 	tryNumberOk("0.00 ", [](const JSONAtom &atom) { assertDoubleEqual(atom.asFloat(), 0.0); });
 	tryNumberOk("0.0015 ", [](const JSONAtom &atom) { assertDoubleEqual(atom.asFloat(), 0.0015); });
 	tryNumberOk("0.00150 ", [](const JSONAtom &atom) { assertDoubleEqual(atom.asFloat(), 0.0015); });
+	tryNumberOk("191e-1 ", [](const JSONAtom &atom) { assertDoubleEqual(atom.asFloat(), 19.1); });
+
+	// These must come out correctly rounded, so compare exactly
+	tryNumberOk("0.1 ", [](const JSONAtom &atom) { assertTrue(atom.asFloat() == 0.1); });
+	tryNumberOk("1.5e300 ", [](const JSONAtom &atom) { assertTrue(atom.asFloat() == 1.5e300); });
+	tryNumberOk("1.7976931348623157e308 ",
+		[](const JSONAtom &atom) { assertTrue(atom.asFloat() == 1.7976931348623157e308); });
+	tryNumberOk("2.2250738585072014e-308 ",
+		[](const JSONAtom &atom) { assertTrue(atom.asFloat() == 2.2250738585072014e-308); });
+	tryNumberOk("4.9e-324 ", [](const JSONAtom &atom) { assertTrue(atom.asFloat() == 4.9e-324); });
+	tryNumberOk("-8.98846567431158e307 ",
+		[](const JSONAtom &atom) { assertTrue(atom.asFloat() == -8.98846567431158e307); });
+	tryNumberOk("3.14159265358979323846264338327950288 ",
+		[](const JSONAtom &atom) { assertTrue(atom.asFloat() == 3.14159265358979323846264338327950288); });
+	// Exactly half way between two doubles, which must round to even
+	tryNumberOk("9007199254740993.0 ", [](const JSONAtom &atom) { assertTrue(atom.asFloat() == 9007199254740992.0); });
+	tryNumberOk("1.00000000000000011102230246251565404236316680908203125 ",
+		[](const JSONAtom &atom) { assertTrue(atom.asFloat() == 1.0); });
+	tryNumberOk("1.00000000000000011102230246251565404236316680908203126 ",
+		[](const JSONAtom &atom) { assertTrue(atom.asFloat() == 1.0000000000000002); });
+	tryNumberOk("1e-400 ", [](const JSONAtom &atom) { assertTrue(atom.asFloat() == 0.0); });
+	tryNumberOk("0.0000000000000000000000000000001e1000 ",
+		[](const JSONAtom &atom) { assertTrue(atom.asFloat() == HUGE_VAL); });
 
 	tryNumberFail("00.0 ");
 	tryNumberFail("0.0e00 ");
@@ -423,6 +771,1587 @@ void testParseJSON()
 	TRY_SHOULD_FAIL("\"true\"");
 }
 
+void testNesting()
+{
+	// Check the default limit is generous enough for ordinary documents
+	std::string json{std::string(512U, '[') + std::string(512U, ']')};
+	auto atom{parseJSON(json)};
+	assertNotNull(atom.get());
+	assertTrue(atom->typeIs(JSON_TYPE_ARRAY));
+
+	// Check it also stops adversarially deep input cleanly, rather than running out of stack
+	json = std::string(100000U, '[') + std::string(100000U, ']');
+	try
+	{
+		parseJSON(json);
+		fail("The parser failed to stop at its nesting limit");
+	}
+	catch (const JSONParserError &error)
+		{ assertTrue(error.errorType() == JSON_PARSER_TOO_DEEP); }
+	// Check that deeper input parses given a large enough limit
+	json = std::string(2048U, '[') + std::string(2048U, ']');
+	try
+	{
+		parseJSON(json);
+		fail("The parser failed to stop at its nesting limit");
+	}
+	catch (const JSONParserError &error)
+		{ assertTrue(error.errorType() == JSON_PARSER_TOO_DEEP); }
+	atom = parseJSON(json, parseLimits_t{2048U});
+	assertNotNull(atom.get());
+
+	// Check the limit applies to objects and arrays alike, and counts the outermost level
+	const auto tooDeep = [](const char *const json)
+	{
+		try
+		{
+			parseJSON(json, parseLimits_t{3U});
+			fail("The parser failed to stop at its nesting limit");
+		}
+		catch (const JSONParserError &error)
+			{ assertTrue(error.errorType() == JSON_PARSER_TOO_DEEP); }
+	};
+	tooDeep("[[[[1]]]]");
+	tooDeep("{\"a\": {\"b\": [{}]}}");
+	atom = parseJSON("{\"a\": {\"b\": [1, 2]}, \"c\": [[true], {}]}", parseLimits_t{3U});
+	assertNotNull(atom.get());
+	auto &object{atom->asObjectRef()};
+	assertIntEqual(object.size(), 2);
+	assertIntEqual(object["a"]["b"].asArrayRef().size(), 2);
+	assertIntEqual(object["c"].asArrayRef().size(), 2);
+	assertTrue(object["c"][size_t{0U}][size_t{0U}].asBool());
+
+	// Check the limit applies when parsing from a stream too
+	const char *const streamJSON{"[[[[]]]]"};
+	memoryStream_t stream{const_cast<char *>(streamJSON), length(streamJSON)};
+	try
+	{
+		parseJSON(stream, parseLimits_t{2U});
+		fail("The parser failed to stop at its nesting limit");
+	}
+	catch (const JSONParserError &error)
+		{ assertTrue(error.errorType() == JSON_PARSER_TOO_DEEP); }
+
+	// Check malformed nesting still fails as bad JSON
+	for (const char *const bad : {"[1,]", "{\"a\": 1,}", "[1 2]", "{\"a\" 1}", "[[1}]", "[{]", "[1", "{\"a\": [}"})
+	{
+		try
+		{
+			parseJSON(bad);
+			fail("The parser failed to reject malformed nesting");
+		}
+		catch (const JSONParserError &error)
+			{ assertTrue(error.errorType() == JSON_PARSER_BAD_JSON || error.errorType() == JSON_PARSER_EOF); }
+	}
+}
+
+void testPushParser()
+{
+	const auto json{"  {\"a\\\"}\": [1, {\"b\": \"[\\\\\"}, -2.5e3], \"c\": {}}"sv};
+	pushParser_t parser{};
+	// Check the parser copes with the input arriving a byte at a time
+	for (size_t i{0}; i < json.length() - 1U; ++i)
+	{
+		assertTrue(parser.feed(json.substr(i, 1U)) == pushStatus_t::needMore);
+		assertIntEqual(parser.consumed(), 1);
+	}
+	assertTrue(parser.feed(json.substr(json.length() - 1U)) == pushStatus_t::complete);
+	assertTrue(parser.status() == pushStatus_t::complete);
+	auto atom{parser.document()};
+	assertNotNull(atom.get());
+	auto &object{atom->asObjectRef()};
+	assertIntEqual(object.size(), 2);
+	auto &array{object["a\\\"}"].asArrayRef()};
+	assertIntEqual(array.size(), 3);
+	assertIntEqual(array[size_t{0U}].asInt(), 1);
+	assertStringEqual(array[1]["b"].asString().c_str(), "[\\");
+	assertTrue(array[2].asFloat() == -2500.0);
+	assertIntEqual(object["c"].asObjectRef().size(), 0);
+	// Once complete, further input is ignored until the parser is reset
+	assertTrue(parser.feed("[]"sv) == pushStatus_t::complete);
+	assertIntEqual(parser.consumed(), 0);
+
+	// Check input following a document is left for the next one
+	parser.reset();
+	const auto documents{"[1]\n[true, 2] {}"sv};
+	assertTrue(parser.feed(documents) == pushStatus_t::complete);
+	assertIntEqual(parser.consumed(), 3);
+	assertIntEqual(parser.document()->asArrayRef().size(), 1);
+	parser.reset();
+	assertTrue(parser.feed(documents.substr(3U)) == pushStatus_t::complete);
+	assertIntEqual(parser.consumed(), 10);
+	assertIntEqual(parser.document()->asArrayRef().size(), 2);
+	parser.reset();
+	assertTrue(parser.feed(documents.substr(13U)) == pushStatus_t::complete);
+	assertIntEqual(parser.consumed(), 3);
+	parser.reset();
+	assertTrue(parser.feed(" \n"sv) == pushStatus_t::needMore);
+
+	// Check a document cut short is reported when the input ends
+	parser.reset();
+	assertTrue(parser.feed("{\"a\": [1, 2"sv) == pushStatus_t::needMore);
+	assertTrue(parser.finish() == pushStatus_t::error);
+	assertTrue(parser.error() == JSON_PARSER_EOF);
+
+	// Check malformed input is rejected as soon as it can be told apart, and the rest when complete
+	const auto failure = [](const std::string_view json, const JSONParserErrorType error)
+	{
+		pushParser_t parser{parseLimits_t{4U}};
+		assertTrue(parser.feed(json) == pushStatus_t::error);
+		assertTrue(parser.status() == pushStatus_t::error);
+		assertTrue(parser.error() == error);
+		assertNull(parser.document().get());
+	};
+	failure("true"sv, JSON_PARSER_BAD_JSON);
+	failure("[}"sv, JSON_PARSER_BAD_JSON);
+	failure("{\"a\": [1}"sv, JSON_PARSER_BAD_JSON);
+	failure("[\"a\nb\""sv, JSON_PARSER_BAD_JSON);
+	failure("[[[[[1"sv, JSON_PARSER_TOO_DEEP);
+	failure("[1 2]"sv, JSON_PARSER_BAD_JSON);
+	failure("{\"a\": tru}"sv, JSON_PARSER_BAD_JSON);
+
+	// Check problems are found at the byte they happen, without waiting for the document to end
+	const auto failsAt = [](const std::string_view json, const JSONParserErrorType error, const size_t offset)
+	{
+		pushParser_t parser{};
+		for (size_t i{0}; i < json.length() - 1U; ++i)
+			assertTrue(parser.feed(json.substr(i, 1U)) == pushStatus_t::needMore);
+		assertTrue(parser.feed(json.substr(json.length() - 1U)) == pushStatus_t::error);
+		assertTrue(parser.error() == error);
+		assertIntEqual(parser.offset(), offset);
+	};
+	failsAt("  {\"a\" 1"sv, JSON_PARSER_BAD_JSON, 7U);
+	failsAt("[1, 2, }"sv, JSON_PARSER_BAD_JSON, 7U);
+	failsAt("[\"a\\q"sv, JSON_PARSER_BAD_JSON, 4U);
+	failsAt("[\"\\u12G"sv, JSON_PARSER_BAD_JSON, 6U);
+	failsAt("[nul1"sv, JSON_PARSER_BAD_JSON, 4U);
+	failsAt("[1, 00,"sv, JSON_PARSER_BAD_JSON, 5U);
+	failsAt("[1, 1.e]"sv, JSON_PARSER_BAD_JSON, 6U);
+
+	// Check values split across chunks come out as if the document had been parsed in one go
+	const auto document{"{\"a\": [0x1F, -12.5e-1, 18446744073709551616, 0], \"b\\u00e9\": "
+		"\"\\ud83d\\ude00 x\", \"c\": [true, false, null, {}], \"d\": [[]]}"sv};
+	const auto expected{parseJSON(document)};
+	for (size_t split{1U}; split < document.length(); ++split)
+	{
+		pushParser_t splitParser{};
+		assertTrue(splitParser.feed(document.substr(0U, split)) == pushStatus_t::needMore);
+		assertTrue(splitParser.feed(document.substr(split)) == pushStatus_t::complete);
+		assertIntEqual(splitParser.consumed(), document.length() - split);
+		const auto result{splitParser.document()};
+		assertNotNull(result.get());
+		auto &object{result->asObjectRef()};
+		assertIntEqual(object["a"][size_t{0U}].asInt(), 31);
+		assertTrue(object["a"][1].asFloat() == expected->asObjectRef()["a"][1].asFloat());
+		assertTrue(object["a"][2].asFloat() == expected->asObjectRef()["a"][2].asFloat());
+		assertStringEqual(object["b\\u00e9"].asString().c_str(), "\xF0\x9F\x98\x80 x");
+		assertIntEqual(object["c"].asArrayRef().size(), 4);
+		assertTrue(object["c"][1].asBool() == false);
+		assertIntEqual(object["d"][size_t{0U}].asArrayRef().size(), 0);
+	}
+
+	// Check the limits are enforced as the document arrives
+	const auto limited = [](const std::string_view json, const auto &setup, const JSONParserErrorType error)
+	{
+		parseLimits_t limits{};
+		setup(limits);
+		pushParser_t parser{limits};
+		assertTrue(parser.feed(json) == pushStatus_t::error);
+		assertTrue(parser.error() == error);
+	};
+	limited("[1, 2, 3"sv, [](parseLimits_t &limits) { limits.maxMembers = 2U; }, JSON_PARSER_TOO_LARGE);
+	limited("[[1], [2"sv, [](parseLimits_t &limits) { limits.maxNodes = 4U; }, JSON_PARSER_TOO_LARGE);
+	limited("[\"abcdef"sv, [](parseLimits_t &limits) { limits.maxStringLength = 4U; }, JSON_PARSER_TOO_LARGE);
+	limited("{\"a\": 1, \"a\": 2}"sv,
+		[](parseLimits_t &limits) { limits.duplicateKeys = duplicateKeys_t::reject; }, JSON_PARSER_DUPLICATE_KEY);
+}
+
+// Records the events it's given as a compact trace
+struct eventTrace_t final : parseHandler_t
+{
+	std::string trace{};
+
+	void startObject() final { trace += '{'; }
+	void key(const std::string_view value) final { trace += "k:"s.append(value) + ' '; }
+	void endObject() final { trace += '}'; }
+	void startArray() final { trace += '['; }
+	void endArray() final { trace += ']'; }
+	void string(const std::string_view value) final { trace += "s:"s.append(value) + ' '; }
+	void integer(const int64_t value) final { trace += "i:" + std::to_string(value) + ' '; }
+	void floatingPoint(const double value) final { trace += "f:" + std::to_string(value) + ' '; }
+	void boolean(const bool value) final { trace += value ? "true " : "false "; }
+	void null() final { trace += "null "; }
+};
+
+void testEventHandler()
+{
+	eventTrace_t handler{};
+	parseJSON("{\"a\\n\": [1, -2.5, \"x\\u00e9\", {}, []], \"b\": {\"c\": null, \"d\": [true, false]}}"sv, handler);
+	assertStringEqual(handler.trace.c_str(),
+		"{k:a\n [i:1 f:-2.500000 s:x\xC3\xA9 {}[]]k:b {k:c null k:d [true false ]}}");
+
+	// Check the same events arrive from a stream, with values straddling the input blocks
+	std::string json{"[\""s + std::string(40000U, 'a') + "\", 12345678901234567890, 0x10]"};
+	memoryStream_t stream{json.data(), json.length() + 1U};
+	handler.trace.clear();
+	parseJSON(stream, handler);
+	assertStringEqual(handler.trace.c_str(),
+		("[s:"s + std::string(40000U, 'a') + " f:12345678901234567168.000000 i:16 ]").c_str());
+
+	// Check a handler that only looks at some events need not override the rest
+	struct sum_t final : parseHandler_t
+	{
+		int64_t total{0};
+		void integer(const int64_t value) final { total += value; }
+	} sum{};
+	parseJSON("[{\"a\": 1, \"b\": \"2\"}, [3, [4.0, 5]], null]"sv, sum);
+	assertIntEqual(sum.total, 9);
+
+	// Check malformed documents and nesting limits are still enforced
+	const auto failure = [](const std::string_view json, const JSONParserErrorType error)
+	{
+		parseHandler_t handler{};
+		try
+		{
+			parseJSON(json, handler, parseLimits_t{2U});
+			fail("The parser failed to reject a bad document");
+		}
+		catch (const JSONParserError &parserError)
+			{ assertTrue(parserError.errorType() == error); }
+	};
+	failure("1"sv, JSON_PARSER_BAD_JSON);
+	failure("[1,]"sv, JSON_PARSER_BAD_JSON);
+	failure("{\"a\" 1}"sv, JSON_PARSER_BAD_JSON);
+	failure("[[[]]]"sv, JSON_PARSER_TOO_DEEP);
+	failure("[1"sv, JSON_PARSER_EOF);
+}
+
+void testParseJSONInSitu()
+{
+	const std::string json{"{\"plain\": \"value\", \"escaped\": \"a\\nb\", \"list\": [\"item\"]}"};
+	const auto isBorrowed = [&](const std::string_view value) noexcept
+		{ return value.data() >= json.data() && value.data() < json.data() + json.size(); };
+
+	try
+	{
+		const auto atom{parseJSONInSitu(json)};
+		assertNotNull(atom.get());
+		const auto &object{atom->asObjectRef()};
+		assertIntEqual(object.size(), 3);
+		const JSONString &plain{object["plain"].asStringRef()};
+		assertTrue(plain.view() == "value");
+		assertTrue(isBorrowed(plain.view()));
+		const JSONString &escaped{object["escaped"].asStringRef()};
+		assertTrue(escaped.view() == "a\nb");
+		assertFalse(isBorrowed(escaped.view()));
+		const JSONString &item{object["list"].asArrayRef()[0].asStringRef()};
+		assertTrue(isBorrowed(item.view()));
+		// Asking for a std::string must copy the string out of the buffer, but only the once and
+		// without the string letting go of the buffer
+		assertStringEqual(item.get().c_str(), "item");
+		assertTrue(isBorrowed(item.view()));
+		assertTrue(&item.get() == &item.get());
+		assertTrue(static_cast<const char *>(item) == item.get().c_str());
+
+		// Reading the same strings from several threads at once must see the same copies
+		const JSONString &other{object["plain"].asStringRef()};
+		std::array<const std::string *, 4U> copies{};
+		std::vector<std::thread> readers{};
+		for (auto &copy : copies)
+			readers.emplace_back([&]() { copy = &other.get(); });
+		for (auto &reader : readers)
+			reader.join();
+		for (const auto *const copy : copies)
+			assertTrue(copy == copies[0]);
+		assertStringEqual(copies[0]->c_str(), "value");
+
+		std::unique_ptr<JSONAtom> tree{};
+		{
+			std::string buffer{"[\"first\", \"second\"]"};
+			tree = parseJSONInSitu(std::move(buffer));
+		}
+		assertNotNull(tree.get());
+		const auto &array{tree->asArrayRef()};
+		assertIntEqual(array.size(), 2);
+		assertTrue(array[0].asStringRef().view() == "first");
+		assertTrue(array[1].asStringRef().view() == "second");
+	}
+	catch (JSONParserError &err)
+		{ fail(err.error()); }
+	catch (JSONTypeError &err)
+		{ fail(err.error()); }
+
+	try
+	{
+		auto atom = parseJSONInSitu("[\"unterminated]"sv);
+		fail("The parser failed to throw an exception on invalid JSON");
+	}
+	catch (JSONParserError &err) { }
+}
+
+void testParseJSONLazy()
+{
+	// Build a document big enough to be indexed, whose first member is malformed deep inside
+	std::string json{"{\"skip\": [{\"a\": \"]}\\\"[\", \"b\": [1, 2, tru]}"};
+	for (size_t i{0}; i < 64U; ++i)
+		json += ", {\"n\": " + std::to_string(i) + ", \"s\": \"{[\\\\\\\"}\"}";
+	json += "], \"want\": {\"x\": 1, \"y\": [true, \"text\"]}, \"last\": null}";
+
+	const auto isBorrowed = [&](const std::string_view value) noexcept
+		{ return value.data() >= json.data() && value.data() < json.data() + json.size(); };
+	const auto badJSON = [](const auto &function, const JSONParserErrorType error)
+	{
+		try
+		{
+			function();
+			fail("The parser failed to throw an exception on invalid JSON");
+		}
+		catch (const JSONParserError &parserError)
+			{ assertTrue(parserError.errorType() == error); }
+	};
+
+	auto atom{parseJSONLazy(std::string_view{json})};
+	assertNotNull(atom.get());
+	auto &object{atom->asObjectRef()};
+	assertIntEqual(object.size(), 3);
+	assertTrue(object.exists("want"));
+	auto &want{object["want"].asObjectRef()};
+	assertIntEqual(want["x"].asInt(), 1);
+	auto &list{want["y"].asArrayRef()};
+	assertIntEqual(list.size(), 2);
+	assertTrue(list[0].asBool());
+	assertTrue(list[1].asStringRef().view() == "text");
+	assertTrue(isBorrowed(list[1].asStringRef().view()));
+	assertTrue(object["last"].isNull());
+
+	// The skipped array is intact until looked into, and its malformed member then fails every time it's used
+	auto &skip{object["skip"].asArrayRef()};
+	assertIntEqual(skip.size(), 65);
+	assertTrue(skip[1]["s"].asStringRef().view() == "{[\\\"}");
+	auto &broken{skip[0]["b"].asArrayRef()};
+	badJSON([&]() { broken.size(); }, JSON_PARSER_BAD_JSON);
+	badJSON([&]() { broken[0]; }, JSON_PARSER_BAD_JSON);
+	assertIntEqual(skip[64]["n"].asInt(), 63);
+
+	// Check a lazily parsed document can be changed and written back out like any other
+	std::string small{"{\"a\": [1, {\"b\": \"]}\"}], \"c\": {}}"};
+	atom = parseJSONLazy(std::move(small));
+	assertNotNull(atom.get());
+	auto &smallObject{atom->asObjectRef()};
+	assertTrue(smallObject.add("d", int64_t{2}));
+	assertIntEqual(smallObject.size(), 3);
+	std::string written(smallObject.length(), '\0');
+	memoryStream_t stream{written.data(), written.length()};
+	assertTrue(writeJSON(atom.get(), stream));
+	assertStringEqual(written.c_str(), "{\"a\": [1, {\"b\": \"]}\"}], \"c\": {}, \"d\": 2}");
+
+	// Check incomplete documents are caught up front, and the nesting limit as each level is parsed
+	badJSON([]() { parseJSONLazy("{\"a\": [1, 2"sv); }, JSON_PARSER_EOF);
+	badJSON([]() { parseJSONLazy("[\"]\""sv); }, JSON_PARSER_EOF);
+	// As are brackets closed by the wrong kind, whether the document is indexed or not
+	badJSON([]() { parseJSONLazy("{\"a\": [1, 2}"sv); }, JSON_PARSER_BAD_JSON);
+	badJSON([]() { parseJSONLazy("[1}"sv); }, JSON_PARSER_BAD_JSON);
+	badJSON([&]() { parseJSONLazy(json.substr(0U, json.length() - 1U) + "]"); }, JSON_PARSER_BAD_JSON);
+	badJSON([]() { parseJSONLazy("true"sv); }, JSON_PARSER_BAD_JSON);
+	atom = parseJSONLazy("[[[1]], 2]"sv, parseLimits_t{2U});
+	auto &outer{atom->asArrayRef()};
+	assertIntEqual(outer[1].asInt(), 2);
+	auto &inner{outer[0].asArrayRef()};
+	badJSON([&]() { inner.size(); }, JSON_PARSER_TOO_DEEP);
+}
+
+void testProjection()
+{
+	const auto json{"{\"user\": {\"id\": 42, \"name\": \"a\\\"b\", \"tags\": [\"x\", {\"y\": []}]}, "
+		"\"items\": [{\"price\": 1.5, \"sku\": \"p1\"}, {\"sku\": \"p2\"}, {\"price\": 3, \"extra\": {\"price\": 0}}], "
+		"\"a/b\": {\"~\": true}, \"list\": [10, 20, 30], \"empty\": {}}"sv};
+
+	auto atom{parseJSON(json, projection_t{"/user/id", "/items/*/price", "/a~1b/~0", "/list/1", "/missing/x", "/empty/y"})};
+	assertNotNull(atom.get());
+	auto &object{atom->asObjectRef()};
+	assertIntEqual(object.size(), 4);
+	auto &user{object["user"].asObjectRef()};
+	assertIntEqual(user.size(), 1);
+	assertIntEqual(user["id"].asInt(), 42);
+	// Elements without the selected member are left out altogether
+	auto &items{object["items"].asArrayRef()};
+	assertIntEqual(items.size(), 2);
+	assertTrue(items[0]["price"].asFloat() == 1.5);
+	assertFalse(items[0].asObjectRef().exists("sku"));
+	assertIntEqual(items[1]["price"].asInt(), 3);
+	assertFalse(items[1].asObjectRef().exists("extra"));
+	assertTrue(object["a/b"]["~"].asBool());
+	auto &list{object["list"].asArrayRef()};
+	assertIntEqual(list.size(), 1);
+	assertIntEqual(list[0].asInt(), 20);
+	assertFalse(object.exists("missing"));
+	assertFalse(object.exists("empty"));
+
+	// Check a selected value comes with everything in it, including from a stream
+	std::string streamJSON{"[{\"skip\": \""s + std::string(40000U, '\\') + "\", \"keep\": {\"a\": [1, {\"b\": null}]}}]"};
+	memoryStream_t stream{streamJSON.data(), streamJSON.length() + 1U};
+	atom = parseJSON(stream, projection_t{"/0/keep"});
+	auto &keep{atom->asArrayRef()[0]["keep"].asObjectRef()};
+	assertIntEqual(keep["a"].asArrayRef().size(), 2);
+	assertTrue(keep["a"][1]["b"].isNull());
+	atom = parseJSON("[1, [2]]"sv, projection_t{""});
+	assertIntEqual(atom->asArrayRef().size(), 2);
+
+	// Check empty components select members named "", and "~2" is a literal "*" rather than the wildcard
+	atom = parseJSON("{\"\": 1, \"a\": {\"\": 2, \"b\": 3}, \"*\": 4, \"c\": 5}"sv, projection_t{"/", "/a/", "/~2"});
+	auto &empty{atom->asObjectRef()};
+	assertIntEqual(empty.size(), 3);
+	assertIntEqual(empty[""].asInt(), 1);
+	assertIntEqual(empty["a"].asObjectRef().size(), 1);
+	assertIntEqual(empty["a"][""].asInt(), 2);
+	assertIntEqual(empty["*"].asInt(), 4);
+
+	// Check skipped parts still have to be complete, and the nesting limit applies to what's parsed
+	const auto failure = [](const std::string_view json, const JSONParserErrorType error)
+	{
+		try
+		{
+			parseJSON(json, projection_t{"/a/b"}, parseLimits_t{3U});
+			fail("The parser failed to throw an exception on invalid JSON");
+		}
+		catch (const JSONParserError &parserError)
+			{ assertTrue(parserError.errorType() == error); }
+	};
+	failure("{\"x\": [1, \"]\"}"sv, JSON_PARSER_BAD_JSON);
+	failure("{\"x\": [1, \"]\""sv, JSON_PARSER_EOF);
+	failure("{\"x\": [1}}"sv, JSON_PARSER_BAD_JSON);
+	failure("{\"x\": \"a\nb\"}"sv, JSON_PARSER_BAD_JSON);
+	failure("{\"x\": tru}"sv, JSON_PARSER_BAD_JSON);
+	failure("{\"a\": {\"b\": [[1]]}}"sv, JSON_PARSER_TOO_DEEP);
+	failure("\"a\""sv, JSON_PARSER_BAD_JSON);
+}
+
+void testValidation()
+{
+	const auto valid = [](const std::string_view json, const size_t length)
+	{
+		const auto result{validateJSON(json)};
+		assertTrue(bool(result));
+		assertTrue(result.valid);
+		assertIntEqual(result.offset, length);
+	};
+	const auto invalid = [](const std::string_view json, const JSONParserErrorType error, const size_t offset)
+	{
+		const auto result{validateJSON(json)};
+		assertFalse(bool(result));
+		assertTrue(result.error == error);
+		assertIntEqual(result.offset, offset);
+		// parseJSON() must agree that the document is bad and why
+		try
+		{
+			parseJSON(json);
+			fail("parseJSON() accepted a document validateJSON() rejected");
+		}
+		catch (const JSONParserError &parserError)
+			{ assertTrue(parserError.errorType() == error); }
+	};
+
+	valid("{}"sv, 2U);
+	valid("[0xFF, 0o17, 0b101, -0x10, 1.5e3, -0, \"a\\u00e9\\n\\\"\", true, false, null] "sv, 71U);
+	valid("{\"a\\\"\": {\"b\": [[], {}]}, \"c\": 0.25}\n"sv, 35U);
+	invalid(""sv, JSON_PARSER_EOF, 0U);
+	invalid("true"sv, JSON_PARSER_BAD_JSON, 0U);
+	invalid("[1,]"sv, JSON_PARSER_BAD_JSON, 3U);
+	invalid("{\"a\" 1}"sv, JSON_PARSER_BAD_JSON, 5U);
+	invalid("[\"a\\qb\"]"sv, JSON_PARSER_BAD_JSON, 4U);
+	invalid("[\"\\u12G4\"]"sv, JSON_PARSER_BAD_JSON, 6U);
+	invalid("[\"a\tb\"]"sv, JSON_PARSER_BAD_JSON, 3U);
+	invalid("[00]"sv, JSON_PARSER_BAD_JSON, 2U);
+	invalid("[1e05]"sv, JSON_PARSER_BAD_JSON, 4U);
+	invalid("[nul]"sv, JSON_PARSER_BAD_JSON, 4U);
+	invalid("{\"a\": [1, 2}"sv, JSON_PARSER_BAD_JSON, 11U);
+	invalid("[[1], [2"sv, JSON_PARSER_EOF, 8U);
+	const auto tooDeep{validateJSON("[[[]]]"sv, parseLimits_t{2U})};
+	assertFalse(tooDeep.valid);
+	assertTrue(tooDeep.error == JSON_PARSER_TOO_DEEP);
+	assertIntEqual(tooDeep.offset, 2);
+
+	// Check offsets carry on counting across the blocks a stream is read in
+	std::string json{"[\""s + std::string(70000U, 'a') + "\", 1, 2, x]"};
+	memoryStream_t stream{json.data(), json.length() + 1U};
+	const auto result{validateJSON(stream)};
+	assertFalse(result.valid);
+	assertTrue(result.error == JSON_PARSER_BAD_JSON);
+	assertIntEqual(result.offset, json.length() - 2U);
+	json = "[\""s + std::string(70000U, 'a') + "\", 1, 2]"s;
+	memoryStream_t validStream{json.data(), json.length() + 1U};
+	const auto validResult{validateJSON(validStream)};
+	assertTrue(validResult.valid);
+	assertIntEqual(validResult.offset, json.length());
+}
+
+void testValidationAllocations()
+{
+	const auto nested{std::string(60U, '[') + "1"s + std::string(60U, ']')};
+	const auto check = [](const std::string_view json, const bool valid)
+	{
+		const size_t before{allocations};
+		const auto result{validateJSON(json)};
+		assertIntEqual(allocations - before, 0U);
+		assertTrue(result.valid == valid);
+	};
+
+	check("{\"a\": [1, -2.5e10, 123456789012345678901234567890123456789, 0xFF], "
+		"\"b\\u00e9 and a key that's much too long for the short string optimisation\": "
+		"{\"c\": \"\\ud83d\\ude00\", \"d\": [true, false, null]}}"sv, true);
+	check(nested, true);
+	check("[1, {\"a\": tru}]"sv, false);
+	check("[\"a\\qb\"]"sv, false);
+
+	// Streams need an input window, but each thread only allocates that for the first stream it checks
+	std::string json{"[\""s + std::string(70000U, 'a') + "\", 1, 2]"s};
+	memoryStream_t firstStream{json.data(), json.length() + 1U};
+	assertTrue(validateJSON(firstStream).valid);
+	memoryStream_t stream{json.data(), json.length() + 1U};
+	const size_t before{allocations};
+	assertTrue(validateJSON(stream).valid);
+	assertIntEqual(allocations - before, 0U);
+}
+
+void testDocumentStream()
+{
+	const auto expectError = [](documentStream_t &documents, const JSONParserErrorType error)
+	{
+		try
+		{
+			documents.next();
+			fail("documentStream_t::next() accepted a malformed document");
+		}
+		catch (const JSONParserError &parserError)
+			{ assertTrue(parserError.errorType() == error); }
+	};
+
+	documentStream_t lines{"{\"a\": 1}\n\n  [2, 3] \r\n{\"b\": [4]}"sv};
+	assertIntEqual(lines.offset(), 0U);
+	auto document{lines.next()};
+	assertNotNull(document.get());
+	assertIntEqual(document->asObjectRef()["a"].asInt(), 1);
+	assertIntEqual(lines.offset(), 9U);
+	document = lines.next();
+	assertNotNull(document.get());
+	assertIntEqual(document->asArrayRef().size(), 2U);
+	assertIntEqual(document->asArrayRef()[1].asInt(), 3);
+	document = lines.next();
+	assertNotNull(document.get());
+	assertIntEqual(document->asObjectRef()["b"][size_t{0U}].asInt(), 4);
+	assertNull(lines.next().get());
+	assertNull(lines.next().get());
+
+	// A bad line is reported, and the line after it is read as normal
+	documentStream_t badLine{"[1]\n{\"a\": [1,}\n[2]\n{} []\n[3]\n"sv};
+	assertIntEqual(badLine.next()->asArrayRef()[0].asInt(), 1);
+	expectError(badLine, JSON_PARSER_BAD_JSON);
+	assertIntEqual(badLine.next()->asArrayRef()[0].asInt(), 2);
+	// Two documents on the one line is not JSON Lines
+	expectError(badLine, JSON_PARSER_BAD_JSON);
+	assertIntEqual(badLine.next()->asArrayRef()[0].asInt(), 3);
+	assertNull(badLine.next().get());
+
+	// A document cut short by the end of its line doesn't take the next line with it
+	documentStream_t truncated{"[1, 2\n[3]\n{\"a\": 4}\n"sv};
+	expectError(truncated, JSON_PARSER_EOF);
+	assertIntEqual(truncated.next()->asArrayRef()[0].asInt(), 3);
+	assertIntEqual(truncated.next()->asObjectRef()["a"].asInt(), 4);
+	assertNull(truncated.next().get());
+	// Nor can a document carry on over several lines
+	documentStream_t spanning{"{\"a\":\n1}\n[2]"sv};
+	expectError(spanning, JSON_PARSER_EOF);
+	expectError(spanning, JSON_PARSER_BAD_JSON);
+	assertIntEqual(spanning.next()->asArrayRef()[0].asInt(), 2);
+	assertNull(spanning.next().get());
+
+	documentStream_t concatenated{"{}[1]{\"a\":2}\n\t[]"sv, documentFormat_t::concatenated};
+	assertIntEqual(concatenated.next()->asObjectRef().size(), 0U);
+	assertIntEqual(concatenated.offset(), 2U);
+	assertIntEqual(concatenated.next()->asArrayRef()[0].asInt(), 1);
+	assertIntEqual(concatenated.next()->asObjectRef()["a"].asInt(), 2);
+	assertIntEqual(concatenated.next()->asArrayRef().size(), 0U);
+	assertNull(concatenated.next().get());
+
+	// There's no telling where a bad concatenated document ends, so the error sticks
+	documentStream_t badConcatenated{"[1][2,,][3]"sv, documentFormat_t::concatenated};
+	assertNotNull(badConcatenated.next().get());
+	expectError(badConcatenated, JSON_PARSER_BAD_JSON);
+	expectError(badConcatenated, JSON_PARSER_BAD_JSON);
+
+	documentStream_t empty{""sv};
+	assertNull(empty.next().get());
+	documentStream_t blank{" \n\n "sv, documentFormat_t::concatenated};
+	assertNull(blank.next().get());
+	std::string nothing{};
+	memoryStream_t emptyStream{nothing.data(), 1U};
+	documentStream_t emptyStreamed{emptyStream};
+	assertNull(emptyStreamed.next().get());
+
+	// Check documents read from a stream carry on across the blocks it's read in
+	const std::string longString(40000U, 'a');
+	std::string json{};
+	for (size_t i{0U}; i < 4U; ++i)
+		json += "[\""s + longString + "\", "s + std::to_string(i) + "]\n"s;
+	memoryStream_t stream{json.data(), json.length() + 1U};
+	documentStream_t streamed{stream};
+	for (size_t i{0U}; i < 4U; ++i)
+	{
+		document = streamed.next();
+		assertNotNull(document.get());
+		const JSONArray &array{*document};
+		assertStringEqual(array[0].asString().c_str(), longString.c_str());
+		assertIntEqual(array[1].asInt(), int64_t(i));
+		assertIntEqual(streamed.offset(), (json.length() / 4U) * (i + 1U));
+	}
+	assertNull(streamed.next().get());
+}
+
+void testArrayStream()
+{
+	const auto json{" [{\"id\": 1, \"tags\": [\"a\", \"b\"]}, 2.5, \"three\", [4, [5]], null, true, {} ] "sv};
+	const auto check = [](arrayStream_t &elements)
+	{
+		auto element{elements.next()};
+		assertNotNull(element.get());
+		assertIntEqual(element->asObjectRef()["id"].asInt(), 1);
+		assertIntEqual(element->asObjectRef()["tags"].asArrayRef().size(), 2U);
+		assertDoubleEqual(elements.next()->asFloat(), 2.5);
+		assertStringEqual(elements.next()->asString().c_str(), "three");
+		assertIntEqual(elements.next()->asArrayRef()[size_t{1U}][size_t{0U}].asInt(), 5);
+		assertTrue(elements.next()->isNull());
+		assertTrue(elements.next()->asBool());
+		assertIntEqual(elements.next()->asObjectRef().size(), 0U);
+		assertIntEqual(elements.count(), 7U);
+		assertNull(elements.next().get());
+		assertNull(elements.next().get());
+	};
+
+	arrayStream_t viewElements{json};
+	check(viewElements);
+	std::string copy{json};
+	memoryStream_t stream{copy.data(), copy.length() + 1U};
+	arrayStream_t streamElements{stream};
+	check(streamElements);
+
+	// Arrays much larger than the parser's window are read through a piece at a time
+	std::string records{"["};
+	for (size_t i{0U}; i < 20000U; ++i)
+		records += "{\"id\": "s + std::to_string(i) + ", \"name\": \"record\"},\n"s;
+	records.replace(records.length() - 2U, 1U, "]");
+	memoryStream_t recordStream{records.data(), records.length() + 1U};
+	arrayStream_t recordElements{recordStream};
+	size_t count{0U};
+	while (const auto record{recordElements.next()})
+		assertIntEqual(record->asObjectRef()["id"].asInt(), int64_t(count++));
+	assertIntEqual(count, 20000U);
+	assertIntEqual(recordElements.offset(), records.length() - 1U);
+
+	arrayStream_t emptyArray{"[ ]"sv};
+	assertNull(emptyArray.next().get());
+	assertIntEqual(emptyArray.count(), 0U);
+
+	const auto expectError = [](arrayStream_t &elements, const JSONParserErrorType error)
+	{
+		for (size_t attempt{0U}; attempt < 2U; ++attempt)
+		{
+			try
+			{
+				while (elements.next())
+					continue;
+				fail("Reading the array succeeded on bad input");
+			}
+			catch (const JSONParserError &parserError)
+				{ assertTrue(parserError.errorType() == error); }
+		}
+	};
+	arrayStream_t empty{""sv};
+	expectError(empty, JSON_PARSER_EOF);
+	arrayStream_t object{"{\"a\": 1}"sv};
+	expectError(object, JSON_PARSER_BAD_JSON);
+	arrayStream_t trailingComma{"[1, 2,]"sv};
+	expectError(trailingComma, JSON_PARSER_BAD_JSON);
+	arrayStream_t missingComma{"[1 2]"sv};
+	expectError(missingComma, JSON_PARSER_BAD_JSON);
+	arrayStream_t truncated{"[1, {\"a\": "sv};
+	expectError(truncated, JSON_PARSER_EOF);
+
+	parseLimits_t limits{2U};
+	arrayStream_t shallow{"[[1], [[2]]]"sv, limits};
+	assertIntEqual(shallow.next()->asArrayRef().size(), 1U);
+	expectError(shallow, JSON_PARSER_TOO_DEEP);
+	limits = {};
+	limits.maxMembers = 2U;
+	arrayStream_t members{"[1, 2, 3]"sv, limits};
+	expectError(members, JSON_PARSER_TOO_LARGE);
+	assertIntEqual(members.count(), 2U);
+}
+
+void testParseJSONLines()
+{
+	// Build up a log with records long enough that a small chunk size splits it many ways
+	std::string json{};
+	std::vector<size_t> offsets{};
+	for (size_t i{0U}; i < 1000U; ++i)
+	{
+		offsets.push_back(json.length());
+		json += "{\"id\": "s + std::to_string(i) + ", \"tags\": [\"a\", \"b\"]}\n"s;
+		if (i % 100U == 0U)
+			json += "\n"s;
+	}
+	parallelOptions_t options{};
+	options.threads = 4U;
+	options.chunkSize = 256U;
+
+	const auto documents{parseJSONLines(json, options)};
+	assertIntEqual(documents.size(), 1000U);
+	for (size_t i{0U}; i < documents.size(); ++i)
+		assertIntEqual(documents[i]->asObjectRef()["id"].asInt(), int64_t(i));
+	assertIntEqual(parseJSONLines(json).size(), 1000U);
+	assertIntEqual(parseJSONLines(""sv).size(), 0U);
+
+	// Check every record reaches the handler once, with the offset of its line
+	std::mutex lock{};
+	std::vector<size_t> seen(1000U, ~size_t{0U});
+	const auto record{[&](const size_t offset, std::unique_ptr<JSONAtom> document)
+	{
+		const auto id{size_t(document->asObjectRef()["id"].asInt())};
+		std::lock_guard<std::mutex> guard{lock};
+		assertTrue(seen[id] == ~size_t{0U});
+		seen[id] = offset;
+	}};
+	parseJSONLines(json, record, options);
+	assertTrue(seen == offsets);
+
+	std::fill(seen.begin(), seen.end(), ~size_t{0U});
+	memoryStream_t stream{json.data(), json.length() + 1U};
+	parseJSONLines(stream, record, options);
+	assertTrue(seen == offsets);
+
+	// The error reported must be for the first bad line, however the work was divided up
+	const auto expectError = [](const std::function<void ()> &parse, const JSONParserErrorType error)
+	{
+		try
+		{
+			parse();
+			fail("parseJSONLines() accepted a malformed line");
+		}
+		catch (const JSONParserError &parserError)
+			{ assertTrue(parserError.errorType() == error); }
+	};
+	std::string badJSON{json};
+	badJSON.insert(offsets[700], "[1,]\n"s);
+	badJSON.insert(offsets[300], "[[[1]]]\n"s);
+	options.limits.maxDepth = 2U;
+	expectError([&]() { parseJSONLines(badJSON, options); }, JSON_PARSER_TOO_DEEP);
+	expectError([&]() { parseJSONLines(badJSON, [](size_t, std::unique_ptr<JSONAtom>) { }, options); },
+		JSON_PARSER_TOO_DEEP);
+	memoryStream_t badStream{badJSON.data(), badJSON.length() + 1U};
+	expectError([&]() { parseJSONLines(badStream, [](size_t, std::unique_ptr<JSONAtom>) { }, options); },
+		JSON_PARSER_TOO_DEEP);
+	expectError([&]() { parseJSONLines("[1]\n[2] [3]\n"sv); }, JSON_PARSER_BAD_JSON);
+	// Each document has to end on the line it starts on
+	expectError([&]() { parseJSONLines("[1, 2\n[3]\n"sv); }, JSON_PARSER_EOF);
+	expectError([&]() { parseJSONLines("{\"a\":\n1}\n"sv); }, JSON_PARSER_EOF);
+
+	// Errors from the handler are passed back too
+	try
+	{
+		parseJSONLines(json, [](size_t, std::unique_ptr<JSONAtom>) { throw std::runtime_error{"handler"}; });
+		fail("parseJSONLines() swallowed an exception from the handler");
+	}
+	catch (const std::runtime_error &) { }
+}
+
+void testParseJSONParallel()
+{
+	parallelOptions_t options{};
+	options.threads = 4U;
+	options.chunkSize = 128U;
+
+	// Parse from a temporary to check nothing is left borrowing from the input
+	std::unique_ptr<JSONAtom> atom{};
+	{
+		std::string json{"[ "};
+		for (size_t i{0U}; i < 500U; ++i)
+			json += "{\"id\": "s + std::to_string(i) + ", \"name\": \"item\\u0041"s + std::to_string(i) +
+				"\", \"tags\": [[true], {}]}, "s;
+		json += "-1.5, \"end\" ]"s;
+		atom = parseJSON(json, options);
+		std::fill(json.begin(), json.end(), ' ');
+	}
+	assertNotNull(atom.get());
+	const JSONArray &array{*atom};
+	assertIntEqual(array.size(), 502U);
+	for (size_t i{0U}; i < 500U; ++i)
+	{
+		const JSONObject &object{array[i]};
+		assertIntEqual(object["id"].asInt(), int64_t(i));
+		assertStringEqual(object["name"].asString().c_str(), ("itemA"s + std::to_string(i)).c_str());
+		assertTrue(object["tags"][size_t{0U}][size_t{0U}].asBool());
+	}
+	assertTrue(array[500].asFloat() == -1.5);
+	assertStringEqual(array[501].asString().c_str(), "end");
+
+	std::string json{"{"};
+	for (size_t i{0U}; i < 300U; ++i)
+		json += "\"key"s + std::to_string(i) + "\" : [\""s + std::string(i % 50U, 'x') + "\", null],"s;
+	json += "\"last\": {}}"s;
+	atom = parseJSON(json, options);
+	const JSONObject &object{*atom};
+	assertIntEqual(object.size(), 301U);
+	for (size_t i{0U}; i < 300U; ++i)
+	{
+		const auto &member{object["key"s + std::to_string(i)]};
+		assertStringEqual(member[size_t{0U}].asString().c_str(), std::string(i % 50U, 'x').c_str());
+		assertTrue(member[1].typeIs(JSON_TYPE_NULL));
+	}
+	assertIntEqual(object["last"].asObjectRef().size(), 0U);
+	assertIntEqual(parseJSON("[]"sv, options)->asArrayRef().size(), 0U);
+	options.chunkSize = 4U;
+	assertIntEqual(parseJSON("[ ]"sv, options)->asArrayRef().size(), 0U);
+	assertIntEqual(parseJSON("[            ]"sv, options)->asArrayRef().size(), 0U);
+	assertIntEqual(parseJSON("{            }"sv, options)->asObjectRef().size(), 0U);
+	assertIntEqual(parseJSON("{\"a\": 1, \"b\": [2]}"sv, options)->asObjectRef()["b"][size_t{0U}].asInt(), 2);
+
+	// Errors must be the same as parsing without threads would report
+	const auto expectError = [&](const std::string_view badJSON, const JSONParserErrorType error)
+	{
+		try
+		{
+			parseJSON(badJSON, options);
+			fail("parseJSON() accepted a malformed document");
+		}
+		catch (const JSONParserError &parserError)
+			{ assertTrue(parserError.errorType() == error); }
+	};
+	options.limits.maxDepth = 3U;
+	assertTrue(parseJSON("[[1], [[2]], 3]"sv, options)->asArrayRef()[1][size_t{0U}][size_t{0U}].asInt() == 2);
+	expectError("[[1], [[[2]]], 3]"sv, JSON_PARSER_TOO_DEEP);
+	expectError("[[1], [[[2]]], 3, [1,]]"sv, JSON_PARSER_TOO_DEEP);
+	expectError("[[1], [1,], [[[2]]]]"sv, JSON_PARSER_BAD_JSON);
+	expectError("{\"a\": 1, \"b\" 2}"sv, JSON_PARSER_BAD_JSON);
+	expectError("[1, 2, tru]"sv, JSON_PARSER_BAD_JSON);
+	expectError("[1, [2, 3]"sv, JSON_PARSER_EOF);
+}
+
+void testTryParseJSON()
+{
+	const auto failure = [](const parseResult_t &result, const JSONParserErrorType error, const size_t offset,
+		const size_t line, const size_t column)
+	{
+		assertFalse(bool(result));
+		assertNull(result.document.get());
+		assertTrue(result.error == error);
+		assertIntEqual(result.offset, offset);
+		assertIntEqual(result.line, line);
+		assertIntEqual(result.column, column);
+	};
+
+	auto result{tryParseJSON("{\"a\": [1, 2]}"sv)};
+	assertTrue(bool(result));
+	assertNotNull(result.document.get());
+	assertIntEqual(result.document->asObjectRef()["a"][1].asInt(), 2);
+	assertIntEqual(result.offset, 13U);
+	failure(tryParseJSON(""sv), JSON_PARSER_EOF, 0U, 1U, 1U);
+	failure(tryParseJSON("[1,]"sv), JSON_PARSER_BAD_JSON, 3U, 1U, 4U);
+	failure(tryParseJSON("{\n\t\"a\": [\n\t\t1,\n\t\ttru\n\t]\n}"sv), JSON_PARSER_BAD_JSON, 20U, 4U, 6U);
+	failure(tryParseJSON("[[[1]]]"sv, parseLimits_t{2U}), JSON_PARSER_TOO_DEEP, 2U, 1U, 3U);
+	failure(tryParseJSON("[1,\n2"sv), JSON_PARSER_EOF, 5U, 2U, 2U);
+	failure(tryParseJSON("[\"a\\q\"]"sv), JSON_PARSER_BAD_JSON, 5U, 1U, 6U);
+	failure(tryParseJSON("{\"a\" 1}"sv), JSON_PARSER_BAD_JSON, 5U, 1U, 6U);
+	parseLimits_t limits{};
+	limits.duplicateKeys = duplicateKeys_t::reject;
+	failure(tryParseJSON("{\"a\": 1, \"a\": 2}"sv, limits), JSON_PARSER_DUPLICATE_KEY, 15U, 1U, 16U);
+	limits.maxNodes = 3U;
+	failure(tryParseJSON("[1, 2, 3]"sv, limits), JSON_PARSER_TOO_LARGE, 7U, 1U, 8U);
+	// Problems with the document are kept by the parser rather than thrown
+	static_assert(noexcept(tryParseJSON(""sv)));
+	static_assert(noexcept(tryParseJSON(""sv, limits)));
+
+	std::string empty{};
+	memoryStream_t emptyStream{empty.data(), 1U};
+	failure(tryParseJSON(emptyStream), JSON_PARSER_EOF, 0U, 1U, 1U);
+
+	// Check lines are still counted properly when the stream is read in multiple blocks
+	std::string json{"["};
+	for (size_t i{0U}; i < 10000U; ++i)
+		json += "\"line\",\n"s;
+	json += "  01]"s;
+	memoryStream_t stream{json.data(), json.length() + 1U};
+	failure(tryParseJSON(stream), JSON_PARSER_BAD_JSON, json.length() - 2U, 10001U, 4U);
+	failure(tryParseJSON(json), JSON_PARSER_BAD_JSON, json.length() - 2U, 10001U, 4U);
+	json.replace(json.length() - 3U, 1U, "1");
+	memoryStream_t validStream{json.data(), json.length() + 1U};
+	result = tryParseJSON(validStream);
+	assertTrue(bool(result));
+	assertIntEqual(result.document->asArrayRef().size(), 10001U);
+}
+
+void testParseLimits()
+{
+	const auto withLimits = [](const auto &setup)
+	{
+		parseLimits_t limits{};
+		setup(limits);
+		return limits;
+	};
+	const auto expectError = [](const std::function<void ()> &parse, const JSONParserErrorType error)
+	{
+		try
+		{
+			parse();
+			fail("Parsing succeeded despite going over a limit");
+		}
+		catch (const JSONParserError &parserError)
+			{ assertTrue(parserError.errorType() == error); }
+	};
+
+	const auto bytes = [&](const size_t maxBytes)
+		{ return withLimits([=](parseLimits_t &limits) { limits.maxBytes = maxBytes; }); };
+	assertIntEqual(parseJSON("[1, 2]"sv, bytes(6U))->asArrayRef().size(), 2U);
+	expectError([&]() { parseJSON("[1, 2]"sv, bytes(5U)); }, JSON_PARSER_TOO_LARGE);
+	std::string json{"[\""s + std::string(70000U, 'a') + "\"]"s};
+	memoryStream_t stream{json.data(), json.length() + 1U};
+	expectError([&]() { parseJSON(stream, bytes(40000U)); }, JSON_PARSER_TOO_LARGE);
+	memoryStream_t validStream{json.data(), json.length() + 1U};
+	assertNotNull(parseJSON(validStream, bytes(json.length())).get());
+	pushParser_t pushParser{bytes(8U)};
+	assertTrue(pushParser.feed("[1, "sv) == pushStatus_t::needMore);
+	assertTrue(pushParser.feed("2, 3]"sv) == pushStatus_t::error);
+	assertTrue(pushParser.error() == JSON_PARSER_TOO_LARGE);
+
+	const auto strings = [&](const size_t maxStringLength)
+		{ return withLimits([=](parseLimits_t &limits) { limits.maxStringLength = maxStringLength; }); };
+	assertNotNull(parseJSON("{\"abcd\": \"a\\nb\"}"sv, strings(4U)).get());
+	expectError([&]() { parseJSON("{\"abcde\": \"a\"}"sv, strings(4U)); }, JSON_PARSER_TOO_LARGE);
+	expectError([&]() { parseJSON("[\"a\\n\\tb\"]"sv, strings(4U)); }, JSON_PARSER_TOO_LARGE);
+	memoryStream_t stringStream{json.data(), json.length() + 1U};
+	expectError([&]() { parseJSON(stringStream, strings(1000U)); }, JSON_PARSER_TOO_LARGE);
+	assertTrue(validateJSON(json, strings(1000U)).error == JSON_PARSER_TOO_LARGE);
+
+	const auto members = [&](const size_t maxMembers)
+		{ return withLimits([=](parseLimits_t &limits) { limits.maxMembers = maxMembers; }); };
+	assertNotNull(parseJSON("[1, [2, 3], {\"a\": 4, \"b\": 5}]"sv, members(3U)).get());
+	expectError([&]() { parseJSON("[1, 2, 3, 4]"sv, members(3U)); }, JSON_PARSER_TOO_LARGE);
+	expectError([&]() { parseJSON("[[], {\"a\": 1, \"b\": 2}]"sv, members(1U)); }, JSON_PARSER_TOO_LARGE);
+	assertNotNull(parseJSON("[]"sv, members(0U)).get());
+	expectError([&]() { parseJSON("[[]]"sv, members(0U)); }, JSON_PARSER_TOO_LARGE);
+	const auto lazy{parseJSONLazy("[[1, 2, 3], [4]]"sv, members(2U))};
+	assertIntEqual(lazy->asArrayRef()[1].asArrayRef().size(), 1U);
+	expectError([&]() { lazy->asArrayRef()[size_t{0U}].asArrayRef().size(); }, JSON_PARSER_TOO_LARGE);
+	expectError([&]() { parseJSON("{\"a\": 1, \"b\": 2, \"c\": 3}"sv, projection_t{"/c"}, members(2U)); },
+		JSON_PARSER_TOO_LARGE);
+
+	const auto nodes = [&](const size_t maxNodes)
+		{ return withLimits([=](parseLimits_t &limits) { limits.maxNodes = maxNodes; }); };
+	assertNotNull(parseJSON("[1, [2, 3]]"sv, nodes(5U)).get());
+	expectError([&]() { parseJSON("[1, [2, 3]]"sv, nodes(4U)); }, JSON_PARSER_TOO_LARGE);
+	const auto lazyNodes{parseJSONLazy("[[1, 2], [3, 4]]"sv, nodes(5U))};
+	assertIntEqual(lazyNodes->asArrayRef()[size_t{0U}].asArrayRef().size(), 2U);
+	expectError([&]() { lazyNodes->asArrayRef()[1].asArrayRef().size(); }, JSON_PARSER_TOO_LARGE);
+}
+
+void testDuplicateKeys()
+{
+	const auto keys = [](const duplicateKeys_t duplicateKeys)
+	{
+		parseLimits_t limits{};
+		limits.duplicateKeys = duplicateKeys;
+		return limits;
+	};
+	const auto check = [](const JSONObject &object, const int64_t a)
+	{
+		assertIntEqual(object.size(), 2U);
+		assertIntEqual(object["a"].asInt(), a);
+		assertStringEqual(object.keys()[0], "a");
+		assertStringEqual(object.keys()[1], "b");
+	};
+	const auto json{"{\"a\": 1, \"b\": {\"c\": [], \"c\": null}, \"a\": 3}"sv};
+
+	check(*parseJSON(json), 1);
+	check(*parseJSON(json, keys(duplicateKeys_t::keepFirst)), 1);
+	const auto last{parseJSON(json, keys(duplicateKeys_t::keepLast))};
+	check(*last, 3);
+	assertTrue(last->asObjectRef()["b"]["c"].typeIs(JSON_TYPE_NULL));
+	check(*parseJSONLazy(json, keys(duplicateKeys_t::keepLast)), 3);
+	check(*parseJSON(json, projection_t{"/a", "/b"}, keys(duplicateKeys_t::keepLast)), 3);
+
+	const auto expectDuplicate = [](const std::function<void ()> &parse)
+	{
+		try
+		{
+			parse();
+			fail("Parsing accepted a duplicate key");
+		}
+		catch (const JSONParserError &parserError)
+			{ assertTrue(parserError.errorType() == JSON_PARSER_DUPLICATE_KEY); }
+	};
+	const auto reject{keys(duplicateKeys_t::reject)};
+	expectDuplicate([&]() { parseJSON(json, reject); });
+	expectDuplicate([&]() { parseJSON("{\"a\": {\"b\": 1, \"b\": 1}}"sv, projection_t{"/a"}, reject); });
+	expectDuplicate([&]() { parseJSONLazy(json, reject)->asObjectRef().size(); });
+	assertTrue(tryParseJSON(json, reject).error == JSON_PARSER_DUPLICATE_KEY);
+	assertNotNull(parseJSON("{\"a\": {\"a\": 1}, \"b\": [{\"a\": 2}]}"sv, reject).get());
+
+	parallelOptions_t options{};
+	options.threads = 2U;
+	options.chunkSize = 8U;
+	options.limits = reject;
+	expectDuplicate([&]() { parseJSON(json, options); });
+	options.limits = keys(duplicateKeys_t::keepLast);
+	check(*parseJSON(json, options), 3);
+}
+
+enum class colour_t : uint8_t { red, green, blue };
+
+struct point_t final
+{
+	int32_t x{0};
+	int32_t y{0};
+};
+
+struct shape_t final
+{
+	std::string name{};
+	colour_t colour{colour_t::red};
+	bool filled{false};
+	double scale{1.0};
+	std::vector<point_t> points{};
+	std::optional<std::string> label{};
+	std::optional<uint16_t> layer{5U};
+};
+
+template<> struct rSON::jsonFields_t<point_t>
+	{ constexpr static auto fields{std::make_tuple(rSON_FIELD(point_t, x), rSON_FIELD(point_t, y))}; };
+template<> struct rSON::jsonFields_t<shape_t>
+{
+	constexpr static auto fields{std::make_tuple(rSON_FIELD(shape_t, name), rSON_FIELD(shape_t, colour),
+		rSON_FIELD(shape_t, filled), rSON_FIELD(shape_t, scale), rSON_FIELD(shape_t, points),
+		rSON_FIELD(shape_t, label), rSON_FIELD(shape_t, layer))};
+};
+
+void testBinding()
+{
+	const auto json{"{\"name\": \"tri\\u0061ngle\", \"colour\": 2, \"filled\": true, \"scale\": 2, "
+		"\"extra\": {\"a\": [1, {\"b\": null}]}, \"points\": [{\"x\": 1, \"y\": -2}, {\"y\": 4, \"x\": 3}, {}], "
+		"\"la\\u0062el\": \"top\", \"layer\": null}\n"sv};
+	const auto check = [](const shape_t &shape)
+	{
+		assertStringEqual(shape.name.c_str(), "triangle");
+		assertTrue(shape.colour == colour_t::blue);
+		assertTrue(shape.filled);
+		assertDoubleEqual(shape.scale, 2.0);
+		assertIntEqual(shape.points.size(), 3U);
+		assertIntEqual(shape.points[0].x, 1);
+		assertIntEqual(shape.points[0].y, -2);
+		assertIntEqual(shape.points[1].x, 3);
+		assertIntEqual(shape.points[1].y, 4);
+		assertIntEqual(shape.points[2].x, 0);
+		assertTrue(shape.label.has_value());
+		assertStringEqual(shape.label->c_str(), "top");
+		assertFalse(shape.layer.has_value());
+	};
+	check(bindJSON<shape_t>(json));
+	std::string copy{json};
+	memoryStream_t stream{copy.data(), copy.length() + 1U};
+	shape_t shape{};
+	bindJSON(stream, shape);
+	check(shape);
+
+	// Fields missing from the document are left alone
+	shape_t defaults{};
+	bindJSON("{\"name\": \"square\"}"sv, defaults);
+	assertStringEqual(defaults.name.c_str(), "square");
+	assertTrue(defaults.layer.has_value());
+	assertIntEqual(*defaults.layer, 5U);
+	const auto points{bindJSON<std::vector<point_t>>("[{\"x\": 7}, {\"y\": 8}]"sv)};
+	assertIntEqual(points.size(), 2U);
+	assertIntEqual(points[0].x, 7);
+	assertIntEqual(points[1].y, 8);
+
+	const auto expectError = [](const std::function<void ()> &bind, const JSONParserErrorType error)
+	{
+		try
+		{
+			bind();
+			fail("Binding succeeded on a bad document");
+		}
+		catch (const JSONParserError &parserError)
+			{ assertTrue(parserError.errorType() == error); }
+	};
+	const auto expectTypeError = [](const std::function<void ()> &bind)
+	{
+		try
+		{
+			bind();
+			fail("Binding succeeded despite a type mismatch");
+		}
+		catch (const JSONTypeError &) { }
+	};
+	expectTypeError([]() { bindJSON<shape_t>("{\"name\": 1}"sv); });
+	expectTypeError([]() { bindJSON<shape_t>("{\"filled\": \"yes\"}"sv); });
+	expectTypeError([]() { bindJSON<shape_t>("{\"points\": {}}"sv); });
+	expectTypeError([]() { bindJSON<point_t>("{\"x\": 1.5}"sv); });
+	expectTypeError([]() { bindJSON<point_t>("[]"sv); });
+	expectError([]() { bindJSON<point_t>("1"sv); }, JSON_PARSER_BAD_JSON);
+	expectError([]() { bindJSON<point_t>("{\"x\": 1,}"sv); }, JSON_PARSER_BAD_JSON);
+	expectError([]() { bindJSON<point_t>("{\"z\" 1}"sv); }, JSON_PARSER_BAD_JSON);
+	expectError([]() { bindJSON<point_t>("{\"x\": 1"sv); }, JSON_PARSER_EOF);
+	// Members that are skipped still have to be valid
+	expectError([]() { bindJSON<point_t>("{\"junk\": [tru, @@@], \"x\": 1}"sv); }, JSON_PARSER_BAD_JSON);
+	expectError([]() { bindJSON<point_t>("{\"junk\": [1, }, \"x\": 1}"sv); }, JSON_PARSER_BAD_JSON);
+	expectError([]() { bindJSON<point_t>("{\"junk\": [1}, \"x\": 1}"sv); }, JSON_PARSER_BAD_JSON);
+	expectError([]() { bindJSON<point_t>("{\"junk\": \"a\nb\", \"x\": 1}"sv); }, JSON_PARSER_BAD_JSON);
+
+	// Numbers have to fit the integers and enums they're bound to
+	assertIntEqual(bindJSON<point_t>("{\"x\": -2147483648}"sv).x, INT32_MIN);
+	assertIntEqual(*bindJSON<shape_t>("{\"layer\": 65535}"sv).layer, 65535U);
+	expectError([]() { bindJSON<point_t>("{\"x\": 2147483648}"sv); }, JSON_PARSER_TOO_LARGE);
+	expectError([]() { bindJSON<shape_t>("{\"layer\": 65536}"sv); }, JSON_PARSER_TOO_LARGE);
+	expectError([]() { bindJSON<shape_t>("{\"layer\": -1}"sv); }, JSON_PARSER_TOO_LARGE);
+	expectError([]() { bindJSON<shape_t>("{\"colour\": 300}"sv); }, JSON_PARSER_TOO_LARGE);
+	expectError([]() { bindJSON<shape_t>("{\"colour\": -1}"sv); }, JSON_PARSER_TOO_LARGE);
+	expectError([]() { bindJSON<std::vector<uint8_t>>("[255, 256]"sv); }, JSON_PARSER_TOO_LARGE);
+	// The whole range of 64-bit integers can be bound, signed and unsigned
+	const auto wide{bindJSON<std::vector<uint64_t>>("[18446744073709551615, 9223372036854775808, 0xFFFFFFFFFFFFFFFF, 7]"sv)};
+	assertIntEqual(wide.size(), 4U);
+	assertTrue(wide[0] == UINT64_MAX);
+	assertTrue(wide[1] == uint64_t{INT64_MAX} + 1U);
+	assertTrue(wide[2] == UINT64_MAX);
+	assertTrue(wide[3] == 7U);
+	const auto signedWide{bindJSON<std::vector<int64_t>>("[-9223372036854775808, 9223372036854775807]"sv)};
+	assertTrue(signedWide[0] == INT64_MIN);
+	assertTrue(signedWide[1] == INT64_MAX);
+	expectError([]() { bindJSON<std::vector<uint64_t>>("[18446744073709551616]"sv); }, JSON_PARSER_TOO_LARGE);
+	expectError([]() { bindJSON<std::vector<uint64_t>>("[-1]"sv); }, JSON_PARSER_TOO_LARGE);
+	expectError([]() { bindJSON<std::vector<int64_t>>("[9223372036854775808]"sv); }, JSON_PARSER_TOO_LARGE);
+	expectTypeError([]() { bindJSON<std::vector<uint64_t>>("[1.5]"sv); });
+
+	parseLimits_t limits{1U};
+	expectError([&]() { std::vector<point_t> value{}; bindJSON("[{}]"sv, value, limits); }, JSON_PARSER_TOO_DEEP);
+	limits.maxDepth = 2U;
+	bindJSON("{\"junk\": [1], \"x\": 1}"sv, shape.points[0], limits);
+	expectError([&]() { bindJSON("{\"junk\": [[1]], \"x\": 1}"sv, shape.points[0], limits); },
+		JSON_PARSER_TOO_DEEP);
+	limits = {};
+	limits.maxMembers = 2U;
+	expectError([&]() { std::vector<point_t> value{}; bindJSON("[{}, {}, {}]"sv, value, limits); },
+		JSON_PARSER_TOO_LARGE);
+
+	// The node limit counts every value, including those in skipped members
+	limits = {};
+	limits.maxNodes = 2U;
+	expectError([&]() { std::vector<int32_t> value{}; bindJSON("[1, 2, 3, 4, 5, 6]"sv, value, limits); },
+		JSON_PARSER_TOO_LARGE);
+	limits.maxNodes = 6U;
+	bindJSON("{\"junk\": [1, 2, 3], \"x\": 1}"sv, shape.points[0], limits);
+	assertIntEqual(shape.points[0].x, 1);
+	limits.maxNodes = 5U;
+	expectError([&]() { bindJSON("{\"junk\": [1, 2, 3], \"x\": 1}"sv, shape.points[0], limits); },
+		JSON_PARSER_TOO_LARGE);
+
+	// Fields given more than once are dealt with as for parseJSON()
+	const auto duplicates{"{\"name\": \"a\", \"points\": [{\"x\": 1}], "
+		"\"name\": \"b\", \"points\": [{\"y\": 2}]}"sv};
+	limits = {};
+	shape_t first{};
+	bindJSON(duplicates, first, limits);
+	assertStringEqual(first.name.c_str(), parseJSON(duplicates, limits)->asObjectRef()["name"].asString().c_str());
+	assertStringEqual(first.name.c_str(), "a");
+	assertIntEqual(first.points.size(), 1U);
+	assertIntEqual(first.points[0].x, 1);
+	limits.duplicateKeys = duplicateKeys_t::keepLast;
+	shape_t last{};
+	bindJSON(duplicates, last, limits);
+	assertStringEqual(last.name.c_str(), "b");
+	assertIntEqual(last.points.size(), 1U);
+	assertIntEqual(last.points[0].x, 0);
+	assertIntEqual(last.points[0].y, 2);
+	limits.duplicateKeys = duplicateKeys_t::reject;
+	expectError([&]() { bindJSON(duplicates, shape, limits); }, JSON_PARSER_DUPLICATE_KEY);
+	// As are keys that match none of the fields, including those inside skipped members
+	expectError([&]() { bindJSON("{\"junk\": 1, \"x\": 1, \"junk\": 2}"sv, shape.points[0], limits); },
+		JSON_PARSER_DUPLICATE_KEY);
+	expectError([&]() { bindJSON("{\"junk\": {\"a\": 1, \"a\": 2}}"sv, shape.points[0], limits); },
+		JSON_PARSER_DUPLICATE_KEY);
+	bindJSON("{\"junk\": {\"a\": 1, \"b\": {\"a\": 2}}, \"other\": {\"junk\": 1}, \"x\": 3}"sv,
+		shape.points[0], limits);
+	assertIntEqual(shape.points[0].x, 3);
+	// Each object keeps track of its own fields
+	std::vector<point_t> separate{};
+	bindJSON("[{\"x\": 1}, {\"x\": 2}]"sv, separate, limits);
+	assertIntEqual(separate[1].x, 2);
+}
+
+void testParseJSONView()
+{
+	// Whole-buffer parsing must not need a terminator after the document
+	TRY("[1, 2]"sv,
+		const JSONArray &array{*atom};
+		assertIntEqual(array.size(), 2);
+		assertIntEqual(array[1].asInt(), 2);
+	);
+	TRY("{\"key\": \"value\"}"s,
+		const JSONObject &object{*atom};
+		assertIntEqual(object.size(), 1);
+		assertStringEqual(object["key"].asString().c_str(), "value");
+	);
+	TRY_SHOULD_FAIL(""sv);
+	TRY_SHOULD_FAIL("[1, 2"sv);
+
+	// Documents this size get a structural index built and used to skip whitespace and strings
+	std::string json{"[\n"};
+	for (size_t i{0}; i < 64U; ++i)
+		json += "\t{\"key\": \"value\",   \"escaped\\\"\\\\\": \"a\\\"b\\\\\" ,\r\n\t\t\"list\": [ true , -1 ]},\n";
+	json += "\t\"" + std::string(100U, ' ') + "\"\n]";
+	TRY(json,
+		const JSONArray &array{*atom};
+		assertIntEqual(array.size(), 65);
+		const JSONObject &object{array[63]};
+		assertIntEqual(object.size(), 3);
+		assertStringEqual(object["key"].asString().c_str(), "value");
+		assertStringEqual(object["escaped\\\"\\\\"].asString().c_str(), "a\"b\\");
+		assertIntEqual(object["list"][1].asInt(), -1);
+		assertIntEqual(array[64].asString().size(), 100);
+	);
+	TRY_SHOULD_FAIL(json.substr(0, json.size() - 1U));
+	TRY_SHOULD_FAIL(json.substr(0, json.size() - 3U));
+	TRY_SHOULD_FAIL("[\"" + std::string(300U, ' ') + "]");
+	json[json.size() - 4U] = '\x01';
+	TRY_SHOULD_FAIL(json);
+}
+
+void testStringPool()
+{
+	const auto json{"[{\"status\": \"waiting for a reply\", \"id\": \"ok\"}, {\"status\": \"waiting for a reply\", "
+		"\"id\": \"ok\"}, {\"status\": \"waiting for a rep\\u006cy\", \"id\": \"a string too long to be worth interning\"}]"sv};
+	const auto check = [](const JSONArray &records, const stringPool_t &strings)
+	{
+		assertIntEqual(records.size(), 3U);
+		const auto &first{records[0]["status"].asStringRef()};
+		const auto &second{records[1]["status"].asStringRef()};
+		const auto &third{records[2]["status"].asStringRef()};
+		assertTrue(first.view() == "waiting for a reply"sv);
+		assertTrue(second.view().data() == first.view().data());
+		// Strings that had to be unescaped are interned too
+		assertTrue(third.view().data() == first.view().data());
+		// Interned strings are handed out as std::strings without being copied
+		assertTrue(first.get().data() == first.view().data());
+		assertTrue(records[0]["id"].asStringRef().view() == "ok"sv);
+		assertTrue(records[0]["id"].asStringRef().view().data() != records[1]["id"].asStringRef().view().data());
+		assertIntEqual(strings.size(), 1U);
+	};
+
+	stringPool_t strings{32U};
+	auto document{parseJSON(json, strings)};
+	check(document->asArrayRef(), strings);
+	std::string copy{json};
+	memoryStream_t stream{copy.data(), copy.length() + 1U};
+	stringPool_t streamStrings{32U};
+	check(parseJSON(stream, streamStrings)->asArrayRef(), streamStrings);
+
+	// Sharing the pool between documents shares the strings between them too
+	const auto other{parseJSON("[\"waiting for a reply\"]"sv, strings)};
+	assertTrue(other->asArrayRef()[0].asStringRef().view().data() ==
+		document->asArrayRef()[0]["status"].asStringRef().view().data());
+	assertIntEqual(strings.size(), 1U);
+	strings.clear();
+	assertIntEqual(strings.size(), 0U);
+	// The strings interned stay valid after the pool forgets them and after it goes away
+	{
+		stringPool_t pool{};
+		document = parseJSON(json, pool);
+	}
+	assertStringEqual(document->asArrayRef()[2]["status"].asString().c_str(), "waiting for a reply");
+	assertIntEqual(document->asArrayRef()[2]["status"].asStringRef().len(), 19U);
+
+	try
+	{
+		parseJSON("[\"waiting for a reply\" 1]"sv, strings);
+		fail("Parsing succeeded on a bad document");
+	}
+	catch (const JSONParserError &error)
+		{ assertTrue(error.errorType() == JSON_PARSER_BAD_JSON); }
+}
+
+void testParseJSONArena()
+{
+	const auto json{"{\"name\": \"a string long enough to need storage of its own\", \"empty\": \"\", "
+		"\"escaped\": \"tab\\there\", \"values\": [1, 2.5, true, null, [\"x\", {}]], "
+		"\"nested\": {\"deeper\": {\"key\": \"value\"}}}"sv};
+	const auto check = [](const JSONAtom &document)
+	{
+		const auto &object{document.asObjectRef()};
+		assertIntEqual(object.size(), 5U);
+		assertStringEqual(object["name"].asString().c_str(), "a string long enough to need storage of its own");
+		// Strings are handed out as C strings straight from the arena
+		const auto &name{object["name"].asStringRef()};
+		assertTrue(static_cast<const char *>(name) == name.view().data());
+		assertIntEqual(object["empty"].asStringRef().len(), 0U);
+		assertStringEqual(static_cast<const char *>(object["empty"].asStringRef()), "");
+		assertStringEqual(object["escaped"].asString().c_str(), "tab\there");
+		const auto &values{object["values"].asArrayRef()};
+		assertIntEqual(values.size(), 5U);
+		assertIntEqual(values[0].asInt(), 1);
+		assertDoubleEqual(values[1].asFloat(), 2.5);
+		assertTrue(values[2].asBool());
+		assertTrue(values[3].isNull());
+		assertStringEqual(values[4][size_t{0U}].asString().c_str(), "x");
+		assertIntEqual(values[4][size_t{1U}].asObjectRef().size(), 0U);
+		assertStringEqual(object["nested"]["deeper"]["key"].asString().c_str(), "value");
+	};
+
+	auto document{parseJSONArena(json)};
+	check(*document);
+	// A document parsed into an arena can still be modified like any other
+	auto &object{document->asObjectRef()};
+	object["nested"].asObjectRef().add("added"sv, "a value added after parsing, also long"sv);
+	object["escaped"].asStringRef().set("replaced after parsing with a long string"sv);
+	object.del("values"sv);
+	assertStringEqual(object["nested"]["added"].asString().c_str(), "a value added after parsing, also long");
+	assertStringEqual(object["escaped"].asString().c_str(), "replaced after parsing with a long string");
+	// As can copies of its parts, which outlive it
+	auto nested{std::make_unique<JSONObject>(object["nested"].asObjectRef())};
+	document.reset();
+	assertStringEqual((*nested)["deeper"]["key"].asString().c_str(), "value");
+
+	std::string copy{json};
+	memoryStream_t stream{copy.data(), copy.length() + 1U};
+	check(*parseJSONArena(stream));
+
+	// Documents big enough to need several blocks
+	std::string records{"["};
+	for (size_t i{0U}; i < 20000U; ++i)
+		records += "{\"id\": "s + std::to_string(i) + ", \"label\": \"record number "s + std::to_string(i) + "\"},"s;
+	records.back() = ']';
+	memoryStream_t recordStream{records.data(), records.length() + 1U};
+	auto array{parseJSONArena(recordStream)};
+	assertIntEqual(array->asArrayRef().size(), 20000U);
+	assertStringEqual(array->asArrayRef()[19999]["label"].asString().c_str(), "record number 19999");
+	// Nodes, keys and the structures holding them are all made in the arena, so there is only a
+	// handful of allocations for the whole document rather than several for each value in it
+	const size_t before{allocations};
+	array = parseJSONArena(records);
+	assertTrue(allocations - before < 32U);
+	assertIntEqual(array->asArrayRef().size(), 20000U);
+	// Members added to the document from outside the arena are kept until it goes, even once deleted
+	auto &parsed{array->asArrayRef()};
+	auto &added{parsed[0].asObjectRef().addObject("added"sv)->asObjectRef()};
+	added.add("key"sv, "a value long enough to need storage of its own"sv);
+	parsed[0].asObjectRef().del("added"sv);
+	parsed[1].asObjectRef()["label"].asStringRef().set("a label long enough to need storage"sv);
+	parsed.del(size_t{2U});
+	parsed.add(int64_t{20000});
+	assertIntEqual(parsed.size(), 20000U);
+	assertStringEqual(added["key"].asString().c_str(), "a value long enough to need storage of its own");
+	assertStringEqual(parsed[1]["label"].asString().c_str(), "a label long enough to need storage");
+	array.reset();
+
+	// Keys too long to be held inside a std::string, and the key lists handed out, are freed with the document
+	document = parseJSONArena("{\"a key long enough to need storage of its own\": {\"z\": 1, \"y\": 2, \"x\": 3}, "
+		"\"b\": [{\"another key long enough to need storage\": null}]}"sv);
+	auto &keyed{document->asObjectRef()};
+	assertIntEqual(keyed.keys().size(), 2U);
+	assertStringEqual(keyed.keys()[0], "a key long enough to need storage of its own");
+	const std::string &first{(*keyed.begin()).first};
+	assertStringEqual(first.c_str(), "a key long enough to need storage of its own");
+	auto &ordered{keyed["a key long enough to need storage of its own"].asObjectRef()};
+	assertIntEqual(ordered.keys().size(), 3U);
+	assertStringEqual(ordered.keys()[0], "z");
+	ordered.del("y"sv);
+	ordered.add("w"sv, int64_t{4});
+	assertIntEqual(ordered.keys().size(), 3U);
+	assertStringEqual(ordered.keys()[1], "x");
+	assertStringEqual(ordered.keys()[2], "w");
+	document.reset();
+
+	// Members with the same key as another, whether dropped or replacing the earlier one
+	const auto duplicates{"{\"key\": {\"first\": [1]}, \"key\": {\"second\": [2]}}"sv};
+	parseLimits_t keepLast{};
+	keepLast.duplicateKeys = duplicateKeys_t::keepLast;
+	assertTrue(parseJSONArena(duplicates)->asObjectRef()["key"].asObjectRef().exists("first"sv));
+	assertTrue(parseJSONArena(duplicates, keepLast)->asObjectRef()["key"].asObjectRef().exists("second"sv));
+
+	try
+	{
+		parseJSONArena("{\"a\": [1, 2}"sv);
+		fail("Parsing succeeded on a bad document");
+	}
+	catch (const JSONParserError &error)
+		{ assertTrue(error.errorType() == JSON_PARSER_BAD_JSON); }
+	try
+	{
+		parseLimits_t reject{};
+		reject.duplicateKeys = duplicateKeys_t::reject;
+		parseJSONArena(duplicates, reject);
+		fail("Parsing succeeded on a document with a duplicate key");
+	}
+	catch (const JSONParserError &error)
+		{ assertTrue(error.errorType() == JSON_PARSER_DUPLICATE_KEY); }
+	parseLimits_t limits{1U};
+	try
+	{
+		parseJSONArena(json, limits);
+		fail("Parsing succeeded despite going over a limit");
+	}
+	catch (const JSONParserError &error)
+		{ assertTrue(error.errorType() == JSON_PARSER_TOO_DEEP); }
+}
+
+void testParseContext()
+{
+	parseContext_t context{};
+	const auto message = [](const size_t id)
+	{
+		return "{\"id\": "s + std::to_string(id) + ", \"status\": \"a status long enough to be stored\", "
+			"\"tags\": [\"first\", \"second\"], \"body\": {\"text\": \"message number "s + std::to_string(id) + "\"}}"s;
+	};
+
+	auto document{context.parse(message(0U))};
+	assertIntEqual(document->asObjectRef()["id"].asInt(), 0);
+	const auto *const status{document->asObjectRef()["status"].asStringRef().view().data()};
+	document.reset();
+	// Once the last document is gone, the next is parsed into the same memory
+	for (size_t id{1U}; id < 4U; ++id)
+	{
+		document = context.parse(message(id));
+		const auto &object{document->asObjectRef()};
+		assertIntEqual(object["id"].asInt(), int64_t(id));
+		assertTrue(object["status"].asStringRef().view().data() == status);
+		assertStringEqual(object["body"]["text"].asString().c_str(), ("message number "s + std::to_string(id)).c_str());
+		document.reset();
+	}
+	// But not while a document parsed earlier is still alive
+	auto first{context.parse(message(4U))};
+	auto second{context.parse(message(5U))};
+	assertTrue(second->asObjectRef()["status"].asStringRef().view().data() !=
+		first->asObjectRef()["status"].asStringRef().view().data());
+	assertIntEqual(first->asObjectRef()["id"].asInt(), 4);
+	assertIntEqual(second->asObjectRef()["id"].asInt(), 5);
+	first.reset();
+	second.reset();
+
+	// Streams, and documents big enough to be indexed, reuse their buffers too
+	std::string records{"["};
+	for (size_t i{0U}; i < 100U; ++i)
+		records += message(i) + ","s;
+	records.back() = ']';
+	for (size_t i{0U}; i < 3U; ++i)
+	{
+		memoryStream_t stream{records.data(), records.length() + 1U};
+		assertIntEqual(context.parse(stream)->asArrayRef().size(), 100U);
+		const auto array{context.parse(records)};
+		assertIntEqual(array->asArrayRef()[99U]["body"]["text"].asStringRef().len(), 17U);
+	}
+
+	// Once the context has parsed documents like these, parsing more of them allocates nothing but each
+	// document's root node
+	const auto single{message(7U)};
+	const auto parseAll = [&]()
+	{
+		assertIntEqual(context.parse(single)->asObjectRef()["id"].asInt(), 7);
+		memoryStream_t stream{records.data(), records.length() + 1U};
+		assertIntEqual(context.parse(stream)->asArrayRef().size(), 100U);
+		assertIntEqual(context.parse(records)->asArrayRef()[99U]["tags"].asArrayRef().size(), 2U);
+	};
+	parseAll();
+	const size_t before{allocations};
+	for (size_t i{0U}; i < 3U; ++i)
+		parseAll();
+	assertIntEqual(allocations - before, 9U);
+
+	// A failed parse leaves the context fit to use again
+	try
+	{
+		auto bad{context.parse("{\"a\": [1, 2}"sv)};
+		fail("Parsing succeeded on a bad document");
+	}
+	catch (const JSONParserError &error)
+		{ assertTrue(error.errorType() == JSON_PARSER_BAD_JSON); }
+	std::string bad{"[1, 2"};
+	memoryStream_t badStream{bad.data(), bad.length() + 1U};
+	try
+	{
+		auto badDocument{context.parse(badStream)};
+		fail("Parsing succeeded on a truncated document");
+	}
+	catch (const JSONParserError &error)
+		{ assertTrue(error.errorType() == JSON_PARSER_EOF); }
+	assertIntEqual(context.parse(message(6U))->asObjectRef()["id"].asInt(), 6);
+	memoryStream_t stream{records.data(), records.length() + 1U};
+	assertIntEqual(context.parse(stream)->asArrayRef().size(), 100U);
+
+	// Including when the stream has nothing in it at all, which must still be synced
+	struct emptyStream_t final : public stream_t
+	{
+		size_t syncs{0U};
+		bool read(void *const, const size_t, size_t &actualLen) final { actualLen = 0U; return true; }
+		bool atEOF() const noexcept final { return true; }
+		void readSync() noexcept final { ++syncs; }
+	} emptyStream{};
+	try
+	{
+		auto empty{context.parse(emptyStream)};
+		fail("Parsing succeeded on an empty stream");
+	}
+	catch (const JSONParserError &error)
+		{ assertTrue(error.errorType() == JSON_PARSER_EOF); }
+	assertIntEqual(emptyStream.syncs, 1U);
+	memoryStream_t again{records.data(), records.length() + 1U};
+	assertIntEqual(context.parse(again)->asArrayRef().size(), 100U);
+}
+
+void testStringDecoding()
+{
+	TRY("[\"te\\nst\", \"\\u2200\\u00e9\", \"\\uD83D\\uDE00!\", \"\\uDBFF\\u0041\", \"\\u0000\"]"sv,
+		const JSONArray &array{*atom};
+		assertStringEqual(array[0].asString().c_str(), "te\nst");
+		assertStringEqual(array[1].asString().c_str(), "\xE2\x88\x80\xC3\xA9");
+		assertStringEqual(array[2].asString().c_str(), "\xF0\x9F\x98\x80!");
+		assertStringEqual(array[3].asString().c_str(), "\xED\xAF\xBF" "A");
+		assertStringEqual(array[4].asString().c_str(), "\xC0\x80");
+	);
+	TRY_SHOULD_FAIL("[\"\\uD83D\\x\"]"sv);
+	TRY_SHOULD_FAIL("[\"\\u00\"]"sv);
+
+	// An unpaired high surrogate at the end of a string is kept, whether parsing from memory or a stream
+	for (const auto json : {"[\"\\uD800\"]"sv, "[\"x\\uD800\"]"sv})
+	{
+		const auto expected{json[2] == 'x' ? "x\xED\xA0\x80"sv : "\xED\xA0\x80"sv};
+		TRY(json, assertTrue(atom->asArrayRef()[0].asStringRef().view() == expected));
+		std::string copy{json};
+		memoryStream_t stream{copy.data(), copy.length() + 1U};
+		TRY(stream, assertTrue(atom->asArrayRef()[0].asStringRef().view() == expected));
+	}
+	// Keys are kept as written, so nothing is added for an unpaired high surrogate in one
+	for (const auto json : {"{\"\\uD800x\": 1}"sv, "{\"\\uD800\": 1}"sv})
+	{
+		const auto expected{json.substr(2U, json.find('"', 2U) - 2U)};
+		TRY(json, assertTrue(atom->asObjectRef().keys()[0] == expected));
+		std::string copy{json};
+		memoryStream_t stream{copy.data(), copy.length() + 1U};
+		TRY(stream, assertTrue(atom->asObjectRef().keys()[0] == expected));
+	}
+
+	// Put a surrogate pair across the boundary between two of the parser's input blocks
+	for (const size_t offset : {32767U, 32764U, 32761U, 32758U})
+	{
+		std::string json{"[\"" + std::string(offset - 2U, 'x') + "\\uD83D\\uDE00\"]"};
+		memoryStream_t stream{json.data(), json.size() + 1U};
+		JSONParser parser{stream};
+		try
+		{
+			auto atom{array(parser)};
+			const auto &value{atom->asArrayRef()[0].asStringRef()};
+			assertIntEqual(value.len(), offset + 2U);
+			assertTrue(value.view().substr(offset - 2U) == "\xF0\x9F\x98\x80");
+		}
+		catch (const JSONParserError &err)
+			{ fail(err.error()); }
+	}
+}
+
 #undef TRY
 #undef TRY_SHOULD_FAIL
 #pragma GCC diagnostic push
@@ -521,6 +2450,36 @@ void testParseJSONFile()
 	catch (JSONParserError &err) { fail(err.error()); }
 	catch (JSONTypeError &err) { fail(err.error()); }
 
+	// Files large enough to be mapped into memory rather than read through
+	std::string records{"[\n"};
+	for (size_t i{0U}; i < 20000U; ++i)
+		records += "\t{\"id\": "s + std::to_string(i) + ", \"name\": \"a record with a name in it\"},\n"s;
+	records.replace(records.length() - 2U, 2U, "\n]");
+	[&]()
+	{
+		fd_t file{"test.json", O_WRONLY | O_CREAT | O_TRUNC | O_NOCTTY, substrate::normalMode};
+		assertTrue(file.valid());
+		assertTrue(file.write(records));
+	}();
+	const auto atom{parseJSON(std::filesystem::path{"test.json"})};
+	assertIntEqual(atom->asArrayRef().size(), 20000U);
+	assertIntEqual(atom->asArrayRef()[19999U]["id"].asInt(), 19999);
+	assertStringEqual(atom->asArrayRef()[19999U]["name"].asString().c_str(), "a record with a name in it");
+	[&]()
+	{
+		fd_t file{"test.json", O_WRONLY | O_TRUNC | O_NOCTTY, substrate::normalMode};
+		assertTrue(file.valid());
+		assertTrue(file.write(records.substr(0U, records.length() - 1U)));
+	}();
+	try
+	{
+		const auto truncated{parseJSON(std::filesystem::path{"test.json"})};
+		fail("Parsing succeeded on a truncated file");
+	}
+	catch (const JSONParserError &err)
+		{ assertTrue(err.errorType() == JSON_PARSER_EOF); }
+	assertIntEqual(parseJSON(std::filesystem::path{"../compile_commands.json"})->getType(), JSON_TYPE_ARRAY);
+
 	unlink("test.json");
 }
 
@@ -533,14 +2492,40 @@ extern "C"
 BEGIN_REGISTER_TESTS()
 	TEST(testParserViability)
 	TEST(testStreamViability)
+	TEST(testStreamBlocks)
+	TEST(testPipelinedMessages)
+	TEST(testNumberBlocks)
+	TEST(testReadAheadStream)
+	TEST(testStructuralIndex)
 	TEST(testPower10)
 	TEST(testLiteral)
 	TEST(testIntNumber)
 	TEST(testFloatNumber)
 	TEST(testString)
+	TEST(testStringDecoding)
 	TEST(testObject)
 	TEST(testArray)
 	TEST(testParseJSON)
+	TEST(testNesting)
+	TEST(testParseLimits)
+	TEST(testDuplicateKeys)
+	TEST(testPushParser)
+	TEST(testEventHandler)
+	TEST(testParseJSONInSitu)
+	TEST(testParseJSONView)
+	TEST(testStringPool)
+	TEST(testParseJSONArena)
+	TEST(testParseContext)
+	TEST(testParseJSONLazy)
+	TEST(testProjection)
+	TEST(testValidation)
+	TEST(testValidationAllocations)
+	TEST(testTryParseJSON)
+	TEST(testDocumentStream)
+	TEST(testArrayStream)
+	TEST(testParseJSONLines)
+	TEST(testParseJSONParallel)
+	TEST(testBinding)
 	TEST(testParseJSONFile)
 END_REGISTER_TESTS()
 }